@@ -158,6 +158,8 @@ typedef struct
   
   uint32_t  xfer_count;     /*!< Partial transfer length in case of multi packet transfer                 */
 
+  uint32_t  xfer_len_db;    /*!< Double buffer: bytes loaded in the PMA and not acknowledged yet          */
+
 }PCD_EPTypeDef;
 
 typedef   USB_TypeDef PCD_TypeDef; 
@@ -103,6 +103,7 @@
   * @{
   */
 static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd);
+static void PCD_EP_DB_LoadTx(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint32_t len);
 void PCD_WritePMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes);
 void PCD_ReadPMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes);
 /**
@@ -733,6 +734,16 @@ HAL_StatusTypeDef HAL_PCD_EP_Open(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint
       PCD_SET_EP_RX_STATUS(hpcd->Instance, ep->num, USB_EP_RX_VALID)
       PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_DIS)
     }
+    else if (ep->type == PCD_EP_TYPE_BULK)
+    {
+      /* Bulk IN: SW_BUF equal to DTOG_TX means no buffer is handed to the peripheral */
+      PCD_CLEAR_RX_DTOG(hpcd->Instance, ep->num)
+      PCD_CLEAR_TX_DTOG(hpcd->Instance, ep->num)
+      ep->xfer_len_db = 0U;
+      /* Configure NAK status for the Endpoint*/
+      PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_NAK)
+      PCD_SET_EP_RX_STATUS(hpcd->Instance, ep->num, USB_EP_RX_DIS)
+    }
     else
     {
       /* Clear the data toggle bits for the endpoint IN/OUT*/
@@ -922,6 +933,13 @@ HAL_StatusTypeDef HAL_PCD_EP_Transmit(PCD_HandleTypeDef *hpcd, uint8_t ep_addr,
     PCD_WritePMA(hpcd->Instance, ep->xfer_buff, ep->pmaadress, len);
     PCD_SET_EP_TX_CNT(hpcd->Instance, ep->num, len);
   }
+  else if (ep->type == PCD_EP_TYPE_BULK)
+  {
+    /*Load one buffer only: a second SW_BUF toggle would bring it back on DTOG_TX and NAK the host,
+      the other buffer is loaded by the CTR_TX handler once this one is acknowledged*/
+    ep->xfer_len_db = 0U;
+    PCD_EP_DB_LoadTx(hpcd, ep, len);
+  }
   else
   {
     /*Write the data to the USB endpoint*/
@@ -1180,6 +1198,36 @@ void PCD_ReadPMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, ui
   }
 }
 
+/**
+  * @brief  Copy the next packet of a bulk IN transfer in the buffer selected by SW_BUF
+  *         and hand it to the peripheral by toggling SW_BUF.
+  * @param  hpcd PCD handle
+  * @param  ep double buffered IN endpoint
+  * @param  len packet length, up to ep->maxpacket
+  * @retval None
+  */
+static void PCD_EP_DB_LoadTx(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint32_t len)
+{
+  uint16_t pmabuffer;
+
+  /* SW_BUF of an IN endpoint is the DTOG_RX bit */
+  if ((PCD_GET_ENDPOINT(hpcd->Instance, ep->num)& USB_EP_DTOG_RX) == USB_EP_DTOG_RX)
+  {
+    PCD_SET_EP_DBUF1_CNT(hpcd->Instance, ep->num, PCD_EP_DBUF_IN, len)
+    pmabuffer = ep->pmaaddr1;
+  }
+  else
+  {
+    PCD_SET_EP_DBUF0_CNT(hpcd->Instance, ep->num, PCD_EP_DBUF_IN, len)
+    pmabuffer = ep->pmaaddr0;
+  }
+
+  PCD_WritePMA(hpcd->Instance, ep->xfer_buff, pmabuffer, len);
+  ep->xfer_buff += len;
+  ep->xfer_len_db += len;
+  PCD_FreeUserBuffer(hpcd->Instance, ep->num, PCD_EP_DBUF_IN)
+}
+
 /**
   * @brief  This function handles PCD Endpoint interrupt request.
   * @param  hpcd PCD handle
@@ -1336,6 +1384,36 @@ static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd)
         /* clear int flag */
         PCD_CLEAR_TX_EP_CTR(hpcd->Instance, EPindex);
         
+        /* Bulk IN double Buffering: hand the next packet in the other buffer, one toggle per acknowledge */
+        if ((ep->doublebuffer != 0U) && (ep->type == PCD_EP_TYPE_BULK))
+        {
+          /* DTOG_TX already moved on, the acknowledged buffer is the other one */
+          if ((PCD_GET_ENDPOINT(hpcd->Instance, ep->num)& USB_EP_DTOG_TX) == USB_EP_DTOG_TX)
+          {
+            count = PCD_GET_EP_DBUF0_CNT(hpcd->Instance, ep->num);
+          }
+          else
+          {
+            count = PCD_GET_EP_DBUF1_CNT(hpcd->Instance, ep->num);
+          }
+          ep->xfer_count += count;
+          ep->xfer_len_db = (ep->xfer_len_db > count) ? (ep->xfer_len_db - count) : 0U;
+
+          if (ep->xfer_len != 0U)
+          {
+            count = (ep->xfer_len > ep->maxpacket) ? ep->maxpacket : ep->xfer_len;
+            ep->xfer_len -= count;
+            PCD_EP_DB_LoadTx(hpcd, ep, count);
+            PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_VALID)
+          }
+          else if (ep->xfer_len_db == 0U)
+          {
+            /* TX COMPLETE */
+            HAL_PCD_DataInStageCallback(hpcd, ep->num);
+          }
+          continue;
+        }
+
         /* IN double Buffering*/
         if (ep->doublebuffer == 0U)
         {
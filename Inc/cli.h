@@ -25,9 +25,22 @@
 
 void    CLI_Init            (void);
 void    CLI_Send            (char *Buf, uint16_t Len);
-void    CLI_Rx              (char *Buf, uint16_t Len);
+bool    CLI_Rx              (char *Buf, uint16_t Len);
+void    CLI_TxCplt          (void);
+void    CLI_TxRestart       (void);
+void    CLI_SetHostConnected(bool Connected);
+void    CLI_ShowUsbStats    (void);
+void    CLI_ShowStack       (void);
+void    CLI_UsbBench        (void);
+void    CLI_EchoStart       (void);
+void    CLI_DataStart       (void);
+void    CLI_Break           (void);
+bool    CLI_TakeBreak       (void);
+void    CLI_Wake            (void);
+bool    CLI_IsTextMode      (void);
 void    CLI_UserConnected   ();
 size_t  CLI_Printf          (const char* pFormat, ...);
+void    CLI_Dump            (uint32_t Offset, const uint8_t* pData, size_t Len);
 
 /* ------------------------------------------------------------------------------------------------------------------*/
 
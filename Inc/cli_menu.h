@@ -22,10 +22,12 @@
 
 /* Global Functions Prototypes --------------------------------------------------------------------------------------*/
 
-void        CLI_MENU_CmdParse       (uint8_t*);
+void        CLI_MENU_Init           (void);
+bool        CLI_MENU_CmdParse       (uint8_t*);
+bool        CLI_MENU_ExecIn         (uint8_t Menu, char *pCmd);
 char       *CLI_MENU_GetMenuStr     (void);
 void        CLI_MENU_GoBack         (void);
-uint8_t     parseDataStr            (char *str);
+uint16_t    parseDataStr            (char *str);
 
 /* ------------------------------------------------------------------------------------------------------------------*/
 
@@ -72,6 +72,7 @@ extern void _Error_Handler(char *, int);
 void MX_CRC_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+uint32_t CRC_Calc(const uint8_t *pData, uint32_t Len);
 
 /* USER CODE END Prototypes */
 
@@ -20,13 +20,21 @@
 
 /* I2C Configuration */
 #define I2C_STACK_SIZE      64  // 256 bytes
-#define I2C_RXQ_SIZE        32
-#define I2C_MAX_NUM_CMD     10
+#define I2C_SCAN_FIRST      0x08    // 7 bits, the reserved addresses are left out as i2cdetect does
+#define I2C_SCAN_LAST       0x77
+#define I2C_SCAN_CLOCKS     100     // SCL periods a probe may take, clock stretching included
+#define I2C_KERNEL_HZ       48000000    // SYSCLK, see SystemClock_Config, the speed presets are built for it
+#define I2C_RISE_NS         200     // Default edges for the speed command, 2.2k pull-ups on a short bus
+#define I2C_FALL_NS         10
+#define I2C_SPEED_MIN_HZ    10000   // The counters reach their end a little lower at 48 MHz
+#define I2C_LIST_RX_SIZE    256     // Bytes read by all the reads of a list command
 
 /* SPI Configuration */
 #define SPI_STACK_SIZE      64  // 256 bytes
-#define SPI_RXQ_SIZE        32
-#define SPI_MAX_NUM_CMD     10
+#define SPI_WRITE_TIMEOUT   50  // ms, a 300 bytes payload takes 2 ms at the 1.5 MHz clock
+
+/* USB Disk Configuration */
+#define USBDISK_STACK_SIZE  64  // 256 bytes, DISK_Flush and the HAL erase
 
 
 /* Global Enum ------------------------------------------------------------------------------------------------------*/
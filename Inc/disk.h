@@ -0,0 +1,60 @@
+/**********************************************************************************************************************
+ * @file    disk.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Internal flash block device shared by FatFs and the USB mass storage interface
+ *********************************************************************************************************************/
+
+#ifndef __DISK_H__
+#define __DISK_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+// Upper half of the 128 KB flash, the linker script keeps the image out of it. 128 sectors is the smallest volume
+// f_mkfs accepts.
+#define DISK_FLASH_BASE         0x08010000U
+#define DISK_FLASH_SIZE         0x00010000U
+#define DISK_SECTOR_SIZE        512U
+#define DISK_SECTOR_COUNT       (DISK_FLASH_SIZE / DISK_SECTOR_SIZE)
+#define DISK_PAGE_SIZE          0x800U  // Flash erase unit
+#define DISK_SECTORS_PER_PAGE   (DISK_PAGE_SIZE / DISK_SECTOR_SIZE)
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+// Only the owner may touch the volume, the other side sees a removed medium
+typedef enum{
+    DISK_OWNER_NONE,
+    DISK_OWNER_FW,
+    DISK_OWNER_HOST,
+}disk_owner_e;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void            DISK_Init           (void);
+bool            DISK_Acquire        (disk_owner_e Owner);
+void            DISK_Release        (disk_owner_e Owner);
+void            DISK_HostAttach     (bool Attached);
+void            DISK_HostDetach     (void);
+disk_owner_e    DISK_GetOwner       (void);
+uint32_t        DISK_GetGeneration  (void);
+const uint8_t  *DISK_MapRead        (uint32_t Sector);
+uint8_t        *DISK_MapWrite       (uint32_t Sector);
+bool            DISK_Read           (uint32_t Sector, uint8_t *pBuff, uint32_t Count);
+bool            DISK_Write          (uint32_t Sector, const uint8_t *pBuff, uint32_t Count);
+bool            DISK_Sync           (void);
+bool            DISK_IsDirty        (void);
+bool            DISK_NeedsFlush     (uint32_t Sector);
+uint8_t        *DISK_LendCache      (void);
+void            DISK_ReturnCache    (void);
+uint32_t        DISK_GetErases      (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__DISK_H__
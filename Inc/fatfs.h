@@ -58,6 +58,7 @@
 #include "user_diskio.h" /* defines USER_Driver as external */
 
 /* USER CODE BEGIN Includes */
+#include "disk.h"
 
 /* USER CODE END Includes */
 
@@ -69,6 +70,8 @@ extern FIL USERFile; /* File object for USER */
 void MX_FATFS_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+FRESULT FATFS_Mount(void);
+void FATFS_Eject(void);
 
 /* USER CODE END Prototypes */
 #ifdef __cplusplus
@@ -0,0 +1,47 @@
+/**********************************************************************************************************************
+ * @file    frame.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   COBS packet framing
+ *********************************************************************************************************************/
+
+#ifndef __FRAME_H__
+#define __FRAME_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define FRAME_DELIMITER             0x00
+#define FRAME_NONE                  (-1)    // No frame ended in the bytes given
+#define FRAME_DROPPED               (-2)    // A frame ended but was too long or cut by a delimiter
+
+// Worst case encoded size of a packet, delimiter included
+#define FRAME_ENCODED_SIZE(Len)     ((Len) + ((Len) / 254) + 2)
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint8_t    *pBuff;
+    uint16_t    Size;
+    uint16_t    Len;        // Decoded bytes of the current frame
+    uint8_t     Left;       // Data bytes left in the current block, 0 when a code byte is expected
+    bool        Zero;       // The current block ends with a zero, written when the next block starts
+    bool        Overflow;   // Current frame is dropped at its delimiter
+}FRAME_Decoder_t;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void        FRAME_DecoderInit   (FRAME_Decoder_t* pDec, uint8_t* pBuff, uint16_t Size);
+uint16_t    FRAME_Decode        (FRAME_Decoder_t* pDec, const uint8_t* pData, uint16_t Len, int32_t* pFrameLen);
+uint16_t    FRAME_Encode        (const uint8_t* pIn, uint16_t Len, uint8_t* pOut, uint16_t OutSize);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__FRAME_H__
@@ -0,0 +1,45 @@
+/**********************************************************************************************************************
+ * @file    histo.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Fixed width histogram for latency measurements
+ *********************************************************************************************************************/
+
+#ifndef __HISTO_H__
+#define __HISTO_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+// Bin i counts the samples in [i * BinWidth, (i+1) * BinWidth), bigger ones only go in Overflow
+typedef struct
+{
+    uint16_t   *pBins;
+    uint16_t    NumBins;
+    uint32_t    BinWidth;
+    uint32_t    Count;
+    uint32_t    Overflow;
+    uint32_t    Min;
+    uint32_t    Max;
+    uint64_t    Sum;
+}HISTO_t;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void        HISTO_Init          (HISTO_t *pHisto, uint16_t *pBins, uint16_t NumBins, uint32_t BinWidth);
+void        HISTO_Reset         (HISTO_t *pHisto);
+void        HISTO_Add           (HISTO_t *pHisto, uint32_t Value);
+uint32_t    HISTO_Percentile    (HISTO_t *pHisto, uint8_t Percent);
+uint32_t    HISTO_Mean          (HISTO_t *pHisto);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__HISTO_H__
@@ -0,0 +1,45 @@
+/**********************************************************************************************************************
+ * @file    history.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Command line history packed in a byte ring
+ *********************************************************************************************************************/
+
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define HIST_MAX_LINE           255     // The length is stored on one byte
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+// Head, Tail and Cursor are free running, Size must be a power of 2
+typedef struct
+{
+    uint8_t    *pBuff;
+    uint16_t    Size;
+    uint16_t    Head;       // End of the newest line
+    uint16_t    Tail;       // Start of the oldest line
+    uint16_t    Cursor;     // Start of the recalled line, Head when not browsing
+    uint16_t    Count;
+}HIST_t;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void        HIST_Init           (HIST_t *pHist, uint8_t *pBuff, uint16_t Size);
+void        HIST_Add            (HIST_t *pHist, const char *pLine, uint16_t Len);
+uint16_t    HIST_Prev           (HIST_t *pHist, char *pOut, uint16_t OutSize);
+uint16_t    HIST_Next           (HIST_t *pHist, char *pOut, uint16_t OutSize);
+void        HIST_Rewind         (HIST_t *pHist);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__HISTORY_H__
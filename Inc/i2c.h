@@ -59,6 +59,7 @@
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
+#include "i2c_dma.h"
 
 /* USER CODE END Includes */
 
@@ -69,9 +70,17 @@
 extern void _Error_Handler(char *, int);
 
 void MX_I2C1_Init       (void);
-bool I2C_Cmd_Write	    (uint8_t* cmd, uint8_t size);
+bool I2C_Cmd_Write	    (uint8_t* cmd, uint16_t size);
+bool I2C_Cmd_Read       (const uint8_t* reg, uint8_t regLen, uint32_t len);
 void I2C_Init		        (void);
-bool I2C_ScanForDevices ();
+bool I2C_ScanForDevices (uint8_t first, uint8_t last, uint16_t clocks);
+bool I2C_ScanIRQ        (void);
+uint32_t I2C_GetBusHz   (void);
+bool I2C_SetSpeed       (const char* name, uint32_t hz, uint16_t riseNs, uint16_t fallNs);
+void I2C_ShowSpeed      (void);
+bool I2C_Cmd_Write_Read (uint8_t* cmd);
+bool I2C_Cmd_List       (I2C_DMA_Op_t* ops, uint8_t count);
+bool I2C_SetAddress     (uint8_t addr);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,77 @@
+/**********************************************************************************************************************
+ * @file    i2c_dma.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   DMA driven I2C1 transfers of any length, and lists of them run from the interrupts
+ *********************************************************************************************************************/
+
+#ifndef __I2C_DMA_H__
+#define __I2C_DMA_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define I2C_DMA_CHUNK_SIZE      128     // Bytes handed to the sink at once, a multiple of the 16 bytes dump line
+#define I2C_DMA_MAX_REG         4       // Register bytes written before a read
+#define I2C_DMA_TIMEOUT_MS      100     // Longest time with no byte moved, clock stretching included
+#define I2C_DMA_MAX_OPS         16      // Operations of a list
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+typedef enum
+{
+    I2C_DMA_OK,
+    I2C_DMA_BUSY,           // Peripheral used by something else
+    I2C_DMA_NACK,           // Address or data byte not acknowledged
+    I2C_DMA_BUS_ERROR,      // Misplaced START or STOP, arbitration lost
+    I2C_DMA_TIMEOUT,        // No byte moved for I2C_DMA_TIMEOUT_MS
+    I2C_DMA_ABORTED,        // Stopped by the sink
+    I2C_DMA_BAD_LIST,       // Empty or too long list, unknown operation, transfer with no byte
+    I2C_DMA_BAD_ARG,        // Register address longer than I2C_DMA_MAX_REG
+}I2C_DMA_Result_e;
+
+typedef enum
+{
+    I2C_DMA_OP_WRITE,       // Len bytes from pData, follows a write to the same address with no START
+    I2C_DMA_OP_READ,        // Len bytes to pData, follows a read from the same address with no START
+    I2C_DMA_OP_RESTART,     // The next transfer starts with a repeated START even if it could follow
+    I2C_DMA_OP_STOP,        // STOP now, else the bus is held until the next transfer or the end of the list
+    I2C_DMA_OP_DELAY,       // Len us, SCL is held low meanwhile unless a STOP came before
+}I2C_DMA_OpType_e;
+
+typedef struct
+{
+    uint8_t     Type;       // I2C_DMA_OpType_e
+    uint8_t     Addr;       // 8 bits slave address of a transfer
+    uint16_t    Len;        // Bytes of a transfer, us of a delay
+    uint8_t*    pData;      // Bytes of a transfer, left untouched until the list is done
+}I2C_DMA_Op_t;
+
+// Takes a received chunk from the calling thread, false stops the transfer
+typedef bool (*I2C_DMA_Sink_t)(const uint8_t* pData, uint16_t Len);
+
+// End of a list, from the interrupts
+typedef void (*I2C_DMA_Done_t)(I2C_DMA_Result_e Result);
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void                I2C_DMA_Init        (void);
+I2C_DMA_Result_e    I2C_DMA_Read        (uint8_t Addr, const uint8_t* pReg, uint8_t RegLen, uint32_t Len,
+                                         I2C_DMA_Sink_t Sink);
+I2C_DMA_Result_e    I2C_DMA_Write       (uint8_t Addr, const uint8_t* pData, uint16_t Len);
+I2C_DMA_Result_e    I2C_DMA_Submit      (const I2C_DMA_Op_t* pOps, uint8_t Count, I2C_DMA_Done_t Done);
+I2C_DMA_Result_e    I2C_DMA_Run         (const I2C_DMA_Op_t* pOps, uint8_t Count);
+const char*         I2C_DMA_ResultName  (I2C_DMA_Result_e Result);
+bool                I2C_DMA_IRQ         (void);
+void                I2C_DMA_ChannelIRQ  (void);
+void                I2C_DMA_TimerIRQ    (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__I2C_DMA_H__
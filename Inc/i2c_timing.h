@@ -0,0 +1,140 @@
+/**********************************************************************************************************************
+ * @file    i2c_timing.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   TIMINGR value of the I2C peripheral for a bus frequency
+ *
+ *          The SCL period is the low and high counts of the prescaled clock, plus the rise and fall times and the
+ *          resync of each edge through the analog filter:
+ *
+ *              tSCL = (SCLL + 1 + SCLH + 1) x tPRESC + tr + tf + 2 x tAF + about 4 x tI2CCLK
+ *
+ *          The prescaler is the smallest one where the counts, the data setup (SCLDEL) and the data hold (SDADEL)
+ *          all fit their fields. The counts are split between low and high in the ratio of the bus minimums of the
+ *          mode, and never go under them, a frequency the rise and fall times leave no room for comes out slower.
+ *
+ *          Every step is a macro of the previous results. I2C_TIMING_PRESET runs them at compile time for the
+ *          presets, I2C_TimingCompute at run time for any other frequency.
+ *********************************************************************************************************************/
+
+#ifndef __I2C_TIMING_H__
+#define __I2C_TIMING_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define I2C_TIMING_PS           1000000000000LL     // Picoseconds per second, every time below is in ps
+#define I2C_TIMING_AF           50000LL             // Analog filter delay, datasheet minimum
+#define I2C_TIMING_SM_HZ        100000              // Standard mode up to this
+#define I2C_TIMING_FM_HZ        400000              // Fast mode up to this, fast mode plus above
+#define I2C_TIMING_FMP_HZ       1000000
+
+// Bus minimums of the mode the frequency falls in
+#define I2C_TIMING_LOW_MIN(Hz)  (((Hz) <= I2C_TIMING_SM_HZ) ? 4700000LL : ((Hz) <= I2C_TIMING_FM_HZ) ? 1300000LL : 500000LL)
+#define I2C_TIMING_HIGH_MIN(Hz) (((Hz) <= I2C_TIMING_SM_HZ) ? 4000000LL : ((Hz) <= I2C_TIMING_FM_HZ) ? 600000LL : 260000LL)
+#define I2C_TIMING_SU_DAT(Hz)   (((Hz) <= I2C_TIMING_SM_HZ) ? 250000LL : ((Hz) <= I2C_TIMING_FM_HZ) ? 100000LL : 50000LL)
+
+#define I2C_TIMING_DIV_UP(A, B)         (((A) + (B) - 1) / (B))
+#define I2C_TIMING_MAX(A, B)            (((A) > (B)) ? (A) : (B))
+#define I2C_TIMING_CLAMP(V, Lo, Hi)     (((V) < (Lo)) ? (Lo) : ((V) > (Hi)) ? (Hi) : (V))
+
+// Kernel clock period
+#define I2C_TIMING_CLK(KernelHz)        (I2C_TIMING_PS / (KernelHz))
+
+// Part of the SCL period made by the counters
+#define I2C_TIMING_COUNTED(Clk, Hz, RiseNs, FallNs) \
+    (I2C_TIMING_PS / (Hz) - ((int64_t)(RiseNs) + (FallNs)) * 1000 - 2 * I2C_TIMING_AF - 4 * (Clk))
+
+// Prescaler plus one, 1 to 16, for 256 counts of low and high, SCLDEL and SDADEL up to 15
+#define I2C_TIMING_DIV(Clk, Counted, Hz, RiseNs, FallNs) \
+    I2C_TIMING_CLAMP(I2C_TIMING_MAX(I2C_TIMING_MAX( \
+        I2C_TIMING_DIV_UP((Counted), 512 * (Clk)), \
+        I2C_TIMING_DIV_UP((int64_t)(RiseNs) * 1000 + I2C_TIMING_SU_DAT(Hz), 16 * (Clk))), \
+        I2C_TIMING_DIV_UP((int64_t)(FallNs) * 1000 - I2C_TIMING_AF - 3 * (Clk), 15 * (Clk))), 1, 16)
+
+// Low and high counts, rounded to the nearest
+#define I2C_TIMING_COUNTS(Counted, Tp)  (((Counted) + (Tp) / 2) / (Tp))
+
+#define I2C_TIMING_LOW(Counts, Tp, Hz) \
+    I2C_TIMING_CLAMP(I2C_TIMING_MAX(I2C_TIMING_DIV_UP(I2C_TIMING_LOW_MIN(Hz), (Tp)), \
+        I2C_TIMING_DIV_UP((Counts) * I2C_TIMING_LOW_MIN(Hz), I2C_TIMING_LOW_MIN(Hz) + I2C_TIMING_HIGH_MIN(Hz))), 1, 256)
+
+#define I2C_TIMING_HIGH(Counts, Low, Tp, Hz) \
+    I2C_TIMING_CLAMP(I2C_TIMING_MAX(I2C_TIMING_DIV_UP(I2C_TIMING_HIGH_MIN(Hz), (Tp)), (Counts) - (Low)), 1, 256)
+
+// Data hold after SCL falls, and data setup before SCL rises
+#define I2C_TIMING_SDADEL(Clk, Tp, FallNs) \
+    I2C_TIMING_CLAMP(I2C_TIMING_DIV_UP((int64_t)(FallNs) * 1000 - I2C_TIMING_AF - 3 * (Clk), (Tp)), 0, 15)
+
+#define I2C_TIMING_SCLDEL(Tp, Hz, RiseNs) \
+    I2C_TIMING_CLAMP(I2C_TIMING_DIV_UP((int64_t)(RiseNs) * 1000 + I2C_TIMING_SU_DAT(Hz), (Tp)) - 1, 0, 15)
+
+#define I2C_TIMING_REG(Div, SclDel, SdaDel, High, Low) \
+    ((uint32_t)(((Div) - 1) << 28) | (uint32_t)((SclDel) << 20) | (uint32_t)((SdaDel) << 16) | \
+     (uint32_t)(((High) - 1) << 8) | (uint32_t)((Low) - 1))
+
+// Steps of a preset as enum constants, I2C_TIMING_VALUE(Name) is then a constant expression for static tables
+#define I2C_TIMING_PRESET(Name, KernelHz, Hz, RiseNs, FallNs) \
+    enum \
+    { \
+        Name##_CLK      = (int)I2C_TIMING_CLK(KernelHz), \
+        Name##_COUNTED  = (int)I2C_TIMING_COUNTED(Name##_CLK, Hz, RiseNs, FallNs), \
+        Name##_DIV      = (int)I2C_TIMING_DIV(Name##_CLK, Name##_COUNTED, Hz, RiseNs, FallNs), \
+        Name##_TP       = Name##_DIV * Name##_CLK, \
+        Name##_COUNTS   = (int)I2C_TIMING_COUNTS(Name##_COUNTED, Name##_TP), \
+        Name##_LOW      = (int)I2C_TIMING_LOW(Name##_COUNTS, Name##_TP, Hz), \
+        Name##_HIGH     = (int)I2C_TIMING_HIGH(Name##_COUNTS, Name##_LOW, Name##_TP, Hz), \
+        Name##_SCLDEL   = (int)I2C_TIMING_SCLDEL(Name##_TP, Hz, RiseNs), \
+        Name##_SDADEL   = (int)I2C_TIMING_SDADEL(Name##_CLK, Name##_TP, FallNs), \
+    }
+
+#define I2C_TIMING_VALUE(Name) \
+    I2C_TIMING_REG(Name##_DIV, Name##_SCLDEL, Name##_SDADEL, Name##_HIGH, Name##_LOW)
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Same steps as I2C_TIMING_PRESET, for any frequency at run time
+  *
+  * @param  KernelHz        I2C kernel clock
+  * @param  Hz              Bus frequency, up to I2C_TIMING_FMP_HZ
+  * @param  RiseNs          SCL and SDA rise time, set by the pull-ups and the bus capacitance
+  * @param  FallNs          Fall time
+  *
+  * @retval uint32_t        TIMINGR value
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static inline uint32_t I2C_TimingCompute(uint32_t KernelHz, uint32_t Hz, uint16_t RiseNs, uint16_t FallNs)
+{
+    int64_t Clk     = I2C_TIMING_CLK(KernelHz);
+    int64_t Counted = I2C_TIMING_COUNTED(Clk, Hz, RiseNs, FallNs);
+    int64_t Div     = I2C_TIMING_DIV(Clk, Counted, Hz, RiseNs, FallNs);
+    int64_t Tp      = Div * Clk;
+    int64_t Counts  = I2C_TIMING_COUNTS(Counted, Tp);
+    int64_t Low     = I2C_TIMING_LOW(Counts, Tp, Hz);
+    int64_t High    = I2C_TIMING_HIGH(Counts, Low, Tp, Hz);
+
+    return I2C_TIMING_REG(Div, I2C_TIMING_SCLDEL(Tp, Hz, RiseNs), I2C_TIMING_SDADEL(Clk, Tp, FallNs), High, Low);
+}
+
+// Bus frequency a TIMINGR value gives with these rise and fall times
+static inline uint32_t I2C_TimingHz(uint32_t KernelHz, uint32_t Timing, uint16_t RiseNs, uint16_t FallNs)
+{
+    int64_t Clk = I2C_TIMING_CLK(KernelHz);
+    int64_t Tp  = (int64_t)((Timing >> 28) + 1) * Clk;
+    int64_t Period;
+
+    Period = (int64_t)(((Timing >> 8) & 0xFF) + 1 + (Timing & 0xFF) + 1) * Tp +
+             ((int64_t)RiseNs + FallNs) * 1000 + 2 * I2C_TIMING_AF + 4 * Clk;
+
+    return (uint32_t)(I2C_TIMING_PS / Period);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__I2C_TIMING_H__
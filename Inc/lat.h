@@ -0,0 +1,44 @@
+/**********************************************************************************************************************
+ * @file    lat.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Per stage latency of the console commands
+ *********************************************************************************************************************/
+
+#ifndef __LAT_H__
+#define __LAT_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+// Points of a command life, in the order they normally come
+typedef enum
+{
+    LAT_MARK_RX,            // CDC packet holding the end of the line received
+    LAT_MARK_PARSE,         // Line handed to the parser
+    LAT_MARK_BUS_START,     // First transfer started
+    LAT_MARK_BUS_DONE,      // Last transfer complete
+    LAT_MARK_OUT,           // Prompt queued, the last byte of the command output
+    LAT_NUM_MARKS,
+}LAT_Mark_e;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void    LAT_Init            (void);
+void    LAT_RxLine          (void);
+void    LAT_Begin           (void);
+void    LAT_SkipLine        (void);
+void    LAT_Mark            (LAT_Mark_e Mark);
+void    LAT_Report          (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__LAT_H__
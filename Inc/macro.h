@@ -0,0 +1,47 @@
+/**********************************************************************************************************************
+ * @file    macro.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Named console command sequences kept on the device
+ *********************************************************************************************************************/
+
+#ifndef __MACRO_H__
+#define __MACRO_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define MACRO_MAX               16
+#define MACRO_NAME_SIZE         12      // Null char included
+#define MACRO_POOL_SIZE         512     // Shared by the bodies of all the macros
+#define MACRO_FILE              "MACROS.TXT"
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+bool        MACRO_Define        (const char* pName, const char* pBody);
+bool        MACRO_Append        (const char* pName, const char* pBody);
+bool        MACRO_Delete        (const char* pName);
+const char* MACRO_Get           (const char* pName, uint16_t* pLen);
+uint8_t     MACRO_GetCount      (void);
+const char* MACRO_GetByIndex    (uint8_t Idx, const char** ppBody, uint16_t* pLen);
+uint16_t    MACRO_GetFree       (void);
+bool        MACRO_RecordStart   (const char* pName);
+void        MACRO_RecordStop    (void);
+const char* MACRO_GetRecording  (void);
+bool        MACRO_RecordCmd     (const char* pCmd);
+void        MACRO_RecordUndo    (void);
+FRESULT     MACRO_Save          (void);
+FRESULT     MACRO_Load          (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__MACRO_H__
@@ -439,7 +439,7 @@
  *   1. Can be disabled if not needed by the application to decrease flash space used.                                *
  *                                                                                                                    *
  **********************************************************************************************************************/
-#define NOS_CONFIG_SIGNAL_ENABLE                    1
+#define NOS_CONFIG_SIGNAL_ENABLE                    0
 
 /**********************************************************************************************************************
  *                                                                                                                    *
@@ -563,7 +563,7 @@
  *   2. Alarm management is dependant from Time module.                                                               *
  *                                                                                                                    *
  **********************************************************************************************************************/
-#define NOS_CONFIG_ALARM_ENABLE                     1
+#define NOS_CONFIG_ALARM_ENABLE                     0
 
 /**********************************************************************************************************************
  *                                                                                                                    *
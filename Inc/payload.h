@@ -0,0 +1,37 @@
+/**********************************************************************************************************************
+ * @file    payload.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Bus payload parser
+ *********************************************************************************************************************/
+
+#ifndef __PAYLOAD_H__
+#define __PAYLOAD_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+typedef enum
+{
+    PAYLOAD_OK,
+    PAYLOAD_ERR_SYNTAX,     // Not a number, bad suffix, unterminated string
+    PAYLOAD_ERR_RANGE,      // Value does not fit the word width
+    PAYLOAD_ERR_FULL,       // Output buffer too small
+}PAYLOAD_Status_e;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+PAYLOAD_Status_e    PAYLOAD_Parse       (const char* pStr, uint8_t* pOut, size_t OutSize, size_t* pLen, size_t* pErrPos);
+const char*         PAYLOAD_StatusStr   (PAYLOAD_Status_e Status);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__PAYLOAD_H__
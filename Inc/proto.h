@@ -0,0 +1,70 @@
+/**********************************************************************************************************************
+ * @file    proto.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Binary command protocol of the console data mode
+ *
+ *          Packets travel COBS framed (see frame.h), multi-byte fields are little endian.
+ *
+ *          Request  : [id] [op] [arguments ...] [CRC-32 of the previous bytes]
+ *          Response : [id] [op] [status] [data ...] [CRC-32 of the previous bytes]
+ *
+ *          The CRC is CRC-32/MPEG-2 (polynomial 0x04C11DB7, init 0xFFFFFFFF, no reflection, no final xor).
+ *********************************************************************************************************************/
+
+#ifndef __PROTO_H__
+#define __PROTO_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define PROTO_MAX_DATA          256     // Largest transfer of one request
+#define PROTO_REQ_HEADER        2       // id, op
+#define PROTO_RSP_HEADER        3       // id, op, status
+#define PROTO_CRC_SIZE          4
+#define PROTO_MAX_PACKET        (PROTO_RSP_HEADER + 1 + PROTO_MAX_DATA + PROTO_CRC_SIZE)
+#define PROTO_CAN_EXT_ID        0x80000000  // Set in a CAN id for an extended frame
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+//  Operation                   Arguments                               Response data
+typedef enum
+{
+    PROTO_OP_PING       = 0x00, // [bytes]                              [same bytes]
+    PROTO_OP_I2C_WRITE  = 0x01, // [addr] [bytes]
+    PROTO_OP_I2C_READ   = 0x02, // [addr] [len:16]                      [len bytes]
+    PROTO_OP_I2C_REG    = 0x03, // [addr] [len:16] [register, 1 or 2]   [len bytes], repeated start after the register
+    PROTO_OP_SPI_XFER   = 0x10, // [bytes]                              [bytes clocked in]
+    PROTO_OP_UART_WRITE = 0x20, // [bytes]
+    PROTO_OP_UART_READ  = 0x21, // [len:16] [timeout ms:16]             [bytes received, may be short on timeout]
+    PROTO_OP_CAN_SEND   = 0x30, // [id:32] [0 to 8 bytes]
+    PROTO_OP_CAN_RECV   = 0x31, // [timeout ms:16]                      [id:32] [0 to 8 bytes]
+    PROTO_OP_EXIT       = 0x7F, //                                      back to the text console after the response
+}PROTO_Op_e;
+
+typedef enum
+{
+    PROTO_OK            = 0,
+    PROTO_ERR_CRC       = 1,    // Answered with the id as received
+    PROTO_ERR_OP        = 2,    // Unknown operation
+    PROTO_ERR_ARG       = 3,    // Missing argument or transfer too long
+    PROTO_ERR_BUS       = 4,    // NACK, bus error
+    PROTO_ERR_TIMEOUT   = 5,
+    PROTO_ERR_BUSY      = 6,    // Peripheral used by something else
+}PROTO_Status_e;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void    PROTO_Start         (void);
+bool    PROTO_Rx            (const uint8_t* pData, uint16_t Len);
+void    PROTO_ShowStats     (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__PROTO_H__
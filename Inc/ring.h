@@ -0,0 +1,44 @@
+/**********************************************************************************************************************
+ * @file    ring.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Single producer / single consumer byte ring
+ *********************************************************************************************************************/
+
+#ifndef __RING_H__
+#define __RING_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+// Head and Tail are free running, Size must be a power of 2
+typedef struct
+{
+    uint8_t            *pBuff;
+    uint16_t            Size;
+    volatile uint16_t   Head;
+    volatile uint16_t   Tail;
+}RING_t;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void        RING_Init           (RING_t *pRing, uint8_t *pBuff, uint16_t Size);
+void        RING_Flush          (RING_t *pRing);
+uint16_t    RING_Count          (RING_t *pRing);
+uint16_t    RING_Free           (RING_t *pRing);
+uint16_t    RING_Write          (RING_t *pRing, const uint8_t *pData, uint16_t Len);
+uint16_t    RING_Read           (RING_t *pRing, uint8_t *pData, uint16_t Len);
+uint16_t    RING_Peek           (RING_t *pRing, uint8_t **ppData);
+void        RING_Skip           (RING_t *pRing, uint16_t Len);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__RING_H__
@@ -0,0 +1,49 @@
+/**********************************************************************************************************************
+ * @file    sched.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Console commands repeated at a fixed period
+ *********************************************************************************************************************/
+
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define SCHED_MAX_JOBS          4
+#define SCHED_CMD_SIZE          64      // Null char included
+#define SCHED_NONE              -1
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+// Counters of a job, times in us
+typedef struct
+{
+    const char* pCmd;
+    uint32_t    PeriodMs;
+    uint32_t    Runs;
+    uint32_t    Overruns;       // Releases dropped because the previous one was not done
+    uint32_t    Errors;         // Runs where the command failed
+    uint32_t    MaxLate;        // Release to start
+    uint32_t    MaxJitter;      // Distance of two starts to the period
+    uint32_t    MaxRun;
+}SCHED_Info_t;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+int8_t      SCHED_Add           (uint32_t PeriodMs, uint8_t Menu, const char* pCmd);
+bool        SCHED_Stop          (uint8_t Id);
+void        SCHED_StopAll       (void);
+bool        SCHED_GetInfo       (uint8_t Id, SCHED_Info_t* pInfo);
+bool        SCHED_Poll          (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__SCHED_H__
@@ -48,6 +48,8 @@
 /* Exported functions ------------------------------------------------------- */
 
 void SysTick_Handler(void);
+void DMA1_Channel2_3_IRQHandler(void);
+void TIM14_IRQHandler(void);
 void I2C1_IRQHandler(void);
 void SPI1_IRQHandler(void);
 void USART1_IRQHandler(void);
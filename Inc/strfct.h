@@ -22,12 +22,18 @@
 
 /* Global Typedef ---------------------------------------------------------------------------------------------------*/
 
+// Output callback of STR_vcbprintf, receives the text in runs that are not null terminated
+typedef void (*STR_Sink_t)(void* pCtx, const char* pData, size_t Len);
+
 /* Global Variables -------------------------------------------------------------------------------------------------*/
 
 /* Global Functions Prototypes --------------------------------------------------------------------------------------*/
 
 size_t	    STR_snprintf		(char* pOut, size_t nSize, const char* pFormat, ...);
 size_t	    STR_vsnprintf		(char* pOut, size_t nSize, const char* pFormat, va_list va);
+size_t      STR_cbprintf        (STR_Sink_t Sink, void* pCtx, const char* pFormat, ...);
+size_t      STR_vcbprintf       (STR_Sink_t Sink, void* pCtx, const char* pFormat, va_list va);
+size_t      STR_HexDump         (STR_Sink_t Sink, void* pCtx, uint32_t Offset, const uint8_t* pData, size_t Len);
 size_t      STR_str2str     	(char* pOut, const char* pString);
 uint8_t     STR_atoh8       	(char hi, char lo);
 void        STR_h8toa       	(char* hi, char* lo, uint8_t Value);
@@ -0,0 +1,33 @@
+/**********************************************************************************************************************
+ * @file    timestamp.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Host correlated time base built on the USB start of frame
+ *********************************************************************************************************************/
+
+#ifndef __TIMESTAMP_H__
+#define __TIMESTAMP_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define TS_FRAME_MASK       0x07FF  // Frame number bits sent by the host in every SOF
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void        TS_SofTick          (uint16_t FrameNumber);
+uint32_t    TS_Get              (void);
+uint64_t    TS_GetUs            (void);
+bool        TS_IsSynced         (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__TIMESTAMP_H__
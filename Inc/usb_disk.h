@@ -0,0 +1,31 @@
+/**********************************************************************************************************************
+ * @file    usb_disk.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Capture volume exposed on the USB mass storage interface
+ *********************************************************************************************************************/
+
+#ifndef __USB_DISK_H__
+#define __USB_DISK_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usbd_composite.h"
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+extern USBD_MSC_StorageTypeDef USBDISK_fops;
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void    USBDISK_Init    (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__USB_DISK_H__
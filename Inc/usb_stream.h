@@ -0,0 +1,36 @@
+/**********************************************************************************************************************
+ * @file    usb_stream.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Raw binary streaming over the vendor bulk interface
+ *********************************************************************************************************************/
+
+#ifndef __USB_STREAM_H__
+#define __USB_STREAM_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usbd_composite.h"
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+extern USBD_VND_ItfTypeDef STREAM_fops;
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+void        STREAM_Init         (void);
+bool        STREAM_IsOpen       (void);
+uint16_t    STREAM_Write        (const uint8_t *pData, uint16_t Len);
+uint16_t    STREAM_Read         (uint8_t *pData, uint16_t Len);
+uint16_t    STREAM_TxFree       (void);
+void        STREAM_ShowStats    (void);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__USB_STREAM_H__
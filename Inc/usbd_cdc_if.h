@@ -134,6 +134,7 @@ extern USBD_CDC_ItfTypeDef USBD_Interface_fops_FS;
 USBD_StatusTypeDef CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+USBD_StatusTypeDef CDC_ReceiveResume_FS(void);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 
@@ -91,11 +91,11 @@
   */
 
 /*---------- -----------*/
-#define USBD_MAX_NUM_INTERFACES     2
+#define USBD_MAX_NUM_INTERFACES     4
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     2
 /*---------- -----------*/
-#define USBD_MAX_STR_DESC_SIZ     512
+#define USBD_MAX_STR_DESC_SIZ     64
 /*---------- -----------*/
 #define USBD_SUPPORT_USER_STRING     0
 /*---------- -----------*/
@@ -104,6 +104,10 @@
 #define USBD_SELF_POWERED     1
 /*---------- -----------*/
 #define MAX_STATIC_ALLOC_SIZE     512
+/*---------- CDC data IN endpoint ping-pongs between two PMA buffers, off until tested on the board -----------*/
+#define USBD_CDC_IN_DBL_BUF     0
+/*---------- Vendor streaming IN endpoint ping-pongs between two PMA buffers, off until tested on the board -----------*/
+#define USBD_VND_IN_DBL_BUF     0
 
 /****************************************/
 /* #define for FS and HS identification */
@@ -0,0 +1,80 @@
+/**********************************************************************************************************************
+ * @file    vm.h
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Stack based bytecode interpreter for bus sequences
+ *********************************************************************************************************************/
+
+#ifndef __VM_H__
+#define __VM_H__
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Global Defines ---------------------------------------------------------------------------------------------------*/
+
+#define VM_STACK_SIZE           16
+#define VM_NUM_VARS             26      // a to z
+#define VM_MAX_NESTING          8       // if/else/then and begin/until nested in each other
+#define VM_MAX_XFER             16      // Bytes of one i2cw
+
+/* Global Typedef ---------------------------------------------------------------------------------------------------*/
+
+typedef enum
+{
+    VM_OK,
+    VM_ERR_SYNTAX,          // Unknown word or bad number
+    VM_ERR_NESTING,         // Unbalanced or too deep if/begin
+    VM_ERR_ARENA,           // Code does not fit in the arena
+    VM_ERR_STACK,           // Stack underflow or overflow
+    VM_ERR_OPCODE,          // Corrupted code
+    VM_ERR_DIV0,
+    VM_ERR_ARG,             // Transfer length out of range
+    VM_ERR_NO_BUS,          // The board does not provide this access
+    VM_ERR_STEPS,           // Step budget used up
+    VM_ERR_ABORT,           // Stopped by the board
+}VM_Status_e;
+
+// Board access used by the bus words, a NULL entry makes its words fail with VM_ERR_NO_BUS. Transfer functions
+// return 0 on success, the value is pushed for the script to test.
+typedef struct
+{
+    int32_t   (*I2CWrite)   (uint8_t Addr, const uint8_t* pData, uint8_t Len);
+    int32_t   (*I2CRead)    (uint8_t Addr, uint8_t* pData, uint8_t Len);
+    int32_t   (*SPIXfer)    (uint8_t* pData, uint8_t Len);
+    int32_t   (*UARTWrite)  (const uint8_t* pData, uint8_t Len);
+    int32_t   (*UARTRead)   (uint8_t* pData, uint32_t TimeoutMs);
+    void      (*DelayMs)    (uint32_t Ms);
+    void      (*DelayUs)    (uint32_t Us);
+    void      (*Print)      (int32_t Value, bool Hex);
+    bool      (*Abort)      (void);
+}VM_Bus_t;
+
+typedef struct
+{
+    uint8_t*    pCode;
+    uint16_t    CodeLen;
+    uint16_t    Pc;
+    uint16_t    ErrPos;     // Source offset of a compile error, code offset of a run time error
+    uint8_t     Sp;
+    int32_t     Stack[VM_STACK_SIZE];
+    int32_t     Vars[VM_NUM_VARS];
+    uint32_t    Steps;
+}VM_t;
+
+/* Global Variables -------------------------------------------------------------------------------------------------*/
+
+/* Global Functions Prototypes --------------------------------------------------------------------------------------*/
+
+VM_Status_e VM_Compile          (VM_t* pVm, const char* pSource, uint16_t SourceLen, uint8_t* pArena, uint16_t ArenaSize);
+VM_Status_e VM_Run              (VM_t* pVm, const VM_Bus_t* pBus, uint32_t MaxSteps);
+const char* VM_StatusStr        (VM_Status_e Status);
+
+// Board glue, vm_board.c
+bool        VM_BOARD_Run        (const char* pSource, uint16_t SourceLen);
+
+/* ------------------------------------------------------------------------------------------------------------------*/
+
+#endif//__VM_H__
@@ -104,13 +104,14 @@ typedef struct _USBD_CDC_Itf
   int8_t (* DeInit)        (void);
   int8_t (* Control)       (uint8_t, uint8_t * , uint16_t);   
   int8_t (* Receive)       (uint8_t *, uint32_t *);  
+  int8_t (* TransmitCplt)  (uint8_t *, uint32_t *, uint8_t);
 
 }USBD_CDC_ItfTypeDef;
 
 
 typedef struct
 {
-  uint32_t data[CDC_DATA_HS_MAX_PACKET_SIZE/4];      /* Force 32bits alignment */
+  uint32_t data[CDC_DATA_FS_MAX_PACKET_SIZE/4];      /* Force 32bits alignment, class requests carry 7 bytes at most */
   uint8_t  CmdOpCode;
   uint8_t  CmdLength;    
   uint8_t  *RxBuffer;  
@@ -605,6 +605,12 @@ static uint8_t  USBD_CDC_Setup (USBD_HandleTypeDef *pdev,
   switch (req->bmRequest & USB_REQ_TYPE_MASK)
   {
   case USB_REQ_TYPE_CLASS :
+    if (req->wLength > sizeof(hcdc->data))
+    {
+      USBD_CtlError (pdev, req);
+      return USBD_FAIL;
+    }
+    
     if (req->wLength)
     {
       if (req->bmRequest & 0x80)
@@ -670,6 +676,11 @@ static uint8_t  USBD_CDC_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum)
     
     hcdc->TxState = 0;
 
+    if(((USBD_CDC_ItfTypeDef *)pdev->pUserData)->TransmitCplt != NULL)
+    {
+      ((USBD_CDC_ItfTypeDef *)pdev->pUserData)->TransmitCplt(hcdc->TxBuffer, &hcdc->TxLength, epnum);
+    }
+
     return USBD_OK;
   }
   else
@@ -0,0 +1,195 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite.h
+  * @brief   header file for the usbd_composite.c file.
+  ******************************************************************************
+  */ 
+ 
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USB_COMPOSITE_H
+#define __USB_COMPOSITE_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+#include  "usbd_cdc.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+  
+/** @defgroup usbd_composite
+  * @brief CDC ACM console, a vendor specific bulk interface for raw streaming
+  *        and a mass storage interface for the capture volume
+  * @{
+  */ 
+
+
+/** @defgroup usbd_composite_Exported_Defines
+  * @{
+  */ 
+#define VND_IN_EP                                   0x83  /* EP3 for vendor data IN */
+#define VND_OUT_EP                                  0x03  /* EP3 for vendor data OUT */
+#define VND_DATA_FS_MAX_PACKET_SIZE                 64    /* Endpoint IN & OUT Packet size */
+#define VND_REQ_STREAM                              0x01  /* Vendor request, wValue 1 opens the stream, 0 closes it */
+
+#define MSC_IN_EP                                   0x84  /* EP4 for mass storage data IN */
+#define MSC_OUT_EP                                  0x04  /* EP4 for mass storage data OUT */
+#define MSC_DATA_FS_MAX_PACKET_SIZE                 64    /* Endpoint IN & OUT Packet size */
+#define MSC_REPLY_SIZE                              36    /* Longest reply besides the sectors: INQUIRY */
+
+#define COMPOSITE_CDC_CMD_ITF                       0x00
+#define COMPOSITE_CDC_DATA_ITF                      0x01
+#define COMPOSITE_VND_ITF                           0x02
+#define COMPOSITE_MSC_ITF                           0x03
+#define COMPOSITE_NUM_ITF                           4
+
+/* Configuration (9) + IAD (8) + CDC interfaces (58) + vendor interface (23) + mass storage interface (23) */
+#define USB_COMPOSITE_CONFIG_DESC_SIZ               121
+
+/* Medium state returned by USBD_MSC_StorageTypeDef.IsReady */
+#define USBD_MSC_MEDIUM_READY                       0
+#define USBD_MSC_MEDIUM_CHANGED                     1
+#define USBD_MSC_MEDIUM_ABSENT                      2
+
+/**
+  * @}
+  */ 
+
+
+/** @defgroup USBD_COMPOSITE_Exported_TypesDefinitions
+  * @{
+  */
+
+typedef struct _USBD_VND_Itf
+{
+  int8_t (* Init)          (void);
+  int8_t (* DeInit)        (void);
+  int8_t (* Receive)       (uint8_t *, uint32_t *);  
+  int8_t (* TransmitCplt)  (uint8_t *, uint32_t *, uint8_t);
+  int8_t (* Control)       (uint8_t, uint16_t);
+}USBD_VND_ItfTypeDef;
+
+
+typedef struct
+{
+  uint8_t  RxBuffer[VND_DATA_FS_MAX_PACKET_SIZE];
+  uint8_t  *TxBuffer;   
+  uint32_t RxLength;
+  uint32_t TxLength;    
+  
+  __IO uint32_t TxState;     
+  __IO uint32_t Configured;
+}
+USBD_VND_HandleTypeDef; 
+
+/* Sectors are served in place, the class never copies a block.
+   MapWrite, Sync and Eject may return USBD_BUSY while the storage works in a
+   thread, the class then calls them again on every SOF until they are done */
+typedef struct _USBD_MSC_Storage
+{
+  int8_t    (* Attach)        (uint8_t attached);
+  int8_t    (* IsReady)       (void);
+  int8_t    (* IsWriteProtected) (void);
+  int8_t    (* GetCapacity)   (uint32_t *block_num, uint16_t *block_size);
+  const uint8_t * (* MapRead) (uint32_t blk_addr);
+  int8_t    (* MapWrite)      (uint32_t blk_addr, uint8_t **pblk);
+  int8_t    (* Sync)          (void);
+  int8_t    (* Eject)         (void);
+  const uint8_t *pInquiry;
+}USBD_MSC_StorageTypeDef;
+
+/* Command Block Wrapper, received as is from the OUT endpoint */
+typedef struct
+{
+  uint32_t dSignature;
+  uint32_t dTag;
+  uint32_t dDataLength;
+  uint8_t  bmFlags;
+  uint8_t  bLUN;
+  uint8_t  bCBLength;
+  uint8_t  CB[16];
+}
+USBD_MSC_CBWTypeDef;
+
+/* Command Status Wrapper, sent as is on the IN endpoint */
+typedef struct
+{
+  uint32_t dSignature;
+  uint32_t dTag;
+  uint32_t dDataResidue;
+  uint8_t  bStatus;
+}
+USBD_MSC_CSWTypeDef;
+
+typedef struct
+{
+  USBD_MSC_CBWTypeDef cbw;
+  USBD_MSC_CSWTypeDef csw;
+  uint8_t  Reply[MSC_REPLY_SIZE];
+  uint16_t ReplyLength;
+  
+  uint8_t  State;
+  uint8_t  Status;
+  uint8_t  SenseKey;
+  uint8_t  SenseAsc;
+  
+  uint32_t Block;
+  uint32_t BlockLeft;
+  uint32_t BlockNum;
+  uint16_t BlockSize;
+  
+  uint16_t SyncDelay;
+  uint8_t  SyncPending;
+  uint8_t  Wait;
+  __IO uint32_t Configured;
+}
+USBD_MSC_HandleTypeDef;
+
+/**
+  * @}
+  */ 
+
+/** @defgroup USBD_COMPOSITE_Exported_Variables
+  * @{
+  */ 
+
+extern USBD_ClassTypeDef  USBD_COMPOSITE;
+#define USBD_COMPOSITE_CLASS    &USBD_COMPOSITE
+/**
+  * @}
+  */ 
+
+/** @defgroup USBD_COMPOSITE_Exported_Functions
+  * @{
+  */
+USBD_StatusTypeDef  USBD_VND_RegisterInterface  (USBD_HandleTypeDef   *pdev, 
+                                                 USBD_VND_ItfTypeDef *fops);
+
+USBD_StatusTypeDef  USBD_VND_TransmitPacket     (USBD_HandleTypeDef *pdev,
+                                                 uint8_t  *pbuff,
+                                                 uint32_t length);
+
+USBD_StatusTypeDef  USBD_VND_ReceivePacket      (USBD_HandleTypeDef *pdev);
+
+USBD_StatusTypeDef  USBD_MSC_RegisterStorage    (USBD_HandleTypeDef   *pdev, 
+                                                 USBD_MSC_StorageTypeDef *fops);
+/**
+  * @}
+  */ 
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USB_COMPOSITE_H */
+/**
+  * @}
+  */ 
+
+/**
+  * @}
+  */ 
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc_bot.h
+  * @brief   header file for the usbd_msc_bot.c file, only used by the
+  *          composite class.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_MSC_BOT_H
+#define __USBD_MSC_BOT_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_composite.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup usbd_msc_bot
+  * @brief Bulk-Only Transport and the SCSI commands of a single LUN disk
+  * @{
+  */
+
+
+/** @defgroup usbd_msc_bot_Exported_Functions
+  * @{
+  */
+void     USBD_MSC_Init     (USBD_HandleTypeDef *pdev);
+void     USBD_MSC_DeInit   (USBD_HandleTypeDef *pdev);
+uint8_t  USBD_MSC_Setup    (USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+void     USBD_MSC_DataIn   (USBD_HandleTypeDef *pdev);
+void     USBD_MSC_DataOut  (USBD_HandleTypeDef *pdev);
+void     USBD_MSC_SOF      (USBD_HandleTypeDef *pdev);
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_MSC_BOT_H */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
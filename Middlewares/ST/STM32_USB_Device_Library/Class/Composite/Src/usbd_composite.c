@@ -0,0 +1,600 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite.c
+  * @brief   Composite class: the CDC ACM console, a vendor specific bulk
+  *          interface reserved for raw binary streaming and a mass storage
+  *          interface exposing the capture volume.
+  *
+  *          The CDC part is served by the stock CDC class (interfaces 0 and 1,
+  *          grouped by an IAD) and the mass storage part (interface 3) by
+  *          usbd_msc_bot.c, this file adds interface 2 and routes the setup
+  *          requests and endpoint events to the right owner.
+  *
+  *          ===================================================================
+  *                                Vendor interface
+  *          ===================================================================
+  *           - Interface class 0xFF, a single vendor request without data
+  *             stage: VND_REQ_STREAM, passed to USBD_VND_ItfTypeDef.Control
+  *           - One bulk IN (VND_IN_EP) and one bulk OUT (VND_OUT_EP) endpoint
+  *           - OUT is only re-armed by USBD_VND_ReceivePacket, so the
+  *             application can NAK the host while it has no room
+  *
+  ******************************************************************************
+  */ 
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite.h"
+#include "usbd_msc_bot.h"
+#include "usbd_desc.h"
+#include "usbd_ctlreq.h"
+
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup USBD_COMPOSITE 
+  * @brief usbd core module
+  * @{
+  */ 
+
+/** @defgroup USBD_COMPOSITE_Private_FunctionPrototypes
+  * @{
+  */
+
+
+static uint8_t  USBD_COMPOSITE_Init (USBD_HandleTypeDef *pdev, 
+                                     uint8_t cfgidx);
+
+static uint8_t  USBD_COMPOSITE_DeInit (USBD_HandleTypeDef *pdev, 
+                                       uint8_t cfgidx);
+
+static uint8_t  USBD_COMPOSITE_Setup (USBD_HandleTypeDef *pdev, 
+                                      USBD_SetupReqTypedef *req);
+
+static uint8_t  USBD_COMPOSITE_EP0_RxReady (USBD_HandleTypeDef *pdev);
+
+static uint8_t  USBD_COMPOSITE_DataIn (USBD_HandleTypeDef *pdev, 
+                                       uint8_t epnum);
+
+static uint8_t  USBD_COMPOSITE_DataOut (USBD_HandleTypeDef *pdev, 
+                                        uint8_t epnum);
+
+static uint8_t  USBD_COMPOSITE_SOF (USBD_HandleTypeDef *pdev);
+
+static uint8_t  *USBD_COMPOSITE_GetFSCfgDesc (uint16_t *length);
+
+static uint8_t  *USBD_COMPOSITE_GetDeviceQualifierDescriptor (uint16_t *length);
+
+/**
+  * @}
+  */ 
+
+/** @defgroup USBD_COMPOSITE_Private_Variables
+  * @{
+  */ 
+
+USBD_ClassTypeDef  USBD_COMPOSITE = 
+{
+  USBD_COMPOSITE_Init,
+  USBD_COMPOSITE_DeInit,
+  USBD_COMPOSITE_Setup,
+  NULL,                 /* EP0_TxSent, */
+  USBD_COMPOSITE_EP0_RxReady,
+  USBD_COMPOSITE_DataIn,
+  USBD_COMPOSITE_DataOut,
+  USBD_COMPOSITE_SOF,
+  NULL,
+  NULL,     
+  USBD_COMPOSITE_GetFSCfgDesc,  
+  USBD_COMPOSITE_GetFSCfgDesc,    
+  USBD_COMPOSITE_GetFSCfgDesc, 
+  USBD_COMPOSITE_GetDeviceQualifierDescriptor,
+};
+
+/* The CDC class keeps pdev->pClassData and pdev->pUserData, the vendor interface has its own */
+static USBD_VND_HandleTypeDef   USBD_VND_Handle;
+static USBD_VND_ItfTypeDef      *USBD_VND_fops;
+
+/* USB composite device Configuration Descriptor */
+__ALIGN_BEGIN static uint8_t USBD_COMPOSITE_CfgFSDesc[USB_COMPOSITE_CONFIG_DESC_SIZ] __ALIGN_END =
+{
+  /*Configuration Descriptor*/
+  0x09,   /* bLength: Configuration Descriptor size */
+  USB_DESC_TYPE_CONFIGURATION,      /* bDescriptorType: Configuration */
+  USB_COMPOSITE_CONFIG_DESC_SIZ,    /* wTotalLength:no of returned bytes */
+  0x00,
+  COMPOSITE_NUM_ITF,   /* bNumInterfaces: 4 interface */
+  0x01,   /* bConfigurationValue: Configuration value */
+  0x00,   /* iConfiguration: Index of string descriptor describing the configuration */
+  0xC0,   /* bmAttributes: self powered */
+  0x32,   /* MaxPower 0 mA */
+  
+  /*---------------------------------------------------------------------------*/
+  
+  /*Interface Association Descriptor: CDC function */
+  0x08,   /* bLength: IAD size */
+  0x0B,   /* bDescriptorType: Interface Association */
+  COMPOSITE_CDC_CMD_ITF,   /* bFirstInterface */
+  0x02,   /* bInterfaceCount */
+  0x02,   /* bFunctionClass: Communication Interface Class */
+  0x02,   /* bFunctionSubClass: Abstract Control Model */
+  0x01,   /* bFunctionProtocol: Common AT commands */
+  0x00,   /* iFunction */
+  
+  /*Interface Descriptor */
+  0x09,   /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,  /* bDescriptorType: Interface */
+  /* Interface descriptor type */
+  COMPOSITE_CDC_CMD_ITF,   /* bInterfaceNumber: Number of Interface */
+  0x00,   /* bAlternateSetting: Alternate setting */
+  0x01,   /* bNumEndpoints: One endpoints used */
+  0x02,   /* bInterfaceClass: Communication Interface Class */
+  0x02,   /* bInterfaceSubClass: Abstract Control Model */
+  0x01,   /* bInterfaceProtocol: Common AT commands */
+  0x00,   /* iInterface: */
+  
+  /*Header Functional Descriptor*/
+  0x05,   /* bLength: Endpoint Descriptor size */
+  0x24,   /* bDescriptorType: CS_INTERFACE */
+  0x00,   /* bDescriptorSubtype: Header Func Desc */
+  0x10,   /* bcdCDC: spec release number */
+  0x01,
+  
+  /*Call Management Functional Descriptor*/
+  0x05,   /* bFunctionLength */
+  0x24,   /* bDescriptorType: CS_INTERFACE */
+  0x01,   /* bDescriptorSubtype: Call Management Func Desc */
+  0x00,   /* bmCapabilities: D0+D1 */
+  COMPOSITE_CDC_DATA_ITF,   /* bDataInterface: 1 */
+  
+  /*ACM Functional Descriptor*/
+  0x04,   /* bFunctionLength */
+  0x24,   /* bDescriptorType: CS_INTERFACE */
+  0x02,   /* bDescriptorSubtype: Abstract Control Management desc */
+  0x02,   /* bmCapabilities */
+  
+  /*Union Functional Descriptor*/
+  0x05,   /* bFunctionLength */
+  0x24,   /* bDescriptorType: CS_INTERFACE */
+  0x06,   /* bDescriptorSubtype: Union func desc */
+  COMPOSITE_CDC_CMD_ITF,    /* bMasterInterface: Communication class interface */
+  COMPOSITE_CDC_DATA_ITF,   /* bSlaveInterface0: Data Class Interface */
+  
+  /*Endpoint 2 Descriptor*/
+  0x07,                           /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,   /* bDescriptorType: Endpoint */
+  CDC_CMD_EP,                     /* bEndpointAddress */
+  0x03,                           /* bmAttributes: Interrupt */
+  LOBYTE(CDC_CMD_PACKET_SIZE),     /* wMaxPacketSize: */
+  HIBYTE(CDC_CMD_PACKET_SIZE),
+  0x10,                           /* bInterval: */ 
+  /*---------------------------------------------------------------------------*/
+  
+  /*Data class interface descriptor*/
+  0x09,   /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_INTERFACE,  /* bDescriptorType: */
+  COMPOSITE_CDC_DATA_ITF,   /* bInterfaceNumber: Number of Interface */
+  0x00,   /* bAlternateSetting: Alternate setting */
+  0x02,   /* bNumEndpoints: Two endpoints used */
+  0x0A,   /* bInterfaceClass: CDC */
+  0x00,   /* bInterfaceSubClass: */
+  0x00,   /* bInterfaceProtocol: */
+  0x00,   /* iInterface: */
+  
+  /*Endpoint OUT Descriptor*/
+  0x07,   /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,      /* bDescriptorType: Endpoint */
+  CDC_OUT_EP,                        /* bEndpointAddress */
+  0x02,                              /* bmAttributes: Bulk */
+  LOBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize: */
+  HIBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                              /* bInterval: ignore for Bulk transfer */
+  
+  /*Endpoint IN Descriptor*/
+  0x07,   /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,      /* bDescriptorType: Endpoint */
+  CDC_IN_EP,                         /* bEndpointAddress */
+  0x02,                              /* bmAttributes: Bulk */
+  LOBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize: */
+  HIBYTE(CDC_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                              /* bInterval: ignore for Bulk transfer */
+  /*---------------------------------------------------------------------------*/
+  
+  /*Vendor streaming interface descriptor*/
+  0x09,   /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,  /* bDescriptorType: */
+  COMPOSITE_VND_ITF,   /* bInterfaceNumber: Number of Interface */
+  0x00,   /* bAlternateSetting: Alternate setting */
+  0x02,   /* bNumEndpoints: Two endpoints used */
+  0xFF,   /* bInterfaceClass: Vendor specific */
+  0x00,   /* bInterfaceSubClass: */
+  0x00,   /* bInterfaceProtocol: */
+  0x00,   /* iInterface: */
+  
+  /*Endpoint OUT Descriptor*/
+  0x07,   /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,      /* bDescriptorType: Endpoint */
+  VND_OUT_EP,                        /* bEndpointAddress */
+  0x02,                              /* bmAttributes: Bulk */
+  LOBYTE(VND_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize: */
+  HIBYTE(VND_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                              /* bInterval: ignore for Bulk transfer */
+  
+  /*Endpoint IN Descriptor*/
+  0x07,   /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,      /* bDescriptorType: Endpoint */
+  VND_IN_EP,                         /* bEndpointAddress */
+  0x02,                              /* bmAttributes: Bulk */
+  LOBYTE(VND_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize: */
+  HIBYTE(VND_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                              /* bInterval: ignore for Bulk transfer */
+  /*---------------------------------------------------------------------------*/
+  
+  /*Mass storage interface descriptor*/
+  0x09,   /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,  /* bDescriptorType: */
+  COMPOSITE_MSC_ITF,   /* bInterfaceNumber: Number of Interface */
+  0x00,   /* bAlternateSetting: Alternate setting */
+  0x02,   /* bNumEndpoints: Two endpoints used */
+  0x08,   /* bInterfaceClass: Mass Storage */
+  0x06,   /* bInterfaceSubClass: SCSI transparent */
+  0x50,   /* bInterfaceProtocol: Bulk-Only Transport */
+  0x00,   /* iInterface: */
+  
+  /*Endpoint OUT Descriptor*/
+  0x07,   /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,      /* bDescriptorType: Endpoint */
+  MSC_OUT_EP,                        /* bEndpointAddress */
+  0x02,                              /* bmAttributes: Bulk */
+  LOBYTE(MSC_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize: */
+  HIBYTE(MSC_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                              /* bInterval: ignore for Bulk transfer */
+  
+  /*Endpoint IN Descriptor*/
+  0x07,   /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,      /* bDescriptorType: Endpoint */
+  MSC_IN_EP,                         /* bEndpointAddress */
+  0x02,                              /* bmAttributes: Bulk */
+  LOBYTE(MSC_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize: */
+  HIBYTE(MSC_DATA_FS_MAX_PACKET_SIZE),
+  0x00                               /* bInterval: ignore for Bulk transfer */
+};
+
+/**
+  * @}
+  */ 
+
+/** @defgroup USBD_COMPOSITE_Private_Functions
+  * @{
+  */ 
+
+/**
+  * @brief  USBD_COMPOSITE_Init
+  *         Initialize the CDC, vendor and mass storage interfaces
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t  USBD_COMPOSITE_Init (USBD_HandleTypeDef *pdev, 
+                                     uint8_t cfgidx)
+{
+  uint8_t ret;
+  
+  ret = USBD_CDC.Init(pdev, cfgidx);
+  
+  /* Open EP IN */
+  USBD_LL_OpenEP(pdev,
+                 VND_IN_EP,
+                 USBD_EP_TYPE_BULK,
+                 VND_DATA_FS_MAX_PACKET_SIZE);
+  
+  /* Open EP OUT */
+  USBD_LL_OpenEP(pdev,
+                 VND_OUT_EP,
+                 USBD_EP_TYPE_BULK,
+                 VND_DATA_FS_MAX_PACKET_SIZE);
+  
+  USBD_VND_Handle.TxState = 0;
+  USBD_VND_Handle.Configured = 1;
+  
+  if(USBD_VND_fops != NULL)
+  {
+    USBD_VND_fops->Init();
+  }
+  
+  /* Prepare Out endpoint to receive next packet */
+  USBD_LL_PrepareReceive(pdev,
+                         VND_OUT_EP,
+                         USBD_VND_Handle.RxBuffer,
+                         VND_DATA_FS_MAX_PACKET_SIZE);
+  
+  USBD_MSC_Init(pdev);
+  
+  return ret;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DeInit
+  *         DeInitialize the CDC, vendor and mass storage interfaces
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t  USBD_COMPOSITE_DeInit (USBD_HandleTypeDef *pdev, 
+                                       uint8_t cfgidx)
+{
+  USBD_LL_CloseEP(pdev, VND_IN_EP);
+  USBD_LL_CloseEP(pdev, VND_OUT_EP);
+  
+  if(USBD_VND_Handle.Configured)
+  {
+    USBD_VND_Handle.Configured = 0;
+    if(USBD_VND_fops != NULL)
+    {
+      USBD_VND_fops->DeInit();
+    }
+  }
+  
+  USBD_MSC_DeInit(pdev);
+  
+  return USBD_CDC.DeInit(pdev, cfgidx);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_Setup
+  *         Route the interface and endpoint requests to their owner
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t  USBD_COMPOSITE_Setup (USBD_HandleTypeDef *pdev, 
+                                      USBD_SetupReqTypedef *req)
+{
+  static uint8_t ifalt = 0;
+  
+  switch (req->bmRequest & USB_REQ_RECIPIENT_MASK)
+  {
+  case USB_REQ_RECIPIENT_INTERFACE:
+    if (LOBYTE(req->wIndex) == COMPOSITE_MSC_ITF)
+    {
+      return USBD_MSC_Setup(pdev, req);
+    }
+    
+    if (LOBYTE(req->wIndex) != COMPOSITE_VND_ITF)
+    {
+      return USBD_CDC.Setup(pdev, req);
+    }
+    
+    /* Vendor interface has vendor requests without data stage and a single alternate setting */
+    if (((req->bmRequest & USB_REQ_TYPE_MASK) == USB_REQ_TYPE_STANDARD) &&
+        (req->bRequest == USB_REQ_GET_INTERFACE))
+    {
+      USBD_CtlSendData (pdev, &ifalt, 1);
+    }
+    else if (((req->bmRequest & USB_REQ_TYPE_MASK) == USB_REQ_TYPE_VENDOR) &&
+             (req->wLength == 0) && (USBD_VND_fops != NULL) && (USBD_VND_fops->Control != NULL))
+    {
+      if (USBD_VND_fops->Control(req->bRequest, req->wValue) != USBD_OK)
+      {
+        USBD_CtlError (pdev, req);
+        return USBD_FAIL;
+      }
+    }
+    else if ((req->bmRequest & USB_REQ_TYPE_MASK) != USB_REQ_TYPE_STANDARD)
+    {
+      USBD_CtlError (pdev, req);
+      return USBD_FAIL;
+    }
+    break;
+    
+  case USB_REQ_RECIPIENT_ENDPOINT:
+    if ((LOBYTE(req->wIndex) & 0x7F) == (MSC_IN_EP & 0x7F))
+    {
+      return USBD_MSC_Setup(pdev, req);
+    }
+    
+    /* Halt is handled by the core, nothing to add for the vendor endpoints */
+    if ((LOBYTE(req->wIndex) & 0x7F) != (VND_IN_EP & 0x7F))
+    {
+      return USBD_CDC.Setup(pdev, req);
+    }
+    break;
+    
+  default:
+    return USBD_CDC.Setup(pdev, req);
+  }
+  
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_EP0_RxReady
+  *         Control OUT data stage, only the CDC uses it
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t  USBD_COMPOSITE_EP0_RxReady (USBD_HandleTypeDef *pdev)
+{
+  return USBD_CDC.EP0_RxReady(pdev);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DataIn
+  *         Data sent on non-control IN endpoint
+  * @param  pdev: device instance
+  * @param  epnum: endpoint number
+  * @retval status
+  */
+static uint8_t  USBD_COMPOSITE_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if (epnum == (MSC_IN_EP & 0x7F))
+  {
+    USBD_MSC_DataIn(pdev);
+    return USBD_OK;
+  }
+  
+  if (epnum != (VND_IN_EP & 0x7F))
+  {
+    return USBD_CDC.DataIn(pdev, epnum);
+  }
+  
+  USBD_VND_Handle.TxState = 0;
+  
+  if((USBD_VND_fops != NULL) && (USBD_VND_fops->TransmitCplt != NULL))
+  {
+    USBD_VND_fops->TransmitCplt(USBD_VND_Handle.TxBuffer, &USBD_VND_Handle.TxLength, epnum);
+  }
+  
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DataOut
+  *         Data received on non-control Out endpoint
+  * @param  pdev: device instance
+  * @param  epnum: endpoint number
+  * @retval status
+  */
+static uint8_t  USBD_COMPOSITE_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if (epnum == MSC_OUT_EP)
+  {
+    USBD_MSC_DataOut(pdev);
+    return USBD_OK;
+  }
+  
+  if (epnum != VND_OUT_EP)
+  {
+    return USBD_CDC.DataOut(pdev, epnum);
+  }
+  
+  /* Get the received data length */
+  USBD_VND_Handle.RxLength = USBD_LL_GetRxDataSize (pdev, epnum);
+  
+  /* The endpoint NAKs until the application calls USBD_VND_ReceivePacket */
+  if(USBD_VND_fops != NULL)
+  {
+    USBD_VND_fops->Receive(USBD_VND_Handle.RxBuffer, &USBD_VND_Handle.RxLength);
+  }
+  
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_SOF
+  *         Start of frame, only the mass storage uses it
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t  USBD_COMPOSITE_SOF (USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_SOF(pdev);
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_GetFSCfgDesc 
+  *         Return configuration descriptor, the device only runs at full speed
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t  *USBD_COMPOSITE_GetFSCfgDesc (uint16_t *length)
+{
+  *length = sizeof (USBD_COMPOSITE_CfgFSDesc);
+  return USBD_COMPOSITE_CfgFSDesc;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_GetDeviceQualifierDescriptor 
+  *         return Device Qualifier descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t  *USBD_COMPOSITE_GetDeviceQualifierDescriptor (uint16_t *length)
+{
+  return USBD_CDC.GetDeviceQualifierDescriptor(length);
+}
+
+/**
+  * @brief  USBD_VND_RegisterInterface
+  * @param  pdev: device instance
+  * @param  fops: vendor interface callback
+  * @retval status
+  */
+USBD_StatusTypeDef  USBD_VND_RegisterInterface  (USBD_HandleTypeDef   *pdev, 
+                                                 USBD_VND_ItfTypeDef *fops)
+{
+  if(fops == NULL)
+  {
+    return USBD_FAIL;
+  }
+  
+  USBD_VND_fops = fops;
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_VND_TransmitPacket
+  *         Start an IN transfer on the vendor endpoint
+  * @param  pdev: device instance
+  * @param  pbuff: Tx Buffer, must stay valid until TransmitCplt
+  * @param  length: Tx Buffer length
+  * @retval status
+  */
+USBD_StatusTypeDef  USBD_VND_TransmitPacket(USBD_HandleTypeDef *pdev,
+                                            uint8_t  *pbuff,
+                                            uint32_t length)
+{
+  if((pdev->dev_state != USBD_STATE_CONFIGURED) || !USBD_VND_Handle.Configured)
+  {
+    return USBD_FAIL;
+  }
+  
+  if(USBD_VND_Handle.TxState != 0)
+  {
+    return USBD_BUSY;
+  }
+  
+  /* Tx Transfer in progress */
+  USBD_VND_Handle.TxState = 1;
+  USBD_VND_Handle.TxBuffer = pbuff;
+  USBD_VND_Handle.TxLength = length;
+  
+  USBD_LL_Transmit(pdev, VND_IN_EP, pbuff, length);
+  
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_VND_ReceivePacket
+  *         prepare OUT Endpoint for reception
+  * @param  pdev: device instance
+  * @retval status
+  */
+USBD_StatusTypeDef  USBD_VND_ReceivePacket(USBD_HandleTypeDef *pdev)
+{
+  if((pdev->dev_state != USBD_STATE_CONFIGURED) || !USBD_VND_Handle.Configured)
+  {
+    return USBD_FAIL;
+  }
+  
+  USBD_LL_PrepareReceive(pdev,
+                         VND_OUT_EP,
+                         USBD_VND_Handle.RxBuffer,
+                         VND_DATA_FS_MAX_PACKET_SIZE);
+  return USBD_OK;
+}
+
+/**
+  * @}
+  */ 
+
+/**
+  * @}
+  */ 
+
+/**
+  * @}
+  */ 
@@ -0,0 +1,852 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc_bot.c
+  * @brief   Mass storage interface of the composite class: Bulk-Only
+  *          Transport and the SCSI transparent command set of a single LUN
+  *          disk.
+  *
+  *          ===================================================================
+  *                                Mass storage interface
+  *          ===================================================================
+  *           - Interface class 0x08, subclass 0x06 (SCSI), protocol 0x50 (BOT)
+  *           - One bulk IN (MSC_IN_EP) and one bulk OUT (MSC_OUT_EP) endpoint
+  *           - Sectors are sent from and received into the storage memory
+  *             returned by MapRead/MapWrite, the class has no sector buffer
+  *           - Written data is synced once the host stays quiet for
+  *             MSC_SYNC_DELAY frames, most hosts never send SYNCHRONIZE CACHE
+  *             to a removable disk
+  *           - The storage programs the flash in a thread. While MapWrite,
+  *             Sync or Eject report busy the OUT endpoint is left NAKing or
+  *             the CSW is held back, and the call is retried on every SOF
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_msc_bot.h"
+#include "usbd_ctlreq.h"
+
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup usbd_msc_bot
+  * @brief usbd core module
+  * @{
+  */
+
+/** @defgroup usbd_msc_bot_Private_Defines
+  * @{
+  */
+#define MSC_BOT_CBW_SIGNATURE             0x43425355U
+#define MSC_BOT_CSW_SIGNATURE             0x53425355U
+#define MSC_BOT_CBW_LENGTH                31U
+#define MSC_BOT_CSW_LENGTH                13U
+
+#define MSC_BOT_GET_MAX_LUN               0xFE
+#define MSC_BOT_RESET                     0xFF
+
+/* BOT state */
+#define MSC_BOT_IDLE                      0     /* Waiting for a CBW */
+#define MSC_BOT_DATA_OUT                  1     /* Receiving WRITE sectors */
+#define MSC_BOT_DATA_IN                   2     /* Sending READ sectors */
+#define MSC_BOT_LAST_DATA_IN              3     /* Sending a short reply */
+#define MSC_BOT_WAIT_OUT                  4     /* Storage busy, the next sector is not armed */
+#define MSC_BOT_WAIT_CSW                  5     /* Storage busy, the CSW waits for the sync */
+
+/* Storage call retried in MSC_BOT_WAIT_CSW */
+#define MSC_WAIT_SYNC                     0
+#define MSC_WAIT_EJECT                    1
+
+/* BOT status */
+#define MSC_BOT_STATUS_NORMAL             0
+#define MSC_BOT_STATUS_RECOVERY           1     /* Reset, no CSW owed */
+#define MSC_BOT_STATUS_ERROR              2     /* Invalid CBW, stall until reset */
+
+#define MSC_CSW_CMD_PASSED                0x00
+#define MSC_CSW_CMD_FAILED                0x01
+
+/* SCSI commands */
+#define SCSI_TEST_UNIT_READY              0x00
+#define SCSI_REQUEST_SENSE                0x03
+#define SCSI_INQUIRY                      0x12
+#define SCSI_MODE_SENSE6                  0x1A
+#define SCSI_START_STOP_UNIT              0x1B
+#define SCSI_ALLOW_MEDIUM_REMOVAL         0x1E
+#define SCSI_READ_FORMAT_CAPACITIES       0x23
+#define SCSI_READ_CAPACITY10              0x25
+#define SCSI_READ10                       0x28
+#define SCSI_WRITE10                      0x2A
+#define SCSI_VERIFY10                     0x2F
+#define SCSI_SYNCHRONIZE_CACHE10          0x35
+#define SCSI_MODE_SENSE10                 0x5A
+
+/* Sense keys and additional sense codes */
+#define SCSI_SENSE_NO_SENSE               0x00
+#define SCSI_SENSE_NOT_READY              0x02
+#define SCSI_SENSE_MEDIUM_ERROR           0x03
+#define SCSI_SENSE_ILLEGAL_REQUEST        0x05
+#define SCSI_SENSE_UNIT_ATTENTION         0x06
+#define SCSI_SENSE_DATA_PROTECT           0x07
+
+#define SCSI_ASC_WRITE_FAULT              0x03
+#define SCSI_ASC_UNRECOVERED_READ_ERROR   0x11
+#define SCSI_ASC_INVALID_OPCODE           0x20
+#define SCSI_ASC_ADDRESS_OUT_OF_RANGE     0x21
+#define SCSI_ASC_INVALID_FIELD_IN_CDB     0x24
+#define SCSI_ASC_WRITE_PROTECTED          0x27
+#define SCSI_ASC_MEDIUM_CHANGED           0x28
+#define SCSI_ASC_MEDIUM_NOT_PRESENT       0x3A
+
+/* Frames without a WRITE before the written sectors are synced */
+#define MSC_SYNC_DELAY                    100
+
+/**
+  * @}
+  */
+
+
+/** @defgroup usbd_msc_bot_Private_FunctionPrototypes
+  * @{
+  */
+static void    MSC_BOT_Abort       (USBD_HandleTypeDef *pdev);
+static void    MSC_BOT_SendCSW     (USBD_HandleTypeDef *pdev, uint8_t status);
+static void    MSC_BOT_CBW_Decode  (USBD_HandleTypeDef *pdev);
+static void    MSC_BOT_Complete    (USBD_HandleTypeDef *pdev, int8_t result);
+static int8_t  MSC_SCSI_Process    (USBD_HandleTypeDef *pdev);
+static int8_t  MSC_SCSI_ReadNext   (USBD_HandleTypeDef *pdev);
+static int8_t  MSC_SCSI_WriteNext  (USBD_HandleTypeDef *pdev);
+static int8_t  MSC_SCSI_Storage    (uint8_t wait);
+/**
+  * @}
+  */
+
+/** @defgroup usbd_msc_bot_Private_Variables
+  * @{
+  */
+static USBD_MSC_HandleTypeDef   USBD_MSC_Handle;
+static USBD_MSC_StorageTypeDef  *USBD_MSC_fops;
+/**
+  * @}
+  */
+
+/** @defgroup usbd_msc_bot_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  MSC_SCSI_Sense
+  *         Latch the sense data returned by the next REQUEST SENSE
+  * @param  key: sense key
+  * @param  asc: additional sense code
+  * @retval -1, so a failing command can return it directly
+  */
+static int8_t MSC_SCSI_Sense(uint8_t key, uint8_t asc)
+{
+  USBD_MSC_Handle.SenseKey = key;
+  USBD_MSC_Handle.SenseAsc = asc;
+  return -1;
+}
+
+/**
+  * @brief  MSC_SCSI_CheckReady
+  *         Fail the command when the firmware owns the medium or when the
+  *         host has not been told yet that it changed
+  * @param  None
+  * @retval 0 if ready, -1 otherwise
+  */
+static int8_t MSC_SCSI_CheckReady(void)
+{
+  switch (USBD_MSC_fops->IsReady())
+  {
+  case USBD_MSC_MEDIUM_READY:
+    return 0;
+
+  case USBD_MSC_MEDIUM_CHANGED:
+    USBD_MSC_fops->GetCapacity(&USBD_MSC_Handle.BlockNum, &USBD_MSC_Handle.BlockSize);
+    return MSC_SCSI_Sense(SCSI_SENSE_UNIT_ATTENTION, SCSI_ASC_MEDIUM_CHANGED);
+
+  default:
+    return MSC_SCSI_Sense(SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+  }
+}
+
+/**
+  * @brief  MSC_SCSI_Reply
+  *         Queue a short reply, cut to the allocation length of the command
+  * @param  pdata: reply, NULL when already in the reply buffer
+  * @param  length: reply length
+  * @param  alloc: allocation length from the CDB
+  * @retval 0
+  */
+static int8_t MSC_SCSI_Reply(const uint8_t *pdata, uint16_t length, uint16_t alloc)
+{
+  uint16_t i;
+
+  if (length > alloc)
+  {
+    length = alloc;
+  }
+
+  if (pdata != NULL)
+  {
+    for (i = 0; i < length; i++)
+    {
+      USBD_MSC_Handle.Reply[i] = pdata[i];
+    }
+  }
+
+  USBD_MSC_Handle.ReplyLength = length;
+  return 0;
+}
+
+/**
+  * @brief  MSC_SCSI_Transfer
+  *         Check and start a READ(10) or WRITE(10)
+  * @param  pdev: device instance
+  * @param  dir_in: 1 for a READ
+  * @retval 0 if started, -1 on error
+  */
+static int8_t MSC_SCSI_Transfer(USBD_HandleTypeDef *pdev, uint8_t dir_in)
+{
+  USBD_MSC_CBWTypeDef *cbw = &USBD_MSC_Handle.cbw;
+  uint32_t blk;
+  uint32_t num;
+
+  if (MSC_SCSI_CheckReady() != 0)
+  {
+    return -1;
+  }
+
+  if (((cbw->bmFlags & 0x80) != 0) != (dir_in != 0))
+  {
+    return MSC_SCSI_Sense(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_FIELD_IN_CDB);
+  }
+
+  if (!dir_in && (USBD_MSC_fops->IsWriteProtected() != 0))
+  {
+    return MSC_SCSI_Sense(SCSI_SENSE_DATA_PROTECT, SCSI_ASC_WRITE_PROTECTED);
+  }
+
+  blk = ((uint32_t)cbw->CB[2] << 24) | ((uint32_t)cbw->CB[3] << 16) |
+        ((uint32_t)cbw->CB[4] << 8)  |  (uint32_t)cbw->CB[5];
+  num = ((uint32_t)cbw->CB[7] << 8)  |  (uint32_t)cbw->CB[8];
+
+  if ((blk >= USBD_MSC_Handle.BlockNum) || (num > (USBD_MSC_Handle.BlockNum - blk)))
+  {
+    return MSC_SCSI_Sense(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_ADDRESS_OUT_OF_RANGE);
+  }
+
+  if (cbw->dDataLength != (num * USBD_MSC_Handle.BlockSize))
+  {
+    return MSC_SCSI_Sense(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_FIELD_IN_CDB);
+  }
+
+  if (num == 0)
+  {
+    return 0;
+  }
+
+  USBD_MSC_Handle.Block = blk;
+  USBD_MSC_Handle.BlockLeft = num;
+
+  if (dir_in)
+  {
+    USBD_MSC_Handle.State = MSC_BOT_DATA_IN;
+    return MSC_SCSI_ReadNext(pdev);
+  }
+
+  return MSC_SCSI_WriteNext(pdev);
+}
+
+/**
+  * @brief  MSC_SCSI_ReadNext
+  *         Send the next sector of a READ straight from the storage
+  * @param  pdev: device instance
+  * @retval 0 if sent, -1 on error
+  */
+static int8_t MSC_SCSI_ReadNext(USBD_HandleTypeDef *pdev)
+{
+  const uint8_t *pblk;
+
+  pblk = USBD_MSC_fops->MapRead(USBD_MSC_Handle.Block);
+  if (pblk == NULL)
+  {
+    return MSC_SCSI_Sense(SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_UNRECOVERED_READ_ERROR);
+  }
+
+  USBD_MSC_Handle.Block++;
+  USBD_MSC_Handle.BlockLeft--;
+  USBD_MSC_Handle.csw.dDataResidue -= USBD_MSC_Handle.BlockSize;
+
+  USBD_LL_Transmit(pdev, MSC_IN_EP, (uint8_t *)pblk, USBD_MSC_Handle.BlockSize);
+  return 0;
+}
+
+/**
+  * @brief  MSC_SCSI_WriteNext
+  *         Receive the next sector of a WRITE straight in the storage, or
+  *         leave the endpoint NAKing while the storage is busy
+  * @param  pdev: device instance
+  * @retval 0 if armed or waiting, -1 on error
+  */
+static int8_t MSC_SCSI_WriteNext(USBD_HandleTypeDef *pdev)
+{
+  uint8_t *pblk;
+  int8_t  ret;
+
+  ret = USBD_MSC_fops->MapWrite(USBD_MSC_Handle.Block, &pblk);
+  if (ret == USBD_BUSY)
+  {
+    USBD_MSC_Handle.State = MSC_BOT_WAIT_OUT;
+    return 0;
+  }
+
+  if (ret != USBD_OK)
+  {
+    return MSC_SCSI_Sense(SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_WRITE_FAULT);
+  }
+
+  USBD_MSC_Handle.State = MSC_BOT_DATA_OUT;
+  USBD_LL_PrepareReceive(pdev, MSC_OUT_EP, pblk, USBD_MSC_Handle.BlockSize);
+  return 0;
+}
+
+/**
+  * @brief  MSC_SCSI_Storage
+  *         Sync or eject the medium, the CSW is held while the storage is busy
+  * @param  wait: MSC_WAIT_SYNC or MSC_WAIT_EJECT
+  * @retval 0 if done or waiting, -1 on error
+  */
+static int8_t MSC_SCSI_Storage(uint8_t wait)
+{
+  int8_t ret;
+
+  ret = (wait == MSC_WAIT_EJECT) ? USBD_MSC_fops->Eject() : USBD_MSC_fops->Sync();
+  if (ret == USBD_BUSY)
+  {
+    USBD_MSC_Handle.Wait = wait;
+    USBD_MSC_Handle.State = MSC_BOT_WAIT_CSW;
+    return 0;
+  }
+
+  if (ret != USBD_OK)
+  {
+    return MSC_SCSI_Sense(SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_WRITE_FAULT);
+  }
+
+  return 0;
+}
+
+/**
+  * @brief  MSC_SCSI_Process
+  *         Execute a SCSI command, short replies are left in the reply buffer
+  * @param  pdev: device instance
+  * @retval 0 if passed, -1 if failed, the sense data tells why
+  */
+static int8_t MSC_SCSI_Process(USBD_HandleTypeDef *pdev)
+{
+  uint8_t  *cb = USBD_MSC_Handle.cbw.CB;
+  uint8_t  *reply = USBD_MSC_Handle.Reply;
+  uint32_t last;
+  uint8_t  wp;
+  uint8_t  i;
+
+  switch (cb[0])
+  {
+  case SCSI_TEST_UNIT_READY:
+    return MSC_SCSI_CheckReady();
+
+  case SCSI_REQUEST_SENSE:
+    for (i = 0; i < 18; i++)
+    {
+      reply[i] = 0;
+    }
+    reply[0]  = 0x70;   /* Current error, fixed format */
+    reply[2]  = USBD_MSC_Handle.SenseKey;
+    reply[7]  = 10;     /* Additional sense length */
+    reply[12] = USBD_MSC_Handle.SenseAsc;
+    USBD_MSC_Handle.SenseKey = SCSI_SENSE_NO_SENSE;
+    USBD_MSC_Handle.SenseAsc = 0;
+    return MSC_SCSI_Reply(NULL, 18, cb[4]);
+
+  case SCSI_INQUIRY:
+    if (cb[1] & 0x01)
+    {
+      /* Vital product data, only the list of supported pages */
+      if (cb[2] != 0x00)
+      {
+        return MSC_SCSI_Sense(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_FIELD_IN_CDB);
+      }
+      reply[0] = 0x00;
+      reply[1] = 0x00;
+      reply[2] = 0x00;
+      reply[3] = 0x01;
+      reply[4] = 0x00;
+      return MSC_SCSI_Reply(NULL, 5, ((uint16_t)cb[3] << 8) | cb[4]);
+    }
+    return MSC_SCSI_Reply(USBD_MSC_fops->pInquiry, MSC_REPLY_SIZE, ((uint16_t)cb[3] << 8) | cb[4]);
+
+  case SCSI_MODE_SENSE6:
+    wp = (USBD_MSC_fops->IsWriteProtected() != 0) ? 0x80 : 0x00;
+    reply[0] = 0x03;    /* Mode data length, no block descriptor nor page */
+    reply[1] = 0x00;
+    reply[2] = wp;
+    reply[3] = 0x00;
+    return MSC_SCSI_Reply(NULL, 4, cb[4]);
+
+  case SCSI_MODE_SENSE10:
+    wp = (USBD_MSC_fops->IsWriteProtected() != 0) ? 0x80 : 0x00;
+    for (i = 0; i < 8; i++)
+    {
+      reply[i] = 0;
+    }
+    reply[1] = 0x06;
+    reply[3] = wp;
+    return MSC_SCSI_Reply(NULL, 8, ((uint16_t)cb[7] << 8) | cb[8]);
+
+  case SCSI_START_STOP_UNIT:
+    /* LoEj set and Start clear: the host is done with the medium */
+    if ((cb[4] & 0x03) == 0x02)
+    {
+      USBD_MSC_Handle.SyncPending = 0;
+      return MSC_SCSI_Storage(MSC_WAIT_EJECT);
+    }
+    return 0;
+
+  case SCSI_ALLOW_MEDIUM_REMOVAL:
+    return 0;
+
+  case SCSI_READ_FORMAT_CAPACITIES:
+    last = USBD_MSC_Handle.BlockNum;
+    for (i = 0; i < 12; i++)
+    {
+      reply[i] = 0;
+    }
+    reply[3]  = 0x08;   /* Capacity list length */
+    reply[4]  = (uint8_t)(last >> 24);
+    reply[5]  = (uint8_t)(last >> 16);
+    reply[6]  = (uint8_t)(last >> 8);
+    reply[7]  = (uint8_t)(last);
+    reply[8]  = (USBD_MSC_fops->IsReady() == USBD_MSC_MEDIUM_ABSENT) ? 0x03 : 0x02;
+    reply[10] = (uint8_t)(USBD_MSC_Handle.BlockSize >> 8);
+    reply[11] = (uint8_t)(USBD_MSC_Handle.BlockSize);
+    return MSC_SCSI_Reply(NULL, 12, ((uint16_t)cb[7] << 8) | cb[8]);
+
+  case SCSI_READ_CAPACITY10:
+    if (MSC_SCSI_CheckReady() != 0)
+    {
+      return -1;
+    }
+    last = USBD_MSC_Handle.BlockNum - 1;
+    reply[0] = (uint8_t)(last >> 24);
+    reply[1] = (uint8_t)(last >> 16);
+    reply[2] = (uint8_t)(last >> 8);
+    reply[3] = (uint8_t)(last);
+    reply[4] = 0;
+    reply[5] = 0;
+    reply[6] = (uint8_t)(USBD_MSC_Handle.BlockSize >> 8);
+    reply[7] = (uint8_t)(USBD_MSC_Handle.BlockSize);
+    return MSC_SCSI_Reply(NULL, 8, 8);
+
+  case SCSI_READ10:
+    return MSC_SCSI_Transfer(pdev, 1);
+
+  case SCSI_WRITE10:
+    return MSC_SCSI_Transfer(pdev, 0);
+
+  case SCSI_VERIFY10:
+    return MSC_SCSI_CheckReady();
+
+  case SCSI_SYNCHRONIZE_CACHE10:
+    if (MSC_SCSI_CheckReady() != 0)
+    {
+      return -1;
+    }
+    USBD_MSC_Handle.SyncPending = 0;
+    return MSC_SCSI_Storage(MSC_WAIT_SYNC);
+
+  default:
+    return MSC_SCSI_Sense(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_OPCODE);
+  }
+}
+
+/**
+  * @brief  MSC_BOT_CBW_Decode
+  *         Check the CBW and run its command
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void MSC_BOT_CBW_Decode(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_CBWTypeDef *cbw = &USBD_MSC_Handle.cbw;
+
+  USBD_MSC_Handle.csw.dTag = cbw->dTag;
+  USBD_MSC_Handle.csw.dDataResidue = cbw->dDataLength;
+  USBD_MSC_Handle.ReplyLength = 0;
+
+  if ((USBD_LL_GetRxDataSize(pdev, MSC_OUT_EP) != MSC_BOT_CBW_LENGTH) ||
+      (cbw->dSignature != MSC_BOT_CBW_SIGNATURE) ||
+      (cbw->bLUN != 0) || (cbw->bCBLength < 1) || (cbw->bCBLength > 16))
+  {
+    MSC_SCSI_Sense(SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_FIELD_IN_CDB);
+    USBD_MSC_Handle.Status = MSC_BOT_STATUS_ERROR;
+    MSC_BOT_Abort(pdev);
+    return;
+  }
+
+  MSC_BOT_Complete(pdev, MSC_SCSI_Process(pdev));
+}
+
+/**
+  * @brief  MSC_BOT_Complete
+  *         Start the reply or the CSW of a command, unless it is still busy
+  * @param  pdev: device instance
+  * @param  result: 0 if the command passed, -1 if it failed
+  * @retval None
+  */
+static void MSC_BOT_Complete(USBD_HandleTypeDef *pdev, int8_t result)
+{
+  USBD_MSC_CBWTypeDef *cbw = &USBD_MSC_Handle.cbw;
+
+  if (result != 0)
+  {
+    USBD_MSC_Handle.State = MSC_BOT_IDLE;
+    if (cbw->dDataLength == 0)
+    {
+      MSC_BOT_SendCSW(pdev, MSC_CSW_CMD_FAILED);
+    }
+    else
+    {
+      MSC_BOT_Abort(pdev);
+    }
+  }
+  else if (USBD_MSC_Handle.State == MSC_BOT_IDLE)
+  {
+    /* Short reply, never more than the host asked for */
+    if (USBD_MSC_Handle.ReplyLength > cbw->dDataLength)
+    {
+      USBD_MSC_Handle.ReplyLength = cbw->dDataLength;
+    }
+
+    if (USBD_MSC_Handle.ReplyLength > 0)
+    {
+      USBD_MSC_Handle.csw.dDataResidue -= USBD_MSC_Handle.ReplyLength;
+      USBD_MSC_Handle.State = MSC_BOT_LAST_DATA_IN;
+      USBD_LL_Transmit(pdev, MSC_IN_EP, USBD_MSC_Handle.Reply, USBD_MSC_Handle.ReplyLength);
+    }
+    else
+    {
+      MSC_BOT_SendCSW(pdev, MSC_CSW_CMD_PASSED);
+    }
+  }
+}
+
+/**
+  * @brief  MSC_BOT_SendCSW
+  *         Send the command status and get ready for the next CBW
+  * @param  pdev: device instance
+  * @param  status: CSW status
+  * @retval None
+  */
+static void MSC_BOT_SendCSW(USBD_HandleTypeDef *pdev, uint8_t status)
+{
+  USBD_MSC_Handle.csw.dSignature = MSC_BOT_CSW_SIGNATURE;
+  USBD_MSC_Handle.csw.bStatus = status;
+  USBD_MSC_Handle.State = MSC_BOT_IDLE;
+
+  USBD_LL_Transmit(pdev, MSC_IN_EP, (uint8_t *)&USBD_MSC_Handle.csw, MSC_BOT_CSW_LENGTH);
+
+  USBD_LL_PrepareReceive(pdev, MSC_OUT_EP, (uint8_t *)&USBD_MSC_Handle.cbw, MSC_BOT_CBW_LENGTH);
+}
+
+/**
+  * @brief  MSC_BOT_Abort
+  *         Stall the data stage, the CSW goes once the host clears the halt
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void MSC_BOT_Abort(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_Handle.State = MSC_BOT_IDLE;
+
+  if ((USBD_MSC_Handle.cbw.bmFlags == 0) &&
+      (USBD_MSC_Handle.cbw.dDataLength != 0) &&
+      (USBD_MSC_Handle.Status == MSC_BOT_STATUS_NORMAL))
+  {
+    USBD_LL_StallEP(pdev, MSC_OUT_EP);
+  }
+  USBD_LL_StallEP(pdev, MSC_IN_EP);
+
+  if (USBD_MSC_Handle.Status == MSC_BOT_STATUS_ERROR)
+  {
+    USBD_LL_PrepareReceive(pdev, MSC_OUT_EP, (uint8_t *)&USBD_MSC_Handle.cbw, MSC_BOT_CBW_LENGTH);
+  }
+}
+
+/**
+  * @}
+  */
+
+/** @defgroup usbd_msc_bot_Exported_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_MSC_Init
+  *         Open the mass storage endpoints and wait for the first CBW
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_MSC_Init(USBD_HandleTypeDef *pdev)
+{
+  USBD_LL_OpenEP(pdev, MSC_IN_EP, USBD_EP_TYPE_BULK, MSC_DATA_FS_MAX_PACKET_SIZE);
+  USBD_LL_OpenEP(pdev, MSC_OUT_EP, USBD_EP_TYPE_BULK, MSC_DATA_FS_MAX_PACKET_SIZE);
+
+  USBD_MSC_Handle.State = MSC_BOT_IDLE;
+  USBD_MSC_Handle.Status = MSC_BOT_STATUS_NORMAL;
+  USBD_MSC_Handle.SenseKey = SCSI_SENSE_NO_SENSE;
+  USBD_MSC_Handle.SenseAsc = 0;
+  USBD_MSC_Handle.SyncPending = 0;
+  USBD_MSC_Handle.BlockNum = 0;
+  USBD_MSC_Handle.BlockSize = 0;
+
+  if (USBD_MSC_fops != NULL)
+  {
+    USBD_MSC_fops->Attach(1);
+    USBD_MSC_fops->GetCapacity(&USBD_MSC_Handle.BlockNum, &USBD_MSC_Handle.BlockSize);
+    USBD_MSC_Handle.Configured = 1;
+
+    USBD_LL_PrepareReceive(pdev, MSC_OUT_EP, (uint8_t *)&USBD_MSC_Handle.cbw, MSC_BOT_CBW_LENGTH);
+  }
+}
+
+/**
+  * @brief  USBD_MSC_DeInit
+  *         Close the endpoints and give the medium back
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_MSC_DeInit(USBD_HandleTypeDef *pdev)
+{
+  USBD_LL_CloseEP(pdev, MSC_IN_EP);
+  USBD_LL_CloseEP(pdev, MSC_OUT_EP);
+
+  if (USBD_MSC_Handle.Configured)
+  {
+    USBD_MSC_Handle.Configured = 0;
+    USBD_MSC_fops->Attach(0);
+  }
+}
+
+/**
+  * @brief  USBD_MSC_Setup
+  *         Handle the mass storage interface and endpoint requests
+  * @param  pdev: device instance
+  * @param  req: usb request
+  * @retval status
+  */
+uint8_t USBD_MSC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  static uint8_t max_lun = 0;
+  static uint8_t ifalt = 0;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+  case USB_REQ_TYPE_CLASS:
+    switch (req->bRequest)
+    {
+    case MSC_BOT_GET_MAX_LUN:
+      if ((req->wValue == 0) && (req->wLength == 1) && ((req->bmRequest & 0x80) == 0x80))
+      {
+        USBD_CtlSendData(pdev, &max_lun, 1);
+        return USBD_OK;
+      }
+      break;
+
+    case MSC_BOT_RESET:
+      if ((req->wValue == 0) && (req->wLength == 0) && ((req->bmRequest & 0x80) != 0x80))
+      {
+        USBD_MSC_Handle.State = MSC_BOT_IDLE;
+        USBD_MSC_Handle.Status = MSC_BOT_STATUS_RECOVERY;
+        USBD_LL_PrepareReceive(pdev, MSC_OUT_EP, (uint8_t *)&USBD_MSC_Handle.cbw, MSC_BOT_CBW_LENGTH);
+        return USBD_OK;
+      }
+      break;
+
+    default:
+      break;
+    }
+
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+
+  case USB_REQ_TYPE_STANDARD:
+    if ((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_INTERFACE)
+    {
+      if (req->bRequest == USB_REQ_GET_INTERFACE)
+      {
+        USBD_CtlSendData(pdev, &ifalt, 1);
+      }
+      return USBD_OK;
+    }
+
+    /* The core already cleared the halt, a stalled data stage now owes its CSW */
+    if ((req->bRequest == USB_REQ_CLEAR_FEATURE) && (req->wValue == USB_FEATURE_EP_HALT))
+    {
+      if (USBD_MSC_Handle.Status == MSC_BOT_STATUS_ERROR)
+      {
+        USBD_LL_StallEP(pdev, MSC_IN_EP);
+        USBD_MSC_Handle.Status = MSC_BOT_STATUS_NORMAL;
+      }
+      else if (((LOBYTE(req->wIndex) & 0x80) == 0x80) &&
+               (USBD_MSC_Handle.Status != MSC_BOT_STATUS_RECOVERY))
+      {
+        MSC_BOT_SendCSW(pdev, MSC_CSW_CMD_FAILED);
+      }
+    }
+    return USBD_OK;
+
+  default:
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+  }
+}
+
+/**
+  * @brief  USBD_MSC_DataIn
+  *         A sector, a short reply or a CSW went out
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_MSC_DataIn(USBD_HandleTypeDef *pdev)
+{
+  switch (USBD_MSC_Handle.State)
+  {
+  case MSC_BOT_DATA_IN:
+    if (USBD_MSC_Handle.BlockLeft == 0)
+    {
+      MSC_BOT_SendCSW(pdev, MSC_CSW_CMD_PASSED);
+    }
+    else if (MSC_SCSI_ReadNext(pdev) != 0)
+    {
+      MSC_BOT_Abort(pdev);
+    }
+    break;
+
+  case MSC_BOT_LAST_DATA_IN:
+    MSC_BOT_SendCSW(pdev, MSC_CSW_CMD_PASSED);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+  * @brief  USBD_MSC_DataOut
+  *         A CBW or a sector came in
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_MSC_DataOut(USBD_HandleTypeDef *pdev)
+{
+  switch (USBD_MSC_Handle.State)
+  {
+  case MSC_BOT_IDLE:
+    USBD_MSC_Handle.Status = MSC_BOT_STATUS_NORMAL;
+    MSC_BOT_CBW_Decode(pdev);
+    break;
+
+  case MSC_BOT_DATA_OUT:
+    USBD_MSC_Handle.Block++;
+    USBD_MSC_Handle.BlockLeft--;
+    USBD_MSC_Handle.csw.dDataResidue -= USBD_MSC_Handle.BlockSize;
+    USBD_MSC_Handle.SyncPending = 1;
+    USBD_MSC_Handle.SyncDelay = 0;
+
+    if (USBD_MSC_Handle.BlockLeft == 0)
+    {
+      MSC_BOT_SendCSW(pdev, MSC_CSW_CMD_PASSED);
+    }
+    else if (MSC_SCSI_WriteNext(pdev) != 0)
+    {
+      MSC_BOT_Abort(pdev);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+  * @brief  USBD_MSC_SOF
+  *         Retry a busy storage call, or sync the written sectors once the
+  *         host went quiet
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_MSC_SOF(USBD_HandleTypeDef *pdev)
+{
+  switch (USBD_MSC_Handle.State)
+  {
+  case MSC_BOT_WAIT_OUT:
+    if (MSC_SCSI_WriteNext(pdev) != 0)
+    {
+      MSC_BOT_Abort(pdev);
+    }
+    break;
+
+  case MSC_BOT_WAIT_CSW:
+    USBD_MSC_Handle.State = MSC_BOT_IDLE;
+    MSC_BOT_Complete(pdev, MSC_SCSI_Storage(USBD_MSC_Handle.Wait));
+    break;
+
+  case MSC_BOT_IDLE:
+    /* Nobody waits for this one, it is only over once the storage is idle */
+    if (USBD_MSC_Handle.SyncPending && (++USBD_MSC_Handle.SyncDelay >= MSC_SYNC_DELAY))
+    {
+      if (USBD_MSC_fops->Sync() != USBD_BUSY)
+      {
+        USBD_MSC_Handle.SyncPending = 0;
+      }
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+  * @brief  USBD_MSC_RegisterStorage
+  * @param  pdev: device instance
+  * @param  fops: storage callback
+  * @retval status
+  */
+USBD_StatusTypeDef  USBD_MSC_RegisterStorage  (USBD_HandleTypeDef   *pdev,
+                                               USBD_MSC_StorageTypeDef *fops)
+{
+  if(fops == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  USBD_MSC_fops = fops;
+  return USBD_OK;
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -13,69 +13,156 @@
 #include "usbd_cdc_if.h"
 #include "strfct.h"
 #include "cli_menu.h"
+#include "ring.h"
+#include "usb_stream.h"
+#include "timestamp.h"
+#include "histo.h"
+#include "sched.h"
+#include "history.h"
+#include "proto.h"
+#include "lat.h"
 
 /* Local Defines ----------------------------------------------------------------------------------------------------*/
 
-#define CLI_STACK_SIZE      128 //512bytes
-#define CLI_RXQ_SIZE        255
-#define CLI_TXQ_SIZE        255
-#define CLI_MAX_CMD_Q       3
+#define CLI_STACK_SIZE      288 //1152bytes, ~1.08K worst path estimated, 'lat' prints the peak use
+#define CLI_STACK_PAINT     0xFFFFFFFFU // Also what nOS fills a stack with in debug builds
+#define CLI_RX_RING_SIZE    256 // Must be a power of 2
+#define CLI_RX_PACKET_SIZE  CDC_DATA_FS_MAX_PACKET_SIZE
+#define CLI_TX_RING_SIZE    512 // Must be a power of 2
+#define CLI_TX_PACKET_SIZE  CDC_DATA_FS_MAX_PACKET_SIZE
+#define CLI_TX_XFER_SIZE    (CLI_TX_PACKET_SIZE * 4) // Packets of one IN transfer are ping-ponged in the PMA
+#define CLI_BENCH_SIZE      65536
+#define CLI_TX_STALL_TIMEOUT 100 // ms without room in the Tx ring before the output is dropped
+
+// What happens to the output while no terminal has the port open (DTR low)
+#define CLI_OFFLINE_DROP        0 // Discarded
+#define CLI_OFFLINE_KEEP_TAIL   1 // The last CLI_TAIL_SIZE bytes are kept and sent on connect
+#define CLI_OFFLINE_POLICY      CLI_OFFLINE_KEEP_TAIL
+#define CLI_TAIL_SIZE           128 // Must be a power of 2
+
+#define CLI_ECHO_SAMPLES    16  // Packets waiting for their echo to be acknowledged, must be a power of 2
+#define CLI_ECHO_BINS       100
+#define CLI_ECHO_BIN_WIDTH  50  // us, latencies above 5 ms only count in the overflow
+#define CLI_BENCH_TIMEOUT   5000 // ms
 #define CLI_MAX_CMD_SIZE    256
-#define CLI_HISTORY_SIZE    10  // 10 x CLI_MAX_CMD_SIZE
+#define CLI_HISTORY_SIZE    256 // Bytes, power of 2, each line takes its length + 2
 
-/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+// Events waking the console task, raised from the USB interrupt
+#define CLI_EVT_RX          0x01 // Bytes waiting in the Rx ring
+#define CLI_EVT_TX          0x02 // IN transfer done, room in the Tx ring (only raised in echo mode)
+#define CLI_EVT_LINE        0x04 // Break, port opened or closed, USB (re)configured
+#define CLI_EVT_SCHED       0x08 // A periodic job is released, raised from the timer thread
+#define CLI_EVT_ALL         (CLI_EVT_RX | CLI_EVT_TX | CLI_EVT_LINE | CLI_EVT_SCHED)
 
-typedef struct{
-    uint8_t cmd;
-    uint8_t dataLen;
-    uint8_t data[CLI_MAX_CMD_SIZE - 2];
-}cmdLayerData_t;
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
 
 typedef enum{
     CLI_MODE,
     DATA_MODE,
+    ECHO_MODE,
 }cli_mode_e;
+
+// End of a received packet, in bytes since the echo started, and its arrival time
+typedef struct{
+    uint32_t rxEnd;
+    uint32_t time;
+}cliEchoSample_t;
 /* Forward Declarations ---------------------------------------------------------------------------------------------*/
 
 static void Send_Prompt (char *menuStr);
 static void CLI_Task    (void *arg);
-
-
-size_t STR_vsnprintf(char* pOut, size_t Size, const char* pFormat, va_list va);
+static void CLI_TxKick  (void);
+static void CLI_RxResume(void);
+static void CLI_BenchFill(void);
+static void CLI_TxOffline(const uint8_t *pData, uint16_t Len);
+static void CLI_TxWrite  (void *pCtx, const char *pData, size_t Len);
+static void CLI_EchoLoop (void);
+static void CLI_EchoStop (void);
+static void CLI_DataLoop (void);
+static void CLI_DataStop (void);
 
 /* Local Constants --------------------------------------------------------------------------------------------------*/
 
+static const char CLI_BenchLine[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n";
+
 /* Local Variables --------------------------------------------------------------------------------------------------*/
 
 nOS_Thread  CLI_Thread;
 nOS_Stack   CLI_Stack[CLI_STACK_SIZE];
-nOS_Queue   CLI_RxQ;
-uint8_t     RxQ_Buff[CLI_RXQ_SIZE];
-nOS_Queue   CLI_TxQ;
-uint8_t     TxQ_Buff[CLI_TXQ_SIZE];
-nOS_Queue   CLI_CmdQ;
-cmdLayerData_t RxCmd_Buff[CLI_MAX_CMD_Q];
+nOS_Flag    CLI_Events;
+RING_t      CLI_RxRing;
+uint8_t     RxRing_Buff[CLI_RX_RING_SIZE];
+volatile bool       CLI_RxPaused;
+volatile uint32_t   CLI_RxBytes;
+volatile uint32_t   CLI_RxPauses;
+RING_t      CLI_TxRing;
+uint8_t     TxRing_Buff[CLI_TX_RING_SIZE];
+volatile bool       CLI_TxBusy;
+volatile bool       CLI_TxZlpPending;
+volatile uint16_t   CLI_TxInFlight;
+volatile uint32_t   CLI_TxBytes;
+volatile uint32_t   CLI_TxPackets;
+volatile uint32_t   CLI_TxDropped;
+volatile bool       CLI_HostConnected;
+volatile bool       CLI_TxWaiting;
+nOS_Mutex   CLI_TxMutex;
+nOS_Sem     CLI_TxSpace;
+#if CLI_OFFLINE_POLICY == CLI_OFFLINE_KEEP_TAIL
+RING_t      CLI_TailRing;
+uint8_t     TailRing_Buff[CLI_TAIL_SIZE];
+#endif
+volatile uint32_t   CLI_BenchLeft;
+uint32_t    CLI_StatsTick;
+uint32_t    CLI_StatsBytes;
+uint32_t    CLI_StatsRxBytes;
 char     	CmdBuilderBuff[CLI_MAX_CMD_SIZE];
 uint16_t    CmdBuilderBuffIdx;
-uint8_t     HistoryBuff[CLI_HISTORY_SIZE][CLI_MAX_CMD_SIZE];
-uint16_t    HistoryBuffCounter;
-uint16_t    HistoryBuffPos;
-uint8_t     TmpCmdBuff[CLI_MAX_CMD_SIZE];
+HIST_t      CLI_History;
+uint8_t     History_Buff[CLI_HISTORY_SIZE];
 cli_mode_e  cliMode;
-char txByte;
+volatile bool       CLI_BreakReq;
+volatile bool       CLI_EchoActive;
+volatile uint32_t   CLI_EchoRxBytes;
+volatile uint32_t   CLI_EchoTxBytes;
+volatile uint32_t   CLI_EchoSkip;
+volatile uint32_t   CLI_EchoStartUs;
+volatile uint32_t   CLI_EchoLastUs;
+volatile uint32_t   CLI_EchoMissed;
+cliEchoSample_t     CLI_EchoSamples[CLI_ECHO_SAMPLES];
+volatile uint8_t    CLI_EchoHead;
+volatile uint8_t    CLI_EchoTail;
+HISTO_t     CLI_EchoHisto;
+uint16_t    EchoHisto_Bins[CLI_ECHO_BINS];
 
 /* Local Functions --------------------------------------------------------------------------------------------------*/
 
 void CLI_Init(void)
 {
-    nOS_QueueCreate(&CLI_RxQ, RxQ_Buff, 1, CLI_RXQ_SIZE);
-    nOS_QueueCreate(&CLI_TxQ, TxQ_Buff, 1, CLI_TXQ_SIZE);
-    nOS_QueueCreate(&CLI_CmdQ, RxCmd_Buff, CLI_RXQ_SIZE, CLI_MAX_CMD_Q);
+    uint16_t i;
+
+    RING_Init(&CLI_RxRing, RxRing_Buff, CLI_RX_RING_SIZE);
+    CLI_RxPaused = false;
+    RING_Init(&CLI_TxRing, TxRing_Buff, CLI_TX_RING_SIZE);
+    CLI_TxBusy = false;
+    CLI_TxZlpPending = false;
+    CLI_TxInFlight = 0;
+#if CLI_OFFLINE_POLICY == CLI_OFFLINE_KEEP_TAIL
+    RING_Init(&CLI_TailRing, TailRing_Buff, CLI_TAIL_SIZE);
+#endif
+    nOS_FlagCreate(&CLI_Events, 0);
+    nOS_MutexCreate(&CLI_TxMutex, NOS_MUTEX_NORMAL, NOS_MUTEX_PRIO_INHERIT);
+    nOS_SemCreate(&CLI_TxSpace, 0, 1);
+    CLI_TxWaiting = false;
+    for(i = 0; i < CLI_STACK_SIZE; i++)
+    {
+        CLI_Stack[i] = CLI_STACK_PAINT;
+    }
     nOS_ThreadCreate(&CLI_Thread, CLI_Task, NULL, CLI_Stack, CLI_STACK_SIZE, 1, "Console Task");
-    HistoryBuffCounter = 0;
-    HistoryBuffPos = 0;
+    HIST_Init(&CLI_History, History_Buff, CLI_HISTORY_SIZE);
+    LAT_Init();
     cliMode = CLI_MODE;
     CmdBuilderBuffIdx = 0;
+    CLI_MENU_Init();
 }
 
 void CLI_Task(void *arg)
@@ -83,41 +170,58 @@ void CLI_Task(void *arg)
     bool charEscaped = false;
     bool specialCommand = false;
     uint8_t rxData;
+    nOS_FlagBits events;
     
     Send_Prompt(CLI_MENU_GetMenuStr());
 
     while(1)
     {
-        // Parse incoming bytes
-        if(!nOS_QueueIsEmpty(&CLI_RxQ))
+        // Sleep until the USB interrupt has something for us, whatever arrives meanwhile stays latched in the flag
+        nOS_FlagWait(&CLI_Events, CLI_EVT_ALL, &events, NOS_FLAG_WAIT_ANY | NOS_FLAG_CLEAR_ON_EXIT, NOS_WAIT_INFINITE);
+
+        if(cliMode == ECHO_MODE)
+        {
+            CLI_EchoLoop();
+        }
+        else if(cliMode == DATA_MODE)
         {
-            nOS_QueueRead(&CLI_RxQ, &rxData, NOS_NO_WAIT);
+            CLI_DataLoop();
+        }
+        // Periodic jobs wait while the loopback or the binary mode owns the pipe, their releases count as overruns
+        else if(SCHED_Poll())
+        {
+            CLI_Send("\r\n", 2);
+            Send_Prompt(CLI_MENU_GetMenuStr());
+            CLI_Send(CmdBuilderBuff, CmdBuilderBuffIdx);
+        }
 
+        // Parse incoming bytes
+        while((cliMode == CLI_MODE) && (RING_Read(&CLI_RxRing, &rxData, 1) == 1))
+        {
             // Enter
             if (rxData == '\r')
             {
                 // Do nothing if nothing has been written
                 if(CmdBuilderBuffIdx > 0)
                 {
-                    nOS_QueueWrite(&CLI_CmdQ, CmdBuilderBuff, NOS_NO_WAIT);
-                    memcpy(&HistoryBuff[HistoryBuffCounter], CmdBuilderBuff, CmdBuilderBuffIdx);
-                    HistoryBuffCounter++;
-                    HistoryBuffCounter %= CLI_HISTORY_SIZE;
-                    CmdBuilderBuffIdx = 0;
-                    memset(CmdBuilderBuff, 0, CLI_MAX_CMD_SIZE);
-                    HistoryBuffPos = HistoryBuffCounter;
+                    // Parsed in place, the parser cuts the line so the builder is only emptied afterwards
+                    HIST_Add(&CLI_History, CmdBuilderBuff, CmdBuilderBuffIdx);
 
-                    // Parse pending command
-                    if(!nOS_QueueIsEmpty(&CLI_CmdQ))
+                    LAT_Begin();
+                    CLI_MENU_CmdParse((uint8_t *)CmdBuilderBuff);
+                    CmdBuilderBuffIdx = 0;
+                    CmdBuilderBuff[0] = 0;
+                    // Loopback or binary mode owns the pipe from here, no prompt
+                    if(cliMode == CLI_MODE)
                     {
-                        nOS_QueueRead(&CLI_CmdQ, TmpCmdBuff, NOS_NO_WAIT);
-                        CLI_MENU_CmdParse(TmpCmdBuff);
                         CLI_Send("\r\n", 2);
-                        Send_Prompt(CLI_MENU_GetMenuStr());;
+                        Send_Prompt(CLI_MENU_GetMenuStr());
+                        LAT_Mark(LAT_MARK_OUT);
                     }
                 }
                 else
                 {
+                    LAT_SkipLine();
                 	CLI_Send("\r\n", 2);
                     Send_Prompt(CLI_MENU_GetMenuStr());
                 }
@@ -162,40 +266,18 @@ void CLI_Task(void *arg)
                     // Arrow up
                     if (rxData == 'A')
                     {
-                        if((HistoryBuffPos-1) == HistoryBuffCounter)
-                        {
-                            CmdBuilderBuffIdx = 0;
-                            memset(CmdBuilderBuff, 0, CLI_MAX_CMD_SIZE);
-                        }
-                        else
-                        {
-                            HistoryBuffPos --;
-                            HistoryBuffPos %= CLI_HISTORY_SIZE;
-                            memcpy(CmdBuilderBuff, &HistoryBuff[HistoryBuffPos], strlen((char*)&HistoryBuff[HistoryBuffPos]));
-                            CmdBuilderBuffIdx = strlen((char*)CmdBuilderBuff);
-
-                        }
-                        CLI_Send("\r", 1);
+                        CmdBuilderBuffIdx = HIST_Prev(&CLI_History, CmdBuilderBuff, CLI_MAX_CMD_SIZE);
+                        CLI_Send("\r\x1b[K", 4);
                         Send_Prompt(CLI_MENU_GetMenuStr());
-                        CLI_Send(CmdBuilderBuff, strlen(CmdBuilderBuff));
-
+                        CLI_Send(CmdBuilderBuff, CmdBuilderBuffIdx);
                     }
                     // Arrow down
                     else if (rxData == 'B')
                     {
-                        if((HistoryBuffPos) == HistoryBuffCounter)
-                        {
-                        }
-                        else
-                        {
-                            HistoryBuffPos ++;
-                            HistoryBuffPos %= CLI_HISTORY_SIZE;
-                            memcpy(CmdBuilderBuff, &HistoryBuff[HistoryBuffPos], strlen((char*)&HistoryBuff[HistoryBuffPos]));
-                            CmdBuilderBuffIdx = strlen((char*)CmdBuilderBuff);
-                        }
-                        CLI_Send("\r", 1);
+                        CmdBuilderBuffIdx = HIST_Next(&CLI_History, CmdBuilderBuff, CLI_MAX_CMD_SIZE);
+                        CLI_Send("\r\x1b[K", 4);
                         Send_Prompt(CLI_MENU_GetMenuStr());
-                        CLI_Send(CmdBuilderBuff, strlen(CmdBuilderBuff));
+                        CLI_Send(CmdBuilderBuff, CmdBuilderBuffIdx);
                     }
 
                     specialCommand = false;
@@ -205,42 +287,369 @@ void CLI_Task(void *arg)
             }
             else
             {
-                CmdBuilderBuff[CmdBuilderBuffIdx] = rxData;
-                CmdBuilderBuffIdx++;
-                // Increment the null char every received byte
-                CmdBuilderBuff[CmdBuilderBuffIdx] = 0;
-                // Echo
-                CLI_Send((char*)&rxData, 1);
+                // Keep room for the null char, extra bytes of a too long line are dropped
+                if(CmdBuilderBuffIdx < (CLI_MAX_CMD_SIZE - 1))
+                {
+                    CmdBuilderBuff[CmdBuilderBuffIdx] = rxData;
+                    CmdBuilderBuffIdx++;
+                    // Increment the null char every received byte
+                    CmdBuilderBuff[CmdBuilderBuffIdx] = 0;
+                    // Echo
+                    CLI_Send((char*)&rxData, 1);
+                }
                 specialCommand = false;
                 charEscaped = false;
             }
         }
+        CLI_RxResume();
+
+        // Transmission is driven by CLI_Send and the completion interrupt, this only restarts it after enumeration
+        CLI_TxKick();
+
+        HAL_GPIO_TogglePin(GPIOC, GPIO_PIN_7);
+    }
+}
+
+// Start the next USB IN transfer from the Tx ring if the endpoint is idle
+static void CLI_TxKick(void)
+{
+    nOS_StatusReg sr;
+    uint8_t *pData;
+    uint16_t len;
+
+    nOS_EnterCritical(sr);
+    if(CLI_HostConnected && !CLI_TxBusy)
+    {
+        len = RING_Peek(&CLI_TxRing, &pData);
+        if(len > CLI_TX_XFER_SIZE)
+        {
+            len = CLI_TX_XFER_SIZE;
+        }
 
-        if(!nOS_QueueIsEmpty(&CLI_TxQ))
+        if((len > 0) || CLI_TxZlpPending)
         {
-            for (int i=0; i<nOS_QueueGetCount(&CLI_TxQ); i++)
+            if(CDC_Transmit_FS(pData, len) == USBD_OK)
             {
-                nOS_QueueRead(&CLI_TxQ, &txByte, NOS_NO_WAIT);
-                while (USBD_OK != CDC_Transmit_FS((char*)&txByte, 1))
-                {
-                }
+                CLI_TxBusy = true;
+                CLI_TxInFlight = len;
+                CLI_TxZlpPending = false;
             }
         }
+    }
+    nOS_LeaveCritical(sr);
+}
 
-        HAL_GPIO_TogglePin(GPIOC, GPIO_PIN_7);
-        nOS_Sleep(10);
+// Copy in the Tx ring, waits for the Tx complete interrupt when it is full. Caller holds CLI_TxMutex when not in an
+// interrupt. Also the sink of CLI_Printf.
+static void CLI_TxWrite(void *pCtx, const char *pData, size_t Len)
+{
+    nOS_StatusReg sr;
+    uint16_t chunk;
+    uint16_t written;
+    uint32_t stallStart;
+
+    (void)pCtx;
+
+    stallStart = HAL_GetTick();
+    while(Len > 0)
+    {
+        chunk = (Len > CLI_TX_RING_SIZE) ? CLI_TX_RING_SIZE : (uint16_t)Len;
+
+        nOS_EnterCritical(sr);
+        if(!CLI_HostConnected)
+        {
+            CLI_TxOffline((const uint8_t*)pData, chunk);
+            written = chunk;
+        }
+        else
+        {
+            written = RING_Write(&CLI_TxRing, (const uint8_t*)pData, chunk);
+            CLI_TxWaiting = (written < chunk);
+        }
+        nOS_LeaveCritical(sr);
+
+        pData += written;
+        Len -= written;
+
+        if(written < chunk)
+        {
+            if(written > 0)
+            {
+                stallStart = HAL_GetTick();
+            }
+
+            // Ring is full, an interrupt can't wait for the host to catch up and a host that stopped reading
+            // must not hold the caller forever
+            if((__get_IPSR() != 0) || ((HAL_GetTick() - stallStart) > CLI_TX_STALL_TIMEOUT))
+            {
+                CLI_TxWaiting = false;
+                CLI_TxDropped += Len;
+                break;
+            }
+
+            CLI_TxKick();
+            nOS_SemTake(&CLI_TxSpace, CLI_TX_STALL_TIMEOUT);
+        }
     }
 }
 
 // Wraper for the USB send command
 void CLI_Send(char *Buf, uint16_t Len)
 {
-    for(int i=0; i<Len; i++)
+    bool isr;
+
+    isr = (__get_IPSR() != 0);
+    if(!isr)
+    {
+        nOS_MutexLock(&CLI_TxMutex, NOS_WAIT_INFINITE);
+    }
+
+    CLI_TxWrite(NULL, Buf, Len);
+    CLI_TxKick();
+
+    if(!isr)
+    {
+        nOS_MutexUnlock(&CLI_TxMutex);
+    }
+}
+
+// Output produced while no terminal is open, called in a critical section
+static void CLI_TxOffline(const uint8_t *pData, uint16_t Len)
+{
+#if CLI_OFFLINE_POLICY == CLI_OFFLINE_KEEP_TAIL
+    uint16_t freeLen;
+
+    // Only the most recent output is kept, the oldest is forgotten to make room
+    if(Len > CLI_TAIL_SIZE)
+    {
+        CLI_TxDropped += Len - CLI_TAIL_SIZE;
+        pData += Len - CLI_TAIL_SIZE;
+        Len = CLI_TAIL_SIZE;
+    }
+
+    freeLen = RING_Free(&CLI_TailRing);
+    if(Len > freeLen)
+    {
+        RING_Skip(&CLI_TailRing, Len - freeLen);
+        CLI_TxDropped += Len - freeLen;
+    }
+    RING_Write(&CLI_TailRing, pData, Len);
+#else
+    CLI_TxDropped += Len;
+#endif
+}
+
+// Terminal opened or closed (DTR) from the USB interrupt, or the device was unconfigured
+void CLI_SetHostConnected(bool Connected)
+{
+#if CLI_OFFLINE_POLICY == CLI_OFFLINE_KEEP_TAIL
+    uint8_t *pData;
+    uint16_t len;
+    uint16_t written;
+#endif
+
+    if(Connected == CLI_HostConnected)
+    {
+        return;
+    }
+    CLI_HostConnected = Connected;
+
+    if(Connected)
+    {
+#if CLI_OFFLINE_POLICY == CLI_OFFLINE_KEEP_TAIL
+        // Send what was printed while nobody was listening ahead of any new output
+        while((len = RING_Peek(&CLI_TailRing, &pData)) > 0)
+        {
+            written = RING_Write(&CLI_TxRing, pData, len);
+            RING_Skip(&CLI_TailRing, written);
+            if(written < len)
+            {
+                break;
+            }
+        }
+        CLI_TxDropped += RING_Count(&CLI_TailRing);
+        RING_Flush(&CLI_TailRing);
+#endif
+        CLI_TxKick();
+    }
+    else if(CLI_TxWaiting)
+    {
+        // Nothing will drain the ring anymore, the writer goes on with the offline path
+        CLI_TxWaiting = false;
+        nOS_SemGive(&CLI_TxSpace);
+    }
+
+    // Lets the echo mode notice the port was closed
+    nOS_FlagSend(&CLI_Events, CLI_EVT_LINE, CLI_EVT_LINE);
+}
+
+// Tx complete from the USB CDC interrupt
+void CLI_TxCplt(void)
+{
+    uint32_t echoed;
+    uint32_t now;
+
+    RING_Skip(&CLI_TxRing, CLI_TxInFlight);
+
+    // Loopback latency: from the packet arrival to the host acknowledging the last byte of its echo
+    if(CLI_EchoActive && (CLI_TxInFlight > 0))
+    {
+        echoed = CLI_TxInFlight;
+        if(CLI_EchoSkip > 0)
+        {
+            echoed -= (CLI_EchoSkip < echoed) ? CLI_EchoSkip : echoed;
+            CLI_EchoSkip -= CLI_TxInFlight - echoed;
+        }
+        CLI_EchoTxBytes += echoed;
+
+        now = (uint32_t)TS_GetUs();
+        while((CLI_EchoTail != CLI_EchoHead) &&
+              (CLI_EchoSamples[CLI_EchoTail & (CLI_ECHO_SAMPLES - 1)].rxEnd <= CLI_EchoTxBytes))
+        {
+            HISTO_Add(&CLI_EchoHisto, now - CLI_EchoSamples[CLI_EchoTail & (CLI_ECHO_SAMPLES - 1)].time);
+            CLI_EchoTail++;
+        }
+        if(echoed > 0)
+        {
+            CLI_EchoLastUs = now;
+        }
+    }
+
+    if(CLI_TxInFlight > 0)
+    {
+        CLI_TxBytes += CLI_TxInFlight;
+        CLI_TxPackets += (CLI_TxInFlight + CLI_TX_PACKET_SIZE - 1) / CLI_TX_PACKET_SIZE;
+    }
+
+    CLI_BenchFill();
+
+    // A transfer ending on a full packet needs a ZLP so the host returns the data right away
+    CLI_TxZlpPending = (CLI_TxInFlight > 0) && ((CLI_TxInFlight % CLI_TX_PACKET_SIZE) == 0) &&
+                       (RING_Count(&CLI_TxRing) == 0);
+    CLI_TxInFlight = 0;
+    CLI_TxBusy = false;
+
+    CLI_TxKick();
+
+    if(CLI_TxWaiting)
+    {
+        CLI_TxWaiting = false;
+        nOS_SemGive(&CLI_TxSpace);
+    }
+
+    // The echo may have left bytes in the Rx ring for lack of room
+    if(CLI_EchoActive)
+    {
+        nOS_FlagSend(&CLI_Events, CLI_EVT_TX, CLI_EVT_TX);
+    }
+}
+
+// USB (re)configured, pending data will be sent again from the ring
+void CLI_TxRestart(void)
+{
+    CLI_TxInFlight = 0;
+    CLI_TxZlpPending = false;
+    CLI_TxBusy = false;
+
+    // The task kicks the transfer once the class is ready
+    nOS_FlagSend(&CLI_Events, CLI_EVT_LINE, CLI_EVT_LINE);
+}
+
+// Top up the Tx ring with the benchmark pattern, runs from the Tx complete interrupt or in a critical section
+static void CLI_BenchFill(void)
+{
+    uint16_t len;
+
+    while((CLI_BenchLeft > 0) && (RING_Free(&CLI_TxRing) >= sizeof(CLI_BenchLine) - 1))
     {
-        nOS_QueueWrite(&CLI_TxQ, Buf+i, NOS_NO_WAIT);
+        len = sizeof(CLI_BenchLine) - 1;
+        if(len > CLI_BenchLeft)
+        {
+            len = CLI_BenchLeft;
+        }
+        RING_Write(&CLI_TxRing, (const uint8_t*)CLI_BenchLine, len);
+        CLI_BenchLeft -= len;
     }
 }
 
+// Stream CLI_BENCH_SIZE bytes to the host and report the sustained IN throughput
+void CLI_UsbBench(void)
+{
+    nOS_StatusReg sr;
+    uint32_t start;
+    uint32_t elapsed;
+    uint32_t bytes;
+
+    start = HAL_GetTick();
+    bytes = CLI_TxBytes;
+
+    // The pattern is produced by the Tx complete interrupt so the measure is not bound by this task
+    nOS_EnterCritical(sr);
+    CLI_BenchLeft = CLI_BENCH_SIZE;
+    CLI_BenchFill();
+    nOS_LeaveCritical(sr);
+    CLI_TxKick();
+
+    while((CLI_BenchLeft > 0) || (RING_Count(&CLI_TxRing) > 0) || CLI_TxBusy)
+    {
+        if((HAL_GetTick() - start) > CLI_BENCH_TIMEOUT)
+        {
+            CLI_BenchLeft = 0;
+            break;
+        }
+        nOS_Sleep(1);
+    }
+
+    elapsed = HAL_GetTick() - start;
+    bytes = CLI_TxBytes - bytes;
+    if(elapsed == 0)
+    {
+        elapsed = 1;
+    }
+    CLI_Printf("\r\nUSB bench : %lu bytes in %lu ms, %lu B/s", bytes, elapsed,
+               (uint32_t)(((uint64_t)bytes * 1000) / elapsed));
+}
+
+// Print the deepest the console stack went since boot, it grows down so the paint left at the bottom is unused
+void CLI_ShowStack(void)
+{
+    uint16_t i;
+
+    for(i = 0; (i < CLI_STACK_SIZE) && (CLI_Stack[i] == CLI_STACK_PAINT); i++);
+
+    CLI_Printf("\r\nConsole stack : %u of %u bytes used at most",
+               (unsigned int)((CLI_STACK_SIZE - i) * sizeof(nOS_Stack)), (unsigned int)sizeof(CLI_Stack));
+}
+
+// Print the USB Tx counters and the throughput since the last call
+void CLI_ShowUsbStats(void)
+{
+    uint32_t tick;
+    uint32_t bytes;
+    uint32_t rxBytes;
+    uint32_t elapsed;
+
+    tick = HAL_GetTick();
+    bytes = CLI_TxBytes;
+    rxBytes = CLI_RxBytes;
+    elapsed = tick - CLI_StatsTick;
+
+    CLI_Printf("\r\nUSB Host : %s", CLI_HostConnected ? "connected" : "not connected");
+    CLI_Printf("\r\nUSB Tx : %lu bytes, %lu packets, %lu dropped", bytes, CLI_TxPackets, CLI_TxDropped);
+    CLI_Printf("\r\nUSB Rx : %lu bytes, %lu pauses", CLI_RxBytes, CLI_RxPauses);
+    if(elapsed > 0)
+    {
+        CLI_Printf("\r\nUSB Tx : %lu B/s over %lu ms", (uint32_t)(((uint64_t)(bytes - CLI_StatsBytes) * 1000) / elapsed), elapsed);
+        CLI_Printf("\r\nUSB Rx : %lu B/s over %lu ms", (uint32_t)(((uint64_t)(rxBytes - CLI_StatsRxBytes) * 1000) / elapsed), elapsed);
+    }
+
+    STREAM_ShowStats();
+
+    CLI_StatsTick = tick;
+    CLI_StatsBytes = bytes;
+    CLI_StatsRxBytes = rxBytes;
+}
+
 static void Send_Prompt(char *menuStr)
 {
     char promptStr[32];
@@ -249,32 +658,249 @@ static void Send_Prompt(char *menuStr)
     CLI_Send(promptStr, strlen(promptStr));
 }
 
-// Rx from the USB CDC interrupt
-void CLI_Rx(char *Buf, uint16_t Len)
+// Rx from the USB CDC interrupt, returns false when the ring can't take another packet
+bool CLI_Rx(char *Buf, uint16_t Len)
+{
+    // Len never exceeds the free space since the endpoint is only armed with room for a full packet
+    CLI_RxBytes += RING_Write(&CLI_RxRing, (uint8_t*)Buf, Len);
+
+    // Receive time of a command line, the bytes of the loopback and binary modes are not lines
+    if((cliMode == CLI_MODE) && (memchr(Buf, '\r', Len) != NULL))
+    {
+        LAT_RxLine();
+    }
+
+    // Someone is typing, terminals that never raise DTR are treated as connected from here
+    CLI_SetHostConnected(true);
+
+    if(CLI_EchoActive)
+    {
+        if(CLI_EchoRxBytes == 0)
+        {
+            CLI_EchoStartUs = (uint32_t)TS_GetUs();
+        }
+        CLI_EchoRxBytes += Len;
+
+        if((uint8_t)(CLI_EchoHead - CLI_EchoTail) < CLI_ECHO_SAMPLES)
+        {
+            CLI_EchoSamples[CLI_EchoHead & (CLI_ECHO_SAMPLES - 1)].rxEnd = CLI_EchoRxBytes;
+            CLI_EchoSamples[CLI_EchoHead & (CLI_ECHO_SAMPLES - 1)].time = (uint32_t)TS_GetUs();
+            CLI_EchoHead++;
+        }
+        else
+        {
+            CLI_EchoMissed++;
+        }
+    }
+
+    nOS_FlagSend(&CLI_Events, CLI_EVT_RX, CLI_EVT_RX);
+
+    if(RING_Free(&CLI_RxRing) < CLI_RX_PACKET_SIZE)
+    {
+        CLI_RxPaused = true;
+        CLI_RxPauses++;
+        return false;
+    }
+    return true;
+}
+
+// Re-arm the USB OUT endpoint once the task made room in the Rx ring
+static void CLI_RxResume(void)
 {
-    if(Len == 1)
+    nOS_StatusReg sr;
+
+    if(CLI_RxPaused && (RING_Free(&CLI_RxRing) >= CLI_RX_PACKET_SIZE))
     {
-        nOS_QueueWrite(&CLI_RxQ, Buf, 2);
-        // Echo, don't echo escape char
-        // if(Buf != '\e')
-        // {
-        //     CLI_Send(Buf, 1);
-        // }
+        CLI_RxPaused = false;
+        nOS_EnterCritical(sr);
+        CDC_ReceiveResume_FS();
+        nOS_LeaveCritical(sr);
     }
-    else
+}
+
+// Break request from the host, ends the loopback mode
+void CLI_Break(void)
+{
+    CLI_BreakReq = true;
+    nOS_FlagSend(&CLI_Events, CLI_EVT_LINE, CLI_EVT_LINE);
+}
+
+// Wake the console task to run the released periodic jobs
+void CLI_Wake(void)
+{
+    nOS_FlagSend(&CLI_Events, CLI_EVT_SCHED, CLI_EVT_SCHED);
+}
+
+// false once a command handed the pipe to the loopback or the binary requests
+bool CLI_IsTextMode(void)
+{
+    return (cliMode == CLI_MODE);
+}
+
+// Polled by long running commands to stop early, consumes the break request, a closed port counts as one
+bool CLI_TakeBreak(void)
+{
+    bool Break;
+
+    Break = CLI_BreakReq || !CLI_HostConnected;
+    CLI_BreakReq = false;
+    return Break;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Enter the USB loopback benchmark, every received byte is sent back untouched until a break or until the
+  *         port is closed, then the throughput and the latency percentiles are printed
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void CLI_EchoStart(void)
+{
+    nOS_StatusReg sr;
+
+    CLI_Printf("\r\nEcho mode, send a break or close the port to stop\r\n");
+
+    HISTO_Init(&CLI_EchoHisto, EchoHisto_Bins, CLI_ECHO_BINS, CLI_ECHO_BIN_WIDTH);
+
+    nOS_EnterCritical(sr);
+    CLI_EchoRxBytes = 0;
+    CLI_EchoTxBytes = 0;
+    CLI_EchoMissed = 0;
+    CLI_EchoHead = 0;
+    CLI_EchoTail = 0;
+    CLI_EchoStartUs = 0;
+    CLI_EchoLastUs = 0;
+    // Whatever is already queued, the banner included, is not part of the echo
+    CLI_EchoSkip = RING_Count(&CLI_TxRing);
+    CLI_BreakReq = false;
+    CLI_EchoActive = true;
+    nOS_LeaveCritical(sr);
+
+    cliMode = ECHO_MODE;
+}
+
+// Send the received bytes back as they are, the OUT endpoint NAKs while the Tx ring is full
+static void CLI_EchoLoop(void)
+{
+    nOS_StatusReg sr;
+    uint8_t *pData;
+    uint16_t len;
+    uint16_t written;
+
+    if(CLI_BreakReq || !CLI_HostConnected)
     {
-        for(int i=0; i<Len; i++)
+        CLI_EchoStop();
+        return;
+    }
+
+    while((len = RING_Peek(&CLI_RxRing, &pData)) > 0)
+    {
+        nOS_EnterCritical(sr);
+        written = RING_Write(&CLI_TxRing, pData, len);
+        nOS_LeaveCritical(sr);
+
+        RING_Skip(&CLI_RxRing, written);
+        CLI_TxKick();
+
+        if(written < len)
         {
-            nOS_QueueWrite(&CLI_RxQ, Buf+i, 2);
-            // Echo, don't echo escape char
-            // if(Buf+i != '\e')
-            // {
-            //     CLI_Send(Buf+i, 1);
-            // }
+            break;
         }
     }
 }
 
+// Leave the loopback mode and print the run report
+static void CLI_EchoStop(void)
+{
+    uint32_t elapsed;
+    uint32_t rate;
+
+    CLI_EchoActive = false;
+    CLI_BreakReq = false;
+    cliMode = CLI_MODE;
+
+    elapsed = CLI_EchoLastUs - CLI_EchoStartUs;
+    rate = 0;
+    if((CLI_EchoTxBytes > 0) && (elapsed > 0))
+    {
+        rate = (uint32_t)(((uint64_t)CLI_EchoTxBytes * 1000000) / elapsed);
+    }
+
+    CLI_Printf("\r\nEcho : %lu bytes in, %lu bytes back in %lu us, %lu B/s", CLI_EchoRxBytes, CLI_EchoTxBytes,
+               elapsed, rate);
+    CLI_Printf("\r\nEcho latency (us) : %lu samples, min %lu, p50 %lu, p90 %lu, p99 %lu, max %lu",
+               CLI_EchoHisto.Count, (CLI_EchoHisto.Count > 0) ? CLI_EchoHisto.Min : 0,
+               HISTO_Percentile(&CLI_EchoHisto, 50), HISTO_Percentile(&CLI_EchoHisto, 90),
+               HISTO_Percentile(&CLI_EchoHisto, 99), CLI_EchoHisto.Max);
+    if(CLI_EchoMissed > 0)
+    {
+        CLI_Printf("\r\nEcho : %lu packets not timed", CLI_EchoMissed);
+    }
+
+    RING_Flush(&CLI_RxRing);
+    CLI_MENU_GoBack();
+    CLI_Send("\r\n", 2);
+    Send_Prompt(CLI_MENU_GetMenuStr());
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Enter the binary mode, received bytes are COBS framed requests (see proto.h) until the exit request, a
+  *         break or the port closing
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void CLI_DataStart(void)
+{
+    CLI_Printf("\r\nBinary mode, send a break or the exit request to leave\r\n");
+
+    CLI_BreakReq = false;
+    PROTO_Start();
+    cliMode = DATA_MODE;
+
+    // Requests sent right behind the command are already in the Rx ring
+    nOS_FlagSend(&CLI_Events, CLI_EVT_RX, CLI_EVT_RX);
+}
+
+// Hand the received bytes to the protocol, requests run and answer from here
+static void CLI_DataLoop(void)
+{
+    uint8_t *pData;
+    uint16_t len;
+
+    if(CLI_BreakReq || !CLI_HostConnected)
+    {
+        CLI_DataStop();
+        return;
+    }
+
+    while((len = RING_Peek(&CLI_RxRing, &pData)) > 0)
+    {
+        if(!PROTO_Rx(pData, len))
+        {
+            CLI_DataStop();
+            return;
+        }
+        RING_Skip(&CLI_RxRing, len);
+    }
+}
+
+// Back to the text console with the session report
+static void CLI_DataStop(void)
+{
+    CLI_BreakReq = false;
+    cliMode = CLI_MODE;
+
+    RING_Flush(&CLI_RxRing);
+    PROTO_ShowStats();
+    CLI_Send("\r\n", 2);
+    Send_Prompt(CLI_MENU_GetMenuStr());
+}
+
 void CLI_UserConnected()
 {
     //CLI_Printf("User connected ...\r\n");
@@ -287,30 +913,73 @@ void CLI_UserConnected()
   *
   * @brief  Send formatted string to console if menu system is not active
   *
-  * @param  Level       Level of printf logging
+  *         The text is formatted straight in the Tx ring, so there is no length limit and the caller only waits when
+  *         the ring is full. Safe from any thread, output of concurrent callers is not mixed. From an interrupt the
+  *         text is dropped when the ring is full and may land between the chunks of a thread output.
+  *
   * @param  pFormat     Formatted string
   * @param  ...         Parameter if any
   *
-  * @retval None
+  * @retval size_t      Number of character printed
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-#define CLI_PRINT_MAX_SIZE  64
-char cliPrintBuff[CLI_PRINT_MAX_SIZE];
-
 size_t CLI_Printf(const char* pFormat, ...)
 {
     va_list          vaArg;
-    char*            Buffer;
     size_t           Size;
+    bool             isr;
+
+    isr = (__get_IPSR() != 0);
+    if(!isr)
+    {
+        nOS_MutexLock(&CLI_TxMutex, NOS_WAIT_INFINITE);
+    }
 
-    Buffer = cliPrintBuff;
     va_start(vaArg, (const char*)pFormat);
-    Size = STR_vsnprintf(Buffer, CLI_PRINT_MAX_SIZE, pFormat, vaArg);
-    CLI_Send(Buffer, Size);
-    nOS_Sleep(2);
+    Size = STR_vcbprintf(CLI_TxWrite, NULL, pFormat, vaArg);
     va_end(vaArg);
-    
+    CLI_TxKick();
+
+    if(!isr)
+    {
+        nOS_MutexUnlock(&CLI_TxMutex);
+    }
+
     return Size;
+}
+
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  *
+  * @brief  Dump a buffer to the console as offset, hexadecimal and ASCII lines
+  *
+  *         Same locking and Tx ring rules as CLI_Printf, a line goes to the ring in one copy.
+  *
+  * @param  Offset      Offset shown on the first line, to dump a long read chunk by chunk
+  * @param  pData       Data to dump
+  * @param  Len         Number of bytes
+  *
+  * @retval None
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void CLI_Dump(uint32_t Offset, const uint8_t* pData, size_t Len)
+{
+    bool isr;
+
+    isr = (__get_IPSR() != 0);
+    if(!isr)
+    {
+        nOS_MutexLock(&CLI_TxMutex, NOS_WAIT_INFINITE);
+    }
+
+    STR_HexDump(CLI_TxWrite, NULL, Offset, pData, Len);
+    CLI_TxKick();
 
+    if(!isr)
+    {
+        nOS_MutexUnlock(&CLI_TxMutex);
+    }
 }
@@ -8,44 +8,78 @@
 /* Includes ---------------------------------------------------------------------------------------------------------*/
 
 #include <string.h>
+#include <stdlib.h>
 #include <stdarg.h>
+#include <ctype.h>
 #include "cli_menu.h"
 #include "i2c.h"
+#include "spi.h"
 #include "cli.h"
 #include "strfct.h"
 #include "defines.h"
+#include "timestamp.h"
+#include "fatfs.h"
+#include "macro.h"
+#include "vm.h"
+#include "sched.h"
+#include "payload.h"
+#include "lat.h"
+#include "i2c_dma.h"
 
 /* Local Defines ----------------------------------------------------------------------------------------------------*/
-//          Command     Callback
-
-#define X_COMMAND_ARRAY \
-X_CLI_CMD( HELP_CMD,  "help",    ShowHelp     )\
-X_CLI_CMD( I2C_CMD,   "I2C",     NULL         )\
-X_CLI_CMD( I2C_CMD_lc,"i2c",     NULL         )\
-X_CLI_CMD( SPI_CMD_lc,"spi",     NULL         )\
-X_CLI_CMD( SPI_CMD,   "SPI",     NULL         )
-
-#define X_I2C_CMD_ARRAY \
-X_CLI_I2C_CMD( I2C_ADDR_CMD,        "addr",     CLI_I2C_SetAddr         )\
-X_CLI_I2C_CMD( I2C_WRITE_CMD,       "w",        CLI_I2C_WriteCmd        )\
-X_CLI_I2C_CMD( I2C_WRITE_READ_CMD,  "wr",       CLI_I2C_WriteReadCmd    )\
-X_CLI_I2C_CMD( I2C_READ_CMD,        "r",        NULL                    )\
-X_CLI_I2C_CMD( I2C_HELP_CMD,        "h",        ShowI2CHelp             )\
-X_CLI_I2C_CMD( I2C_SCAN,            "scan",     CLI_I2C_ScanBus         )
-
-#define X_SPI_CMD_ARRAY \
-X_CLI_SPI_CMD( SPI_WRITE_CMD,       "w",        CLI_SPI_WriteCmd        )\
-X_CLI_SPI_CMD( SPI_WRITE_READ_CMD,  "wr",       NULL    )\
-X_CLI_SPI_CMD( SPI_READ_CMD,        "r",        NULL                    )\
-X_CLI_SPI_CMD( SPI_HELP_CMD,        "h",        ShowSPIHelp             )\
-
-/* Help menu doesn't exist, it will only print the help right away */
-#define X_MENU_COMMAND_ARRAY \
-X_CLI_MENU_CMD( HELP_CMD,   "h",     NO_MENU     )\
-X_CLI_MENU_CMD( I2C_MENU,   "i",     MENU_I2C    )\
-X_CLI_MENU_CMD( SPI_MENU,   "s",     MENU_SPI    )\
-X_CLI_MENU_CMD( UART_MENU,  "u",     MENU_UART   )\
-X_CLI_MENU_CMD( CAN_MENU,   "c",     MENU_CAN    )
+
+// Every console command, in every menu. NO_MENU commands are valid in all menus, Goto is the menu entered before the
+// callback runs (NO_MENU to stay). Names are matched without case.
+//
+//          Menu        Command     Callback                Goto        Argument        Help
+#define X_CLI_CMD_TABLE \
+X_CLI_CMD(  NO_MENU,    "h",        CmdHelp,                NO_MENU,    CLI_ARG_NONE,   "Show the commands"                 )\
+X_CLI_CMD(  NO_MENU,    "help",     CmdHelp,                NO_MENU,    CLI_ARG_NONE,   "Show the commands"                 )\
+X_CLI_CMD(  NO_MENU,    "run",      CmdRun,                 NO_MENU,    CLI_ARG_TEXT,   "Run a macro"                       )\
+X_CLI_CMD(  NO_MENU,    "def",      CmdDefine,              NO_MENU,    CLI_ARG_LINE,   "Define a macro, <name> <cmd;cmd>"  )\
+X_CLI_CMD(  NO_MENU,    "rec",      CmdRecord,              NO_MENU,    CLI_ARG_TEXT,   "Record the next commands in <name>")\
+X_CLI_CMD(  NO_MENU,    "end",      CmdEnd,                 NO_MENU,    CLI_ARG_NONE,   "Stop recording"                    )\
+X_CLI_CMD(  NO_MENU,    "del",      CmdDelete,              NO_MENU,    CLI_ARG_TEXT,   "Delete a macro"                    )\
+X_CLI_CMD(  NO_MENU,    "macros",   CmdMacros,              NO_MENU,    CLI_ARG_NONE,   "List the macros"                   )\
+X_CLI_CMD(  NO_MENU,    "msave",    CmdMacroSave,           NO_MENU,    CLI_ARG_NONE,   "Save the macros on the volume"     )\
+X_CLI_CMD(  NO_MENU,    "mload",    CmdMacroLoad,           NO_MENU,    CLI_ARG_NONE,   "Load the macros from the volume"   )\
+X_CLI_CMD(  NO_MENU,    "vm",       CmdVm,                  NO_MENU,    CLI_ARG_LINE,   "Run a bus sequence"                )\
+X_CLI_CMD(  NO_MENU,    "vmrun",    CmdVmRun,               NO_MENU,    CLI_ARG_TEXT,   "Run a macro as a bus sequence"     )\
+X_CLI_CMD(  NO_MENU,    "every",    CmdEvery,               NO_MENU,    CLI_ARG_LINE,   "Repeat a command, <ms> <cmd>"      )\
+X_CLI_CMD(  NO_MENU,    "jobs",     CmdJobs,                NO_MENU,    CLI_ARG_NONE,   "List the repeated commands"        )\
+X_CLI_CMD(  NO_MENU,    "lat",      CmdLatency,             NO_MENU,    CLI_ARG_NONE,   "Command latency per stage, reset"  )\
+X_CLI_CMD(  NO_MENU,    "stop",     CmdStop,                NO_MENU,    CLI_ARG_OPTIONAL,"Stop a repeated command, or all"   )\
+X_CLI_CMD(  MENU_MAIN,  "i",        NULL,                   MENU_I2C,   CLI_ARG_NONE,   "I2C menu"                          )\
+X_CLI_CMD(  MENU_MAIN,  "i2c",      NULL,                   MENU_I2C,   CLI_ARG_NONE,   "I2C menu"                          )\
+X_CLI_CMD(  MENU_MAIN,  "s",        NULL,                   MENU_SPI,   CLI_ARG_NONE,   "SPI menu"                          )\
+X_CLI_CMD(  MENU_MAIN,  "spi",      NULL,                   MENU_SPI,   CLI_ARG_NONE,   "SPI menu"                          )\
+X_CLI_CMD(  MENU_MAIN,  "u",        NULL,                   MENU_UART,  CLI_ARG_NONE,   "UART menu"                         )\
+X_CLI_CMD(  MENU_MAIN,  "c",        NULL,                   MENU_CAN,   CLI_ARG_NONE,   "CAN menu"                          )\
+X_CLI_CMD(  MENU_MAIN,  "echo",     CmdEcho,                MENU_ECHO,  CLI_ARG_NONE,   "USB loopback, break to leave"      )\
+X_CLI_CMD(  MENU_MAIN,  "bin",      CmdBinary,              NO_MENU,    CLI_ARG_NONE,   "Binary requests, break to leave"   )\
+X_CLI_CMD(  MENU_MAIN,  "usb",      CmdUsbStats,            NO_MENU,    CLI_ARG_NONE,   "USB counters and throughput"       )\
+X_CLI_CMD(  MENU_MAIN,  "bench",    CmdUsbBench,            NO_MENU,    CLI_ARG_NONE,   "USB IN throughput test"            )\
+X_CLI_CMD(  MENU_MAIN,  "time",     ShowTime,               NO_MENU,    CLI_ARG_NONE,   "Device timestamp"                  )\
+X_CLI_CMD(  MENU_MAIN,  "disk",     ShowDisk,               NO_MENU,    CLI_ARG_NONE,   "Capture volume status"             )\
+X_CLI_CMD(  MENU_MAIN,  "mount",    MountDisk,              NO_MENU,    CLI_ARG_NONE,   "Mount the capture volume"          )\
+X_CLI_CMD(  MENU_MAIN,  "eject",    EjectDisk,              NO_MENU,    CLI_ARG_NONE,   "Give the volume back to the host"  )\
+X_CLI_CMD(  MENU_I2C,   "addr",     CLI_I2C_SetAddr,        NO_MENU,    CLI_ARG_BYTES,  "Set the slave address"             )\
+X_CLI_CMD(  MENU_I2C,   "w",        CLI_I2C_WriteCmd,       NO_MENU,    CLI_ARG_BYTES,  "Write bytes"                       )\
+X_CLI_CMD(  MENU_I2C,   "wr",       CLI_I2C_WriteReadCmd,   NO_MENU,    CLI_ARG_BYTES,  "Write register, read <reg> <len>"  )\
+X_CLI_CMD(  MENU_I2C,   "r",        CLI_I2C_ReadCmd,        NO_MENU,    CLI_ARG_TEXT,   "Read <len> [register bytes]"       )\
+X_CLI_CMD(  MENU_I2C,   "scan",     CLI_I2C_ScanBus,        NO_MENU,    CLI_ARG_OPTIONAL,"Scan, [first last [clocks]]"      )\
+X_CLI_CMD(  MENU_I2C,   "speed",    CLI_I2C_Speed,          NO_MENU,    CLI_ARG_OPTIONAL,"Bus speed, [preset|Hz [rise fall]]")\
+X_CLI_CMD(  MENU_I2C,   "xfer",     CLI_I2C_ListCmd,        NO_MENU,    CLI_ARG_TEXT,   "Run w/r/rs/stop/d steps, '|' apart"   )\
+X_CLI_CMD(  MENU_SPI,   "w",        CLI_SPI_WriteCmd,       NO_MENU,    CLI_ARG_BYTES,  "Write bytes"                       )\
+X_CLI_CMD(  MENU_SPI,   "wr",       NULL,                   NO_MENU,    CLI_ARG_BYTES,  "Write then read"                   )\
+X_CLI_CMD(  MENU_SPI,   "r",        NULL,                   NO_MENU,    CLI_ARG_BYTES,  "Read"                              )
+
+#define CLI_HASH_SIZE       128     // Must be a power of 2 and at least twice the number of commands
+#define CLI_HASH_EMPTY      0xFF
+#define CLI_RUN_CMD_SIZE    128     // Longest command of a macro
+#define CLI_RUN_MAX_DEPTH   2       // Macros running other macros, each level costs console stack
+#define CLI_PAYLOAD_SIZE    300     // A 256 bytes page with its command and address bytes
+#define CLI_PAYLOAD_SHOWN   16      // Payload bytes echoed before sending
 
 /* Local Typedefs ---------------------------------------------------------------------------------------------------*/
 
@@ -61,189 +95,278 @@ typedef enum __CLI_MENU_PAGE_e
     MENU_ECHO,
 }CLI_MENU_PAGE_e;
 
-// Main menu commands
-typedef enum
+// What a command accepts after its name, checked before the callback runs
+typedef enum __CLI_ARG_e
 {
-#define X_CLI_MENU_CMD(IDX, CMD, MENU) IDX,
-    X_MENU_COMMAND_ARRAY
-#undef X_CLI_MENU_CMD
-    NUM_OF_CLI_CMD
-}CLI_CmdIndex_e;
+    CLI_ARG_NONE,       // Nothing
+    CLI_ARG_BYTES,      // Required list of bytes, see parseDataStr
+    CLI_ARG_TEXT,       // Required free text
+    CLI_ARG_OPTIONAL,   // Free text or nothing
+    CLI_ARG_LINE,       // Required, the rest of the line with its ';'
+}CLI_ARG_e;
 
-// I2C Menu commands
-typedef enum
-{
-#define X_CLI_I2C_CMD(IDX, CMD, CALLBACK) IDX,
-    X_I2C_CMD_ARRAY
-#undef X_CLI_I2C_CMD
-    NUM_OF_I2C_CLI_CMD
-}CLI_I2CCmdIndex_e;
+typedef bool (*CLI_CmdCallback_t)(char *arg);
 
-// SPI Menu commands
-typedef enum
+typedef struct
 {
-#define X_CLI_SPI_CMD(IDX, CMD, CALLBACK) IDX,
-    X_SPI_CMD_ARRAY
-#undef X_CLI_SPI_CMD
-    NUM_OF_SPI_CLI_CMD
-}CLI_SPICmdIndex_e;
+    const char*         pName;
+    CLI_CmdCallback_t   Callback;
+    uint8_t             Menu;       // CLI_MENU_PAGE_e
+    uint8_t             Goto;       // CLI_MENU_PAGE_e
+    uint8_t             Arg;        // CLI_ARG_e
+    const char*         pHelp;
+}CLI_Cmd_t;
 
 /* Forward Declarations ---------------------------------------------------------------------------------------------*/
 // Parser Section
-static void ParseMainCmd    (uint8_t *cmd);
-static void ParseConfigCmd  (uint8_t *cmd);
-static void ParseUartCmd    (uint8_t *cmd);
-static void ParseSpiCmd     (uint8_t *cmd);
-static void ParseI2CCmd     (uint8_t *cmd);
-static void ParseCANCmd     (uint8_t *cmd);
 static void GotoMenu        (CLI_MENU_PAGE_e page);
+static uint8_t CLI_MENU_Hash(uint8_t Menu, const char *pName, size_t Len);
+static const CLI_Cmd_t* CLI_MENU_Find(uint8_t Menu, const char *pName, size_t Len);
+static const CLI_Cmd_t* CLI_MENU_Lookup(const char *pName, size_t Len);
 
 //I2C Section
-static void CLI_I2C_WriteCmd        (uint8_t *arg);
-static void CLI_I2C_WriteReadCmd    (uint8_t *arg);
-static void CLI_I2C_SetAddr         (uint8_t *arg);
+static bool CLI_I2C_WriteCmd        (char *arg);
+static bool CLI_I2C_WriteReadCmd    (char *arg);
+static bool CLI_I2C_ReadCmd         (char *arg);
+static bool CLI_I2C_SetAddr         (char *arg);
+static bool CLI_I2C_ScanBus         (char *arg);
+static bool CLI_I2C_Speed           (char *arg);
+static bool CLI_I2C_ListCmd         (char *arg);
 
 //SPI Section
-static void CLI_SPI_WriteCmd        (uint8_t *arg);
-static void CLI_SPI_WriteReadCmd    (uint8_t *arg);
-static void CLI_SPI_SetAddr         (uint8_t *arg);
-static void CLI_I2C_ScanBus			(uint8_t *arg);
+static bool CLI_SPI_WriteCmd        (char *arg);
+
+// Main section
+static bool CmdHelp         (char *arg);
+static bool CmdEcho         (char *arg);
+static bool CmdBinary       (char *arg);
+static bool CmdLatency      (char *arg);
+static bool CmdUsbStats     (char *arg);
+static bool CmdUsbBench     (char *arg);
+static bool ShowTime        (char *arg);
+static bool ShowDisk        (char *arg);
+static bool MountDisk       (char *arg);
+static bool EjectDisk       (char *arg);
+static void ShowMenuHelp    (CLI_MENU_PAGE_e page);
 
-// Help section
-static void ShowHelp        (void);
-static void ShowI2CHelp		(uint8_t *arg);
-static void ShowSPIHelp		(uint8_t *arg);
+// Macro section
+static bool CmdRun          (char *arg);
+static bool CmdDefine       (char *arg);
+static bool CmdRecord       (char *arg);
+static bool CmdEnd          (char *arg);
+static bool CmdDelete       (char *arg);
+static bool CmdMacros       (char *arg);
+static bool CmdMacroSave    (char *arg);
+static bool CmdMacroLoad    (char *arg);
+
+// Bus sequence section
+static bool CmdVm           (char *arg);
+static bool CmdVmRun        (char *arg);
+
+// Periodic section
+static bool CmdEvery        (char *arg);
+static bool CmdJobs         (char *arg);
+static bool CmdStop         (char *arg);
 
 /* Local Constants --------------------------------------------------------------------------------------------------*/
 
 volatile char i2cAddrStr[7] = "I2C@00";
-char* menuStr[] = {"----", "main", "config", "UART", i2cAddrStr, "SPI", "CAN", "ECHO",};
-
-// Main Cmd array
-#define X_CLI_MENU_CMD( IDX, COMMAND, MENU )  COMMAND,
-const char* mainCmdArray[] = { X_MENU_COMMAND_ARRAY };
-#undef X_CLI_MENU_CMD
-//Main Cmd Callback array
-#define X_CLI_MENU_CMD( IDX, COMMAND, MENU )  MENU,
-CLI_MENU_PAGE_e mainCmdMenu[] = { X_MENU_COMMAND_ARRAY };
-#undef X_CLI_MENU_CMD
-
-//I2C Commands
-#define X_CLI_I2C_CMD( IDX, COMMAND, CALLBACK )  COMMAND,
-const char* I2CCmdArray[] = { X_I2C_CMD_ARRAY };
-#undef X_CLI_I2C_CMD
-//I2C Commands Callback
-#define X_CLI_I2C_CMD( IDX, COMMAND, CALLBACK )  CALLBACK,
-void (*I2CCmdCallback[])(uint8_t *arg) = { X_I2C_CMD_ARRAY };
-#undef X_CLI_I2C_CMD
-
-//SPI Commands
-#define X_CLI_SPI_CMD( IDX, COMMAND, CALLBACK )  COMMAND,
-const char* SPICmdArray[] = { X_SPI_CMD_ARRAY };
-#undef X_CLI_SPI_CMD
-//SPI Commands Callback
-#define X_CLI_SPI_CMD( IDX, COMMAND, CALLBACK )  CALLBACK,
-void (*SPICmdCallback[])(uint8_t *arg) = { X_SPI_CMD_ARRAY };
-#undef X_CLI_SPI_CMD
+char* menuStr[] = {"----", "main", "config", "UART", (char*)i2cAddrStr, "SPI", "CAN", "ECHO",};
+
+static const char* const CLI_ArgStr[] = {"", "=<bytes>", "=<text>", "[=text]", "=<line>"};
+
+// Command registry
+#define X_CLI_CMD( MENU, COMMAND, CALLBACK, GOTO, ARG, HELP )  {COMMAND, CALLBACK, MENU, GOTO, ARG, HELP},
+static const CLI_Cmd_t CLI_CmdTable[] = { X_CLI_CMD_TABLE };
+#undef X_CLI_CMD
+
+#define NUM_OF_CLI_CMD      (sizeof(CLI_CmdTable) / sizeof(CLI_CmdTable[0]))
+
+// Fails to compile when the hash index gets too crowded
+typedef char CLI_HashSizeCheck[((NUM_OF_CLI_CMD * 2) <= CLI_HASH_SIZE) ? 1 : -1];
 
 /* Local Variables --------------------------------------------------------------------------------------------------*/
 
 CLI_MENU_PAGE_e ActualPage = MENU_MAIN;
 CLI_MENU_PAGE_e PreviousPage = MENU_MAIN;
-uint8_t dataCommand[64];
-uint8_t dataCommandIdx;
+uint8_t dataCommand[CLI_PAYLOAD_SIZE];
+uint8_t CLI_CmdHash[CLI_HASH_SIZE];     // Index in CLI_CmdTable, open addressing
+char    CLI_RunCmd[CLI_RUN_CMD_SIZE];   // Command of a macro being run, shared by nested runs
+char    CLI_RunName[CLI_RUN_MAX_DEPTH][MACRO_NAME_SIZE];   // Macro run at each depth, the argument lives in CLI_RunCmd
+uint8_t CLI_RunDepth;
 
 /* Local Functions --------------------------------------------------------------------------------------------------*/
 
 /**
   *--------------------------------------------------------------------------------------------------------------------
-  * @brief  
+  * @brief  Hash of a command name in a menu, the case is ignored
   *
-  * @param  none
+  * @param  Menu            Menu of the command
+  * @param  pName           Name, not necessarily null terminated
+  * @param  Len             Name length
   *
-  * @retval none
+  * @retval uint8_t         First slot to probe in CLI_CmdHash
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void ParseMainCmd(uint8_t *cmd)
+static uint8_t CLI_MENU_Hash(uint8_t Menu, const char *pName, size_t Len)
 {
-    for(CLI_CmdIndex_e i=0; i< NUM_OF_CLI_CMD; i++)
+    uint32_t Hash;
+
+    // FNV-1a
+    Hash = 2166136261U ^ Menu;
+    while(Len-- > 0)
     {
-        if (!strcmp((char*)cmd, mainCmdArray[i]))
-        {
-        	// If there's no menu, analyse the function
-            if(mainCmdMenu[i] == NO_MENU)
-            {
-            	if(i == HELP_CMD)
-            	{
-					ShowHelp();
-            	}
-            }
-            else
-            {
-                GotoMenu(mainCmdMenu[i]);
-            }
-        }
+        Hash ^= (uint8_t)tolower((unsigned char)*pName++);
+        Hash *= 16777619U;
     }
+
+    return (uint8_t)((Hash ^ (Hash >> 16)) & (CLI_HASH_SIZE - 1));
 }
 
 /**
   *--------------------------------------------------------------------------------------------------------------------
-  * @brief  
+  * @brief  Find a command of a menu by name, the case is ignored
   *
-  * @param  none
+  * @param  Menu            Menu of the command
+  * @param  pName           Name, not necessarily null terminated
+  * @param  Len             Name length
   *
-  * @retval none
+  * @retval const CLI_Cmd_t*    Command or NULL
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void ParseConfigCmd(uint8_t *cmd)
+static const CLI_Cmd_t* CLI_MENU_Find(uint8_t Menu, const char *pName, size_t Len)
 {
+    const CLI_Cmd_t* pCmd;
+    uint8_t Slot;
+    size_t i;
+
+    Slot = CLI_MENU_Hash(Menu, pName, Len);
+    while(CLI_CmdHash[Slot] != CLI_HASH_EMPTY)
+    {
+        pCmd = &CLI_CmdTable[CLI_CmdHash[Slot]];
+        if((pCmd->Menu == Menu) && (strlen(pCmd->pName) == Len))
+        {
+            for(i = 0; (i < Len) && (tolower((unsigned char)pName[i]) == pCmd->pName[i]); i++);
+            if(i == Len)
+            {
+                return pCmd;
+            }
+        }
+        Slot = (Slot + 1) & (CLI_HASH_SIZE - 1);
+    }
 
+    return NULL;
 }
 
 /**
   *--------------------------------------------------------------------------------------------------------------------
-  * @brief  
+  * @brief  Find a command of the current menu, or one valid in all menus
   *
-  * @param  none
+  * @param  pName           Name, not necessarily null terminated
+  * @param  Len             Name length
   *
-  * @retval none
+  * @retval const CLI_Cmd_t*    Command or NULL
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void ParseUartCmd(uint8_t *cmd)
+static const CLI_Cmd_t* CLI_MENU_Lookup(const char *pName, size_t Len)
 {
+    const CLI_Cmd_t* pCmd;
+
+    pCmd = CLI_MENU_Find(ActualPage, pName, Len);
+    if(pCmd == NULL)
+    {
+        pCmd = CLI_MENU_Find(NO_MENU, pName, Len);
+    }
 
+    return pCmd;
 }
 
 /**
   *--------------------------------------------------------------------------------------------------------------------
-  * @brief  
+  * @brief  Run one command line in the current menu
   *
-  * @param  none
+  *         The name ends at the first '=' or space, what follows is the argument.
   *
-  * @retval none
+  * @param  pLine           Command line, modified
+  *
+  * @retval bool            false if the command is unknown, its argument invalid or it failed
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void ParseSpiCmd(uint8_t *cmd)
+static bool CLI_MENU_Execute(char *pLine)
 {
-    char *argPtr = NULL;
-    char *CmdPtr = NULL;
-    CmdPtr = strtok((char*)cmd, "=");
-    for(CLI_SPICmdIndex_e i=0; i< NUM_OF_SPI_CLI_CMD; i++)
+    const CLI_Cmd_t* pCmd;
+    char *pName;
+    char *pArg;
+    size_t Len;
+
+    while(*pLine == ' ')
     {
-        if (!strcmp(CmdPtr, SPICmdArray[i]))
+        pLine++;
+    }
+
+    pName = pLine;
+    Len = strcspn(pName, "= ");
+    if(Len == 0)
+    {
+        return true;
+    }
+
+    // Argument, NULL when absent or empty
+    pArg = NULL;
+    if(pName[Len] != '\0')
+    {
+        pArg = &pName[Len + 1];
+        while(*pArg == ' ')
         {
-            // Find the argument pointer
-            argPtr = strtok(NULL, ";");
-            if(argPtr != NULL)
-            {
-                SPICmdCallback[i](argPtr);
-            }
+            pArg++;
+        }
+
+        if(*pArg == '\0')
+        {
+            pArg = NULL;
         }
     }
+
+    pCmd = CLI_MENU_Lookup(pName, Len);
+    if(pCmd == NULL)
+    {
+        CLI_Printf("\r\nUnknown command '%.*s', h for help", (int)Len, pName);
+        return false;
+    }
+
+    if((pCmd->Arg == CLI_ARG_NONE) && (pArg != NULL))
+    {
+        CLI_Printf("\r\n%s takes no argument", pCmd->pName);
+        return false;
+    }
+
+    if((pCmd->Arg != CLI_ARG_NONE) && (pCmd->Arg != CLI_ARG_OPTIONAL) && (pArg == NULL))
+    {
+        CLI_Printf("\r\n%s needs an argument : %s%s", pCmd->pName, pCmd->pName, CLI_ArgStr[pCmd->Arg]);
+        return false;
+    }
+
+    if((pCmd->Callback == NULL) && (pCmd->Goto == NO_MENU))
+    {
+        CLI_Printf("\r\n%s is not implemented", pCmd->pName);
+        return false;
+    }
+
+    if(pCmd->Goto != NO_MENU)
+    {
+        GotoMenu(pCmd->Goto);
+    }
+
+    if(pCmd->Callback != NULL)
+    {
+        return pCmd->Callback(pArg);
+    }
+
+    return true;
 }
 
 /**
@@ -256,25 +379,24 @@ static void ParseSpiCmd(uint8_t *cmd)
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void ParseI2CCmd(uint8_t *cmd)
+static bool CLI_SPI_WriteCmd(char *arg)
 {
-    char *argPtr = NULL;
-    char *CmdPtr = NULL;
-    CmdPtr = strtok((char*)cmd, "=");
-    for(CLI_I2CCmdIndex_e i=0; i< NUM_OF_I2C_CLI_CMD; i++)
+    uint16_t dataLen;
+    CLI_Printf("SPI W Cmd ...\r\n");
+    dataLen = parseDataStr(arg);
+    if(dataLen == 0)
     {
-        if (!strcmp(CmdPtr, I2CCmdArray[i]))
-        {
-            // Find the argument pointer
-            argPtr = strtok(NULL, ";");
-            if(argPtr != NULL)
-            {
-                I2CCmdCallback[i](argPtr);
-            }
-        }
+        return false;
+    }
+    if(!SPI_dataWrite(dataCommand, dataLen))
+    {
+        CLI_Printf("SPI busy or transfer timed out\r\n");
+        return false;
     }
+    return true;
 }
 
+
 /**
   *--------------------------------------------------------------------------------------------------------------------
   * @brief  
@@ -285,15 +407,18 @@ static void ParseI2CCmd(uint8_t *cmd)
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void CLI_SPI_WriteCmd(uint8_t *arg)
+static bool CLI_I2C_WriteCmd(char *arg)
 {
-    uint8_t dataLen;
-    CLI_Printf("SPI W Cmd ...\r\n");
+    uint16_t dataLen;
+    CLI_Printf("I2C W Cmd ...\r\n");
     dataLen = parseDataStr(arg);
-    SPI_dataWrite(dataCommand, dataLen);
+    if(dataLen == 0)
+    {
+        return false;
+    }
+    return I2C_Cmd_Write(dataCommand, dataLen);
 }
 
-
 /**
   *--------------------------------------------------------------------------------------------------------------------
   * @brief  
@@ -304,30 +429,46 @@ static void CLI_SPI_WriteCmd(uint8_t *arg)
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void CLI_I2C_WriteCmd(uint8_t *arg)
+static bool CLI_I2C_WriteReadCmd(char *arg)
 {
-    uint8_t dataLen;
-    CLI_Printf("I2C W Cmd ...\r\n");
+    uint16_t dataLen;
+    CLI_Printf("I2C WR Cmd ...\r\n");
     dataLen = parseDataStr(arg);
-    I2C_Cmd_Write(dataCommand, dataLen);
+    if(dataLen < 2)
+    {
+        return false;
+    }
+    return I2C_Cmd_Write_Read(dataCommand);
 }
 
 /**
   *--------------------------------------------------------------------------------------------------------------------
-  * @brief  
+  * @brief  Read any number of bytes, streamed through the DMA engine
   *
-  * @param  none
+  * @param  arg             Length, decimal or 0x hex, then the register address bytes if any
   *
-  * @retval none
+  * @retval bool
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void CLI_I2C_WriteReadCmd(uint8_t *arg)
+// 'r=65536 00 00' dumps a whole 24C512 from its first byte
+static bool CLI_I2C_ReadCmd(char *arg)
 {
-    uint8_t dataLen;
-    CLI_Printf("I2C WR Cmd ...\r\n");
-    dataLen = parseDataStr(arg);
-    I2C_Cmd_Write_Read(dataCommand, dataLen);
+    uint8_t reg[I2C_DMA_MAX_REG];
+    unsigned long len;
+    size_t regLen;
+    size_t errPos;
+    char *pEnd;
+
+    len = strtoul(arg, &pEnd, 0);
+    if((pEnd == arg) || (len == 0) ||
+       (PAYLOAD_Parse(pEnd, reg, sizeof(reg), &regLen, &errPos) != PAYLOAD_OK))
+    {
+        CLI_Printf("\r\nr=<len> [up to %u register bytes]", I2C_DMA_MAX_REG);
+        return false;
+    }
+
+    return I2C_Cmd_Read(reg, (uint8_t)regLen, len);
 }
 
 /**
@@ -340,14 +481,18 @@ static void CLI_I2C_WriteReadCmd(uint8_t *arg)
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void CLI_I2C_SetAddr(uint8_t *arg)
+static bool CLI_I2C_SetAddr(char *arg)
 {
-    uint8_t dataLen;
-    char addrStr[6];
+    uint16_t dataLen;
     CLI_Printf("I2C Addr Cmd ...\r\n");
     dataLen = parseDataStr(arg);
+    if(dataLen == 0)
+    {
+        return false;
+    }
     I2C_SetAddress(dataCommand[0]);
-    snprintf(menuStr[3], 7, "I2C@%02X", dataCommand[0]);
+    snprintf(menuStr[MENU_I2C], sizeof(i2cAddrStr), "I2C@%02X", dataCommand[0]);
+    return true;
 }
 
 /**
@@ -360,24 +505,180 @@ static void CLI_I2C_SetAddr(uint8_t *arg)
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void CLI_I2C_ScanBus(uint8_t *arg)
+// Addresses are 7 bits in hex as for i2cdetect, the probe timeout in SCL periods is decimal
+static bool CLI_I2C_ScanBus(char *arg)
 {
-    I2C_ScanForDevices();
+    unsigned long first = I2C_SCAN_FIRST;
+    unsigned long last = I2C_SCAN_LAST;
+    unsigned long clocks = I2C_SCAN_CLOCKS;
+    char *pEnd;
+
+    if(arg != NULL)
+    {
+        first = strtoul(arg, &pEnd, 16);
+        pEnd += strspn(pEnd, " ");
+        last = (*pEnd != '\0') ? strtoul(pEnd, &pEnd, 16) : first;
+        pEnd += strspn(pEnd, " ");
+        clocks = (*pEnd != '\0') ? strtoul(pEnd, &pEnd, 10) : clocks;
+        pEnd += strspn(pEnd, " ");
+
+        // The range itself is checked by the scan
+        if((*pEnd != '\0') || (first > UINT8_MAX) || (last > UINT8_MAX) || (clocks == 0) || (clocks > UINT16_MAX))
+        {
+            CLI_Printf("\r\nscan [first last [clocks]], 7 bits addresses up to 77");
+            return false;
+        }
+    }
+
+    return I2C_ScanForDevices((uint8_t)first, (uint8_t)last, (uint16_t)clocks);
 }
 
 /**
   *--------------------------------------------------------------------------------------------------------------------
-  * @brief  
+  * @brief  Run a list of I2C steps at the current address, from one step to the next in the interrupts
   *
-  * @param  none
+  * @param  arg             Steps separated by '|', the write bytes are written as for 'w'
   *
-  * @retval none
+  * @retval bool
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static void ParseCANCmd(uint8_t *cmd)
+// 'xfer=w 0x10|r 2|w 0x20 0x01|d 500|w 0x22|r 6' reads, starts a conversion and reads it back in one command
+static bool CLI_I2C_ListCmd(char *arg)
 {
+    static I2C_DMA_Op_t ops[I2C_DMA_MAX_OPS];   // Off the console stack, only the console task gets here
+    uint8_t count = 0;
+    size_t used = 0;
+    size_t len;
+    size_t errPos;
+    unsigned long value;
+    char *pStep = arg;
+    char *pNext;
+    char *pEnd;
 
+    while(pStep != NULL)
+    {
+        pNext = strchr(pStep, '|');
+        if(pNext != NULL)
+        {
+            *pNext++ = '\0';
+        }
+        pStep += strspn(pStep, " ");
+        pEnd = pStep + strcspn(pStep, " ");
+        len = pEnd - pStep;
+
+        if(count == I2C_DMA_MAX_OPS)
+        {
+            CLI_Printf("\r\nUp to %u steps", I2C_DMA_MAX_OPS);
+            return false;
+        }
+        ops[count].Len = 0;
+        ops[count].pData = NULL;
+
+        if((len == 1) && (*pStep == 'w'))
+        {
+            ops[count].Type = I2C_DMA_OP_WRITE;
+            if((PAYLOAD_Parse(pEnd, &dataCommand[used], sizeof(dataCommand) - used, &len, &errPos) != PAYLOAD_OK) ||
+               (len == 0))
+            {
+                break;
+            }
+            ops[count].Len = (uint16_t)len;
+            ops[count].pData = &dataCommand[used];
+            used += len;
+        }
+        else if((len == 1) && ((*pStep == 'r') || (*pStep == 'd')))
+        {
+            ops[count].Type = (*pStep == 'r') ? I2C_DMA_OP_READ : I2C_DMA_OP_DELAY;
+            value = strtoul(pEnd, &pEnd, 0);
+            pEnd += strspn(pEnd, " ");
+            if((*pEnd != '\0') || (value == 0) || (value > UINT16_MAX))
+            {
+                break;
+            }
+            ops[count].Len = (uint16_t)value;
+        }
+        else if((len == 2) && (strncmp(pStep, "rs", 2) == 0) && (pEnd[strspn(pEnd, " ")] == '\0'))
+        {
+            ops[count].Type = I2C_DMA_OP_RESTART;
+        }
+        else if((len == 4) && (strncmp(pStep, "stop", 4) == 0) && (pEnd[strspn(pEnd, " ")] == '\0'))
+        {
+            ops[count].Type = I2C_DMA_OP_STOP;
+        }
+        else
+        {
+            break;
+        }
+
+        count++;
+        pStep = pNext;
+    }
+
+    if(pStep != NULL)
+    {
+        CLI_Printf("\r\nStep %u : w <bytes> | r <len> | rs | stop | d <us>", count + 1);
+        return false;
+    }
+
+    return I2C_Cmd_List(ops, count);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Show or change the I2C bus speed
+  *
+  * @param  arg             NULL to show, else a preset name or a frequency, then the rise and fall times in ns
+  *
+  * @retval bool
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+// 'speed=fm+', 'speed=250k 100 10' or 'speed=250000'
+static bool CLI_I2C_Speed(char *arg)
+{
+    unsigned long hz = 0;
+    unsigned long rise = I2C_RISE_NS;
+    unsigned long fall = I2C_FALL_NS;
+    const char *name = NULL;
+    char *pEnd;
+
+    if(arg != NULL)
+    {
+        pEnd = arg + strcspn(arg, " ");
+        if(isdigit((unsigned char)*arg))
+        {
+            hz = strtoul(arg, &pEnd, 10);
+            if((*pEnd == 'k') || (*pEnd == 'K'))
+            {
+                hz *= 1000;
+                pEnd++;
+            }
+        }
+        else
+        {
+            name = arg;
+        }
+
+        if(*pEnd == ' ')
+        {
+            *pEnd++ = '\0';
+            pEnd += strspn(pEnd, " ");
+            rise = (*pEnd != '\0') ? strtoul(pEnd, &pEnd, 10) : rise;
+            pEnd += strspn(pEnd, " ");
+            fall = (*pEnd != '\0') ? strtoul(pEnd, &pEnd, 10) : fall;
+            pEnd += strspn(pEnd, " ");
+        }
+
+        if((*pEnd != '\0') || (rise > 1000) || (fall > 1000) || !I2C_SetSpeed(name, hz, rise, fall))
+        {
+            CLI_Printf("\r\nspeed [std|fast|fm+|Hz [rise fall]], 10k to 1000k, edges up to 1000 ns, bus idle");
+            return false;
+        }
+    }
+
+    I2C_ShowSpeed();
+    return true;
 }
 
 static void GotoMenu(CLI_MENU_PAGE_e page)
@@ -390,48 +691,467 @@ static void GotoMenu(CLI_MENU_PAGE_e page)
     ActualPage = page;
 }
 
-static void ShowHelp(void)
+static void ShowMenuHelp(CLI_MENU_PAGE_e page)
 {
-    char commandStr[16];
+    const CLI_Cmd_t* pCmd;
+
+    CLI_Printf("\r\n\r\n-- %s --", (page == NO_MENU) ? "All menus" : menuStr[page]);
+    for(pCmd = CLI_CmdTable; pCmd < &CLI_CmdTable[NUM_OF_CLI_CMD]; pCmd++)
+    {
+        if(pCmd->Menu == page)
+        {
+            CLI_Printf("\r\n  %-6s%-9s %s", pCmd->pName, CLI_ArgStr[pCmd->Arg], pCmd->pHelp);
+        }
+    }
+}
 
-    CLI_Printf("\r\n----- HELP -----\r\n");
-    CLI_Printf("Main menu commands :\r\n");
-    for(int i=0; i< NUM_OF_CLI_CMD; i++)
+static bool CmdHelp(char *arg)
+{
+    CLI_Printf("\r\n----- HELP -----");
+    ShowMenuHelp(ActualPage);
+    if(ActualPage == MENU_MAIN)
     {
-        sprintf(commandStr, "%s, ", mainCmdArray[i]);
-        CLI_Printf(commandStr);
+        ShowMenuHelp(MENU_I2C);
+        ShowMenuHelp(MENU_SPI);
     }
-    ShowI2CHelp(NULL);
-    ShowSPIHelp(NULL);
+    ShowMenuHelp(NO_MENU);
     CLI_Printf("\r\n\r\n----------------");
+    return true;
+}
+
+static bool CmdEcho(char *arg)
+{
+    CLI_EchoStart();
+    return true;
 }
 
-static void ShowI2CHelp(uint8_t *arg)
+static bool CmdBinary(char *arg)
 {
-    char commandStr[16];
-    CLI_Printf("\r\n\r\n-- I2C Section --\r\n");
-    for(int i=0; i< NUM_OF_I2C_CLI_CMD; i++)
+    // The rest of the macro would run while the requests own the pipe
+    if(CLI_RunDepth != 0)
     {
-        sprintf(commandStr, "%s, ", I2CCmdArray[i]);
-        CLI_Printf(commandStr);
+        CLI_Printf("\r\n'bin' can't run from a macro");
+        return false;
     }
+
+    CLI_DataStart();
+    return true;
+}
+
+static bool CmdLatency(char *arg)
+{
+    LAT_Report();
+    CLI_ShowStack();
+    return true;
+}
+
+static bool CmdUsbStats(char *arg)
+{
+    CLI_ShowUsbStats();
+    return true;
+}
+
+static bool CmdUsbBench(char *arg)
+{
+    CLI_UsbBench();
+    return true;
+}
+
+static bool ShowTime(char *arg)
+{
+    uint64_t us;
+
+    us = TS_GetUs();
+    CLI_Printf("\r\nTime : %lu.%03lu ms, frame %lu (%s)", (uint32_t)(us / 1000), (uint32_t)(us % 1000),
+               (uint32_t)(us / 1000) & TS_FRAME_MASK, TS_IsSynced() ? "host SOF" : "free running");
+    return true;
 }
 
-static void ShowSPIHelp(uint8_t *arg)
+static bool ShowDisk(char *arg)
 {
-    char commandStr[16];
-    CLI_Printf("\r\n\r\n-- SPI Section --\r\n");
-    for(int i=0; i< NUM_OF_SPI_CLI_CMD; i++)
+    static const char* ownerStr[] = {"nobody", "firmware", "host"};
+    DWORD freeClust;
+    FATFS *fs;
+
+    CLI_Printf("\r\nDisk : %lu KB, owned by %s, %lu erases%s", (uint32_t)(DISK_FLASH_SIZE / 1024),
+               ownerStr[DISK_GetOwner()], DISK_GetErases(), DISK_IsDirty() ? ", cache dirty" : "");
+
+    if((DISK_GetOwner() == DISK_OWNER_FW) && (f_getfree(USERPath, &freeClust, &fs) == FR_OK))
     {
-        sprintf(commandStr, "%s, ", SPICmdArray[i]);
-        CLI_Printf(commandStr);
+        CLI_Printf("\r\nFree : %lu KB", (freeClust * fs->csize * DISK_SECTOR_SIZE) / 1024);
     }
+    return true;
 }
+
+static bool MountDisk(char *arg)
+{
+    FRESULT res;
+
+    res = FATFS_Mount();
+    if(res == FR_OK)
+    {
+        CLI_Printf("\r\nVolume mounted, the host sees no medium until eject");
+    }
+    else if(res == FR_NOT_READY)
+    {
+        CLI_Printf("\r\nVolume used by the host, eject it there first");
+    }
+    else
+    {
+        CLI_Printf("\r\nMount failed (%d)", res);
+    }
+    return (res == FR_OK);
+}
+
+static bool EjectDisk(char *arg)
+{
+    if(DISK_GetOwner() != DISK_OWNER_FW)
+    {
+        CLI_Printf("\r\nVolume not mounted");
+        return false;
+    }
+
+    FATFS_Eject();
+    CLI_Printf("\r\nVolume %s", (DISK_GetOwner() == DISK_OWNER_HOST) ? "handed to the host" : "unmounted");
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run the commands of a macro back to back in the current menu
+  *
+  *         Each command is copied out of the macro store and executed directly, the first failure stops the macro.
+  *         The name is kept per depth since a nested run overwrites the command buffer it came from. A command
+  *         taking a CLI_ARG_LINE argument gets the rest of the macro, as on the console.
+  *
+  * @param  arg             Macro name
+  *
+  * @retval bool            false if the macro does not exist or a command failed
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static bool CmdRun(char *arg)
+{
+    const CLI_Cmd_t* pCmd;
+    const char* pBody;
+    char* pName;
+    uint16_t Len;
+    uint16_t Pos;
+    uint16_t CmdLen;
+    uint16_t NameLen;
+    uint16_t Skip;
+    uint16_t Count;
+    uint64_t Start;
+    bool Ok;
+
+    pBody = MACRO_Get(arg, &Len);
+    if(pBody == NULL)
+    {
+        CLI_Printf("\r\nNo macro '%s'", arg);
+        return false;
+    }
+
+    if(CLI_RunDepth >= CLI_RUN_MAX_DEPTH)
+    {
+        CLI_Printf("\r\nMacros nested too deep");
+        return false;
+    }
+
+    // MACRO_Get found it, so the name fits
+    pName = CLI_RunName[CLI_RunDepth];
+    strcpy(pName, arg);
+
+    CLI_RunDepth++;
+    Start = TS_GetUs();
+    Count = 0;
+    Ok = true;
+
+    for(Pos = 0; Ok && (Pos < Len); Pos += CmdLen + 1)
+    {
+        for(Skip = 0; ((Pos + Skip) < Len) && (pBody[Pos + Skip] == ' '); Skip++);
+        for(NameLen = 0; ((Pos + Skip + NameLen) < Len) && (strchr("= ;", pBody[Pos + Skip + NameLen]) == NULL); NameLen++);
+
+        // Same rule as the console, a command taking the whole line keeps the ';' that follow it
+        pCmd = CLI_MENU_Lookup(&pBody[Pos + Skip], NameLen);
+        if((pCmd != NULL) && (pCmd->Arg == CLI_ARG_LINE))
+        {
+            CmdLen = Len - Pos;
+        }
+        else
+        {
+            for(CmdLen = 0; ((Pos + CmdLen) < Len) && (pBody[Pos + CmdLen] != ';'); CmdLen++);
+        }
+
+        if(CmdLen >= CLI_RUN_CMD_SIZE)
+        {
+            CLI_Printf("\r\nCommand %u of %s too long", Count + 1, pName);
+            Ok = false;
+            break;
+        }
+
+        memcpy(CLI_RunCmd, &pBody[Pos], CmdLen);
+        CLI_RunCmd[CmdLen] = '\0';
+        Count++;
+        Ok = CLI_MENU_Execute(CLI_RunCmd);
+
+        // A command may have changed the macros
+        pBody = MACRO_Get(pName, &Len);
+        if(pBody == NULL)
+        {
+            break;
+        }
+    }
+
+    CLI_RunDepth--;
+
+    if(!Ok)
+    {
+        CLI_Printf("\r\n%s stopped at command %u", pName, Count);
+        return false;
+    }
+
+    CLI_Printf("\r\n%s : %u commands in %lu us", pName, Count, (uint32_t)(TS_GetUs() - Start));
+    return true;
+}
+
+static bool CmdDefine(char *arg)
+{
+    char *pBody;
+
+    pBody = arg + strcspn(arg, " =");
+    if(*pBody != '\0')
+    {
+        *pBody++ = '\0';
+    }
+
+    if(!MACRO_Define(arg, pBody))
+    {
+        CLI_Printf("\r\nCan't define '%s', %u bytes left", arg, MACRO_GetFree());
+        return false;
+    }
+
+    return true;
+}
+
+static bool CmdRecord(char *arg)
+{
+    if(!MACRO_RecordStart(arg))
+    {
+        CLI_Printf("\r\nCan't record '%s'", arg);
+        return false;
+    }
+
+    CLI_Printf("\r\nRecording %s, end to stop", arg);
+    return true;
+}
+
+static bool CmdEnd(char *arg)
+{
+    if(MACRO_GetRecording() == NULL)
+    {
+        CLI_Printf("\r\nNot recording");
+        return false;
+    }
+
+    MACRO_RecordStop();
+    return true;
+}
+
+static bool CmdDelete(char *arg)
+{
+    if(!MACRO_Delete(arg))
+    {
+        CLI_Printf("\r\nNo macro '%s'", arg);
+        return false;
+    }
+
+    return true;
+}
+
+static bool CmdMacros(char *arg)
+{
+    const char* pName;
+    const char* pBody;
+    uint16_t Len;
+    uint8_t i;
+
+    for(i = 0; i < MACRO_GetCount(); i++)
+    {
+        pName = MACRO_GetByIndex(i, &pBody, &Len);
+        if(pName != NULL)
+        {
+            CLI_Printf("\r\n  %-11s %4u  %.*s%s", pName, Len, (Len > 48) ? 48 : Len, pBody, (Len > 48) ? "..." : "");
+        }
+    }
+    CLI_Printf("\r\n%u bytes free%s%s", MACRO_GetFree(), MACRO_GetRecording() ? ", recording " : "",
+               MACRO_GetRecording() ? MACRO_GetRecording() : "");
+
+    return true;
+}
+
+static bool CmdMacroSave(char *arg)
+{
+    FRESULT res;
+
+    // The deepest stack the console sees, and 'mload' rewrites the pool a macro runs from
+    if(CLI_RunDepth != 0)
+    {
+        CLI_Printf("\r\n'msave' can't run from a macro");
+        return false;
+    }
+
+    res = MACRO_Save();
+    if(res != FR_OK)
+    {
+        CLI_Printf("\r\nSave failed (%d), mount the volume first", res);
+    }
+
+    return (res == FR_OK);
+}
+
+static bool CmdMacroLoad(char *arg)
+{
+    FRESULT res;
+
+    // The deepest stack the console sees, and 'mload' rewrites the pool a macro runs from
+    if(CLI_RunDepth != 0)
+    {
+        CLI_Printf("\r\n'mload' can't run from a macro");
+        return false;
+    }
+
+    res = MACRO_Load();
+    if(res != FR_OK)
+    {
+        CLI_Printf("\r\nLoad failed (%d)", res);
+    }
+
+    return (res == FR_OK);
+}
+
+static bool CmdVm(char *arg)
+{
+    return VM_BOARD_Run(arg, strlen(arg));
+}
+
+// The whole body is one sequence, its ';' only separate words
+static bool CmdVmRun(char *arg)
+{
+    const char* pBody;
+    uint16_t Len;
+
+    pBody = MACRO_Get(arg, &Len);
+    if(pBody == NULL)
+    {
+        CLI_Printf("\r\nNo macro '%s'", arg);
+        return false;
+    }
+
+    return VM_BOARD_Run(pBody, Len);
+}
+
+// Runs in the current menu, menu changes are refused since the job would leave the user elsewhere
+static bool CmdEvery(char *arg)
+{
+    const CLI_Cmd_t* pCmd;
+    uint32_t Period;
+    char *pEnd;
+    int8_t Id;
+
+    Period = strtoul(arg, &pEnd, 0);
+    while(*pEnd == ' ')
+    {
+        pEnd++;
+    }
+
+    if((Period == 0) || (*pEnd == '\0'))
+    {
+        CLI_Printf("\r\nUsage: every <ms> <command>");
+        return false;
+    }
+
+    pCmd = CLI_MENU_Lookup(pEnd, strcspn(pEnd, "= "));
+    if(pCmd == NULL)
+    {
+        CLI_Printf("\r\nUnknown command '%.*s'", (int)strcspn(pEnd, "= "), pEnd);
+        return false;
+    }
+
+    if(pCmd->Goto != NO_MENU)
+    {
+        CLI_Printf("\r\n'%s' changes the menu, it can't be repeated", pCmd->pName);
+        return false;
+    }
+
+    if(pCmd->Callback == CmdBinary)
+    {
+        CLI_Printf("\r\n'%s' takes the console over, it can't be repeated", pCmd->pName);
+        return false;
+    }
+
+    if((pCmd->Callback == CmdMacroSave) || (pCmd->Callback == CmdMacroLoad))
+    {
+        CLI_Printf("\r\n'%s' goes through the volume, it can't be repeated", pCmd->pName);
+        return false;
+    }
+
+    Id = SCHED_Add(Period, ActualPage, pEnd);
+    if(Id == SCHED_NONE)
+    {
+        CLI_Printf("\r\nNo free job or command longer than %u", SCHED_CMD_SIZE - 1);
+        return false;
+    }
+
+    CLI_Printf("\r\nJob %d: %s every %lu ms", Id, pEnd, Period);
+    return true;
+}
+
+static bool CmdJobs(char *arg)
+{
+    SCHED_Info_t Info;
+    uint8_t Id;
+
+    CLI_Printf("\r\n id  period     runs  overrun   errors   late us jitter us    run us  command");
+    for(Id = 0; Id < SCHED_MAX_JOBS; Id++)
+    {
+        if(SCHED_GetInfo(Id, &Info))
+        {
+            CLI_Printf("\r\n%3u %7lu %8lu %8lu %8lu %9lu %9lu %9lu  %s",
+                       Id, Info.PeriodMs, Info.Runs, Info.Overruns, Info.Errors,
+                       Info.MaxLate, Info.MaxJitter, Info.MaxRun, Info.pCmd);
+        }
+    }
+
+    return true;
+}
+
+static bool CmdStop(char *arg)
+{
+    unsigned long Id;
+    char *pEnd;
+
+    if((arg == NULL) || (*arg == '\0'))
+    {
+        SCHED_StopAll();
+        return true;
+    }
+
+    // A bad number would otherwise stop job 0, or the job its low byte names
+    Id = strtoul(arg, &pEnd, 0);
+    if((pEnd == arg) || (*pEnd != '\0') || (Id >= SCHED_MAX_JOBS) || !SCHED_Stop((uint8_t)Id))
+    {
+        CLI_Printf("\r\nNo job %s", arg);
+        return false;
+    }
+
+    return true;
+}
+
 /* Global Functions -------------------------------------------------------------------------------------------------*/
 
 /**
   *--------------------------------------------------------------------------------------------------------------------
-  * @brief  
+  * @brief  Build the hash index of the command registry, names are stored in lower case
   *
   * @param  none
   *
@@ -439,34 +1159,129 @@ static void ShowSPIHelp(uint8_t *arg)
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-void CLI_MENU_CmdParse(uint8_t *cmd)
+void CLI_MENU_Init(void)
 {
-    switch(ActualPage)
+    uint8_t Slot;
+    uint8_t i;
+
+    memset(CLI_CmdHash, CLI_HASH_EMPTY, sizeof(CLI_CmdHash));
+    for(i = 0; i < NUM_OF_CLI_CMD; i++)
     {
-        case MENU_MAIN:
-            ParseMainCmd(cmd);
-            break;
-        case MENU_CONFIG:
-            ParseConfigCmd(cmd);
-            break;
-        case MENU_UART:
-            ParseUartCmd(cmd);
-            break;
-        case MENU_I2C:
-            ParseI2CCmd(cmd);
-            break;
-        case MENU_SPI:
-            ParseSpiCmd(cmd);
-            break;
-        case MENU_CAN:
-            ParseCANCmd(cmd);
-            break;
-        case MENU_ECHO:
-            
+        Slot = CLI_MENU_Hash(CLI_CmdTable[i].Menu, CLI_CmdTable[i].pName, strlen(CLI_CmdTable[i].pName));
+        while(CLI_CmdHash[Slot] != CLI_HASH_EMPTY)
+        {
+            Slot = (Slot + 1) & (CLI_HASH_SIZE - 1);
+        }
+        CLI_CmdHash[Slot] = i;
+    }
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run a command line received by the console
+  *
+  *         The line may hold several commands separated by ';', ex. "addr=0x50;w=0 0;wr=0 0x10". They run back to back
+  *         in one pass, each in the menu left by the previous one, and the first failure stops the batch. A command
+  *         taking a CLI_ARG_LINE argument gets the rest of the line.
+  *
+  * @param  cmd             Null terminated command line, modified
+  *
+  * @retval bool            false if a command failed
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool CLI_MENU_CmdParse(uint8_t *cmd)
+{
+    char *pLine;
+    char *pNext;
+    uint16_t Count;
+    const CLI_Cmd_t* pCmd;
+    const char *pRecording;
+    bool Recorded;
+    bool Ok;
+
+    pLine = (char*)cmd;
+    Count = 0;
+
+    while(pLine != NULL)
+    {
+        while(*pLine == ' ')
+        {
+            pLine++;
+        }
+
+        // A command taking the whole line keeps the ';' that follow it
+        pCmd = CLI_MENU_Lookup(pLine, strcspn(pLine, "= ;"));
+        pNext = ((pCmd != NULL) && (pCmd->Arg == CLI_ARG_LINE)) ? NULL : strchr(pLine, ';');
+        if(pNext != NULL)
+        {
+            *pNext++ = '\0';
+        }
+
+        // Stored before it runs since running modifies it, taken back if it fails or ends the recording
+        Recorded = false;
+        pRecording = MACRO_GetRecording();
+        if((pRecording != NULL) && (*pLine != '\0'))
+        {
+            Recorded = MACRO_RecordCmd(pLine);
+            if(!Recorded)
+            {
+                CLI_Printf("\r\nMacro full, %s not recorded", pLine);
+            }
+        }
+
+        Count++;
+        Ok = CLI_MENU_Execute(pLine);
+
+        if(Recorded && (!Ok || (MACRO_GetRecording() != pRecording)))
+        {
+            MACRO_RecordUndo();
+        }
+
+        if(!Ok)
+        {
+            if((pNext != NULL) && (*pNext != '\0'))
+            {
+                CLI_Printf("\r\nStopped at command %u, the rest of the line is skipped", Count);
+            }
+            return false;
+        }
+
+        // Raw loopback or binary requests own the pipe from here, what follows on the line is not a command
+        if((ActualPage == MENU_ECHO) || !CLI_IsTextMode())
+        {
             break;
+        }
 
+        pLine = pNext;
     }
 
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run one command in a given menu, without recording it, then come back to the menu of the user
+  *
+  * @param  Menu            Menu to look the command up in
+  * @param  pCmd            Null terminated command, modified
+  *
+  * @retval bool            false if the command failed
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool CLI_MENU_ExecIn(uint8_t Menu, char *pCmd)
+{
+    CLI_MENU_PAGE_e Actual = ActualPage;
+    CLI_MENU_PAGE_e Previous = PreviousPage;
+    bool Ok;
+
+    ActualPage = (CLI_MENU_PAGE_e)Menu;
+    Ok = CLI_MENU_Execute(pCmd);
+    ActualPage = Actual;
+    PreviousPage = Previous;
+
+    return Ok;
 }
 
 char* CLI_MENU_GetMenuStr (void)
@@ -485,52 +1300,32 @@ typedef enum __Data_Type_e
     DATA_HEX,
 }Data_Type_e;
 
-uint8_t parseDataStr(char *str)
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Parse the payload of a bus command into dataCommand, see payload.c for the syntax
+  *
+  * @param  str             Null terminated argument, not modified
+  *
+  * @retval uint16_t        Payload length, 0 on error
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t parseDataStr(char *str)
 {
-    uint8_t len;
-    char *strPtr;
-    const char delim[] = DATA_DELIMITERS;
-
-    dataCommandIdx = 0;
-    strPtr = strtok(str, delim);
+    PAYLOAD_Status_e status;
+    size_t len;
+    size_t errPos;
 
-    //while(strPtr < (str+strlen(str)))
+    status = PAYLOAD_Parse(str, dataCommand, sizeof(dataCommand), &len, &errPos);
+    if(status != PAYLOAD_OK)
     {
-        while ( strPtr != NULL )
-        {
-            len = strlen(strPtr);
-            if (len == 1) // Single digit character
-            {
-                dataCommand[dataCommandIdx] = (uint8_t)atoi(strPtr);
-        	    dataCommandIdx ++;
-            }
-            else if(len == 2) // Double digit hexa character without 0x prefix
-            {
-                dataCommand[dataCommandIdx] = STR_atoh8(*strPtr, *(strPtr+1));
-                dataCommandIdx++;
-            }
-            else if((*strPtr == '0' && *(strPtr+1) == 'x') || (*strPtr == '0' && *(strPtr+1) == 'X'))
-            {
-                strPtr += 2;
-                dataCommand[dataCommandIdx] = STR_atoh8(*strPtr, *(strPtr+1));
-                dataCommandIdx++;
-            }
-            else
-            {
-            	// I'm trying to be nice but ... this is an invalid command
-            	CLI_Printf("Invalid command...\r\n");
-            	return 0;
-            }
-            strPtr = strtok(NULL, delim);
-        }
-    }
-    // DEBUG PRINT UNDERSTOOD COMMAND
-    CLI_Printf("Data to be sent :\r\n");
-    for(int i=0; i< dataCommandIdx; i++)
-    {
-        CLI_Printf("%02x ", dataCommand[i]);
+        CLI_Printf("Invalid payload, %s at '%.12s'\r\n", PAYLOAD_StatusStr(status), &str[errPos]);
+        return 0;
     }
-    CLI_Printf("\r\n");
-    // Return the len to send
-    return dataCommandIdx;
+
+    // Only the first line of a long payload is shown back
+    CLI_Printf("Data to be sent : %u bytes\r\n", (uint16_t)len);
+    CLI_Dump(0, dataCommand, (len < CLI_PAYLOAD_SHOWN) ? len : CLI_PAYLOAD_SHOWN);
+
+    return (uint16_t)len;
 }
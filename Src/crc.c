@@ -112,6 +112,13 @@ void HAL_CRC_MspDeInit(CRC_HandleTypeDef* crcHandle)
 
 /* USER CODE BEGIN 1 */
 
+// CRC-32/MPEG-2 of a byte buffer: polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no reflection, no final xor
+uint32_t CRC_Calc(const uint8_t *pData, uint32_t Len)
+{
+  // Bytes format, the buffer is read byte by byte whatever its alignment
+  return HAL_CRC_Calculate(&hcrc, (uint32_t*)pData, Len);
+}
+
 /* USER CODE END 1 */
 
 /**
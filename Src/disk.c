@@ -0,0 +1,585 @@
+/**********************************************************************************************************************
+ * @file    disk.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Internal flash block device shared by FatFs and the USB mass storage interface
+ *
+ *          The volume lives in the upper 64 KB of the flash. A flash page holds 4 sectors, so writes go through a
+ *          one page cache that is only programmed back when another page is needed or on DISK_Sync. A page is only
+ *          erased when a programmed half word has to change, appending to a file mostly programs erased cells.
+ *
+ *          Ownership makes sure the firmware (FatFs) and the host (USB mass storage) never mount the volume at the
+ *          same time. The host gets the volume when the interface is configured and the volume is free, and gives it
+ *          back when it ejects the medium or leaves. The firmware can only take a free volume and hands it straight
+ *          to the host when it releases it. Only the owner calls the sector functions, so they need no lock.
+ *
+ *          A clean cache holds nothing the flash does not, so it is lent to the stream Tx ring while the host reads
+ *          the stream. Reads still come straight from the flash, writes fail until the cache is given back. Taking
+ *          the cache for a write and lending it are done with the interrupts masked, the stream asks from the USB
+ *          interrupt.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "stm32f0xx_hal.h"
+#include "nOS.h"
+#include "disk.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define DISK_NO_PAGE            0xFFFFFFFFU
+
+#if (DISK_PAGE_SIZE != FLASH_PAGE_SIZE)
+#error "DISK_PAGE_SIZE must match the flash page"
+#endif
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+static uint16_t                 DISK_Cache[DISK_PAGE_SIZE / 2];
+static uint32_t                 DISK_CachePage;
+static bool                     DISK_CacheDirty;
+static bool                     DISK_CacheLent;
+static uint32_t                 DISK_Erases;
+
+static volatile disk_owner_e    DISK_Owner;
+static volatile bool            DISK_HostAttached;
+static volatile uint32_t        DISK_Generation;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Program the cached page back in flash if it was modified
+  *
+  * @param  none
+  *
+  * @retval bool            false on a flash error, the page stays dirty
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static bool DISK_Flush(void)
+{
+    FLASH_EraseInitTypeDef  Erase;
+    const uint16_t         *pFlash;
+    uint32_t                Address;
+    uint32_t                PageError;
+    bool                    NeedErase;
+    bool                    Success;
+    uint16_t                i;
+
+    if(!DISK_CacheDirty)
+    {
+        return true;
+    }
+
+    Address   = DISK_FLASH_BASE + (DISK_CachePage * DISK_PAGE_SIZE);
+    pFlash    = (const uint16_t *)Address;
+    NeedErase = false;
+    Success   = true;
+
+    // Programming can only clear bits, anything else needs the whole page erased
+    for(i = 0; i < (DISK_PAGE_SIZE / 2); i++)
+    {
+        if((pFlash[i] != DISK_Cache[i]) && (pFlash[i] != 0xFFFF))
+        {
+            NeedErase = true;
+            break;
+        }
+    }
+
+    HAL_FLASH_Unlock();
+
+    if(NeedErase)
+    {
+        Erase.TypeErase   = FLASH_TYPEERASE_PAGES;
+        Erase.PageAddress = Address;
+        Erase.NbPages     = 1;
+
+        if(HAL_FLASHEx_Erase(&Erase, &PageError) != HAL_OK)
+        {
+            Success = false;
+        }
+        DISK_Erases++;
+    }
+
+    for(i = 0; (i < (DISK_PAGE_SIZE / 2)) && Success; i++)
+    {
+        if(pFlash[i] != DISK_Cache[i])
+        {
+            if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, Address + (i * 2), DISK_Cache[i]) != HAL_OK)
+            {
+                Success = false;
+            }
+        }
+    }
+
+    HAL_FLASH_Lock();
+
+    if(Success)
+    {
+        DISK_CacheDirty = false;
+    }
+
+    return Success;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Bring a page in the cache to modify it, the previous one is programmed back first
+  *
+  *         The cache is marked as modified before it is touched, a modified cache is never lent.
+  *
+  * @param  Page            Page index in the volume
+  *
+  * @retval bool            false if the previous page could not be saved or the cache is lent
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static bool DISK_Load(uint32_t Page)
+{
+    nOS_StatusReg   sr;
+    bool            Cached;
+
+    nOS_EnterCritical(sr);
+    Cached = (DISK_CachePage == Page);
+    if(Cached)
+    {
+        DISK_CacheDirty = true;
+    }
+    nOS_LeaveCritical(sr);
+
+    if(Cached)
+    {
+        return true;
+    }
+
+    if(!DISK_Flush())
+    {
+        return false;
+    }
+
+    nOS_EnterCritical(sr);
+    Cached = !DISK_CacheLent;
+    if(Cached)
+    {
+        DISK_CachePage  = Page;
+        DISK_CacheDirty = true;
+    }
+    nOS_LeaveCritical(sr);
+
+    if(!Cached)
+    {
+        return false;
+    }
+
+    memcpy(DISK_Cache, (const void *)(DISK_FLASH_BASE + (Page * DISK_PAGE_SIZE)), DISK_PAGE_SIZE);
+
+    return true;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Start with an empty cache and a free volume
+  *
+  * @param  none
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void DISK_Init(void)
+{
+    DISK_CachePage    = DISK_NO_PAGE;
+    DISK_CacheDirty   = false;
+    DISK_CacheLent    = false;
+    DISK_Erases       = 0;
+    DISK_Owner        = DISK_OWNER_NONE;
+    DISK_HostAttached = false;
+    DISK_Generation   = 0;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Take the volume
+  *
+  * @param  Owner           Side asking for the volume
+  *
+  * @retval bool            true if Owner now has the volume, false if the other side holds it
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool DISK_Acquire(disk_owner_e Owner)
+{
+    nOS_StatusReg   sr;
+    bool            Success;
+
+    nOS_EnterCritical(sr);
+    Success = (DISK_Owner == Owner) || (DISK_Owner == DISK_OWNER_NONE);
+    if(Success && (DISK_Owner != Owner))
+    {
+        DISK_Owner = Owner;
+        if(Owner == DISK_OWNER_HOST)
+        {
+            DISK_Generation++;
+        }
+    }
+    nOS_LeaveCritical(sr);
+
+    return Success;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Flush the cache and give up the volume
+  *
+  *         What the firmware releases goes to the host right away when it is attached.
+  *
+  * @param  Owner           Side releasing the volume, nothing happens if it does not hold it
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void DISK_Release(disk_owner_e Owner)
+{
+    nOS_StatusReg   sr;
+
+    if(DISK_Owner != Owner)
+    {
+        return;
+    }
+
+    DISK_Sync();
+
+    nOS_EnterCritical(sr);
+    if((Owner == DISK_OWNER_FW) && DISK_HostAttached)
+    {
+        DISK_Owner = DISK_OWNER_HOST;
+        DISK_Generation++;
+    }
+    else
+    {
+        DISK_Owner = DISK_OWNER_NONE;
+    }
+    nOS_LeaveCritical(sr);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Mass storage interface configured or gone, called from the USB interrupt
+  *
+  *         Nothing is flushed here, a host that leaves keeps the volume until DISK_HostDetach runs in a thread.
+  *
+  * @param  Attached        true when the host can access the interface
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void DISK_HostAttach(bool Attached)
+{
+    DISK_HostAttached = Attached;
+
+    if(Attached)
+    {
+        DISK_Acquire(DISK_OWNER_HOST);
+    }
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Flush the cache and free the volume of a host that left, from a thread since it may program the flash
+  *
+  * @param  none
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void DISK_HostDetach(void)
+{
+    nOS_StatusReg   sr;
+
+    if(DISK_HostAttached || (DISK_Owner != DISK_OWNER_HOST))
+    {
+        return;
+    }
+
+    DISK_Sync();
+
+    // The host may be back already, it then keeps the volume
+    nOS_EnterCritical(sr);
+    if(!DISK_HostAttached && (DISK_Owner == DISK_OWNER_HOST))
+    {
+        DISK_Owner = DISK_OWNER_NONE;
+    }
+    nOS_LeaveCritical(sr);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Current owner of the volume
+  *
+  * @param  none
+  *
+  * @retval disk_owner_e    Owner
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+disk_owner_e DISK_GetOwner(void)
+{
+    return DISK_Owner;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Counter bumped every time the host gets the volume, tells it the medium may have changed
+  *
+  * @param  none
+  *
+  * @retval uint32_t        Generation
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint32_t DISK_GetGeneration(void)
+{
+    return DISK_Generation;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Get a sector to read in place, straight from the flash unless its page is cached
+  *
+  * @param  Sector          Sector index
+  *
+  * @retval const uint8_t*  DISK_SECTOR_SIZE bytes, valid until the next write, NULL when out of range
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+const uint8_t *DISK_MapRead(uint32_t Sector)
+{
+    uint32_t    Page;
+    uint32_t    Offset;
+
+    if(Sector >= DISK_SECTOR_COUNT)
+    {
+        return NULL;
+    }
+
+    Page   = Sector / DISK_SECTORS_PER_PAGE;
+    Offset = (Sector % DISK_SECTORS_PER_PAGE) * DISK_SECTOR_SIZE;
+
+    // A clean cache matches the flash, and may be lent while the sector is still being sent
+    if((DISK_CachePage == Page) && DISK_CacheDirty)
+    {
+        return (const uint8_t *)DISK_Cache + Offset;
+    }
+
+    return (const uint8_t *)(DISK_FLASH_BASE + (Page * DISK_PAGE_SIZE) + Offset);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Get a sector to write in place, it is loaded in the cache and marked as modified
+  *
+  * @param  Sector          Sector index
+  *
+  * @retval uint8_t*        DISK_SECTOR_SIZE bytes in the cache, NULL when out of range, on a flash error or while
+  *                         the cache is lent
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint8_t *DISK_MapWrite(uint32_t Sector)
+{
+    uint32_t    Page;
+
+    if(Sector >= DISK_SECTOR_COUNT)
+    {
+        return NULL;
+    }
+
+    Page = Sector / DISK_SECTORS_PER_PAGE;
+    if(!DISK_Load(Page))
+    {
+        return NULL;
+    }
+
+    return (uint8_t *)DISK_Cache + ((Sector % DISK_SECTORS_PER_PAGE) * DISK_SECTOR_SIZE);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Copy sectors out of the volume
+  *
+  * @param  Sector          First sector
+  * @param  pBuff           Destination, Count * DISK_SECTOR_SIZE bytes
+  * @param  Count           Number of sectors
+  *
+  * @retval bool            false when out of range
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool DISK_Read(uint32_t Sector, uint8_t *pBuff, uint32_t Count)
+{
+    const uint8_t *pSector;
+
+    while(Count--)
+    {
+        pSector = DISK_MapRead(Sector++);
+        if(pSector == NULL)
+        {
+            return false;
+        }
+
+        memcpy(pBuff, pSector, DISK_SECTOR_SIZE);
+        pBuff += DISK_SECTOR_SIZE;
+    }
+
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Copy sectors in the volume, the last page stays in the cache until DISK_Sync
+  *
+  * @param  Sector          First sector
+  * @param  pBuff           Source, Count * DISK_SECTOR_SIZE bytes
+  * @param  Count           Number of sectors
+  *
+  * @retval bool            false when out of range or on a flash error
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool DISK_Write(uint32_t Sector, const uint8_t *pBuff, uint32_t Count)
+{
+    uint8_t *pSector;
+
+    while(Count--)
+    {
+        pSector = DISK_MapWrite(Sector++);
+        if(pSector == NULL)
+        {
+            return false;
+        }
+
+        memcpy(pSector, pBuff, DISK_SECTOR_SIZE);
+        pBuff += DISK_SECTOR_SIZE;
+    }
+
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Program the cached page back in flash
+  *
+  * @param  none
+  *
+  * @retval bool            false on a flash error
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool DISK_Sync(void)
+{
+    return DISK_Flush();
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Tell if the cache holds data not yet in flash
+  *
+  * @param  none
+  *
+  * @retval bool            true when DISK_Sync has something to do
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool DISK_IsDirty(void)
+{
+    return DISK_CacheDirty;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Tell if mapping a sector for writing has to program the cached page back first
+  *
+  * @param  Sector          Sector index
+  *
+  * @retval bool            true when DISK_MapWrite would erase or program the flash
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool DISK_NeedsFlush(uint32_t Sector)
+{
+    return DISK_CacheDirty && (DISK_CachePage != (Sector / DISK_SECTORS_PER_PAGE));
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Lend the page cache as a plain buffer, the volume stays readable but can't be written until it is back
+  *
+  * @param  none
+  *
+  * @retval uint8_t*        DISK_PAGE_SIZE bytes, NULL while the cache holds data not yet in flash or is already lent
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint8_t *DISK_LendCache(void)
+{
+    nOS_StatusReg   sr;
+    uint8_t        *pBuff;
+
+    pBuff = NULL;
+
+    nOS_EnterCritical(sr);
+    if(!DISK_CacheDirty && !DISK_CacheLent)
+    {
+        DISK_CacheLent = true;
+        DISK_CachePage = DISK_NO_PAGE;
+        pBuff          = (uint8_t *)DISK_Cache;
+    }
+    nOS_LeaveCritical(sr);
+
+    return pBuff;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Give the page cache back, nothing of what the borrower left is kept
+  *
+  * @param  none
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void DISK_ReturnCache(void)
+{
+    DISK_CacheLent = false;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Number of page erases since boot, for wear monitoring
+  *
+  * @param  none
+  *
+  * @retval uint32_t        Erases
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint32_t DISK_GetErases(void)
+{
+    return DISK_Erases;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -64,6 +64,7 @@ void MX_FATFS_Init(void)
 
   /* USER CODE BEGIN Init */
   /* additional user code for init */     
+  DISK_Init();
   /* USER CODE END Init */
 }
 
@@ -80,7 +81,48 @@ DWORD get_fattime(void)
 }
 
 /* USER CODE BEGIN Application */
-     
+
+/**
+  * @brief  Take the capture volume from the host side and mount it,
+  *         a blank volume is formatted first
+  * @param  None
+  * @retval FR_NOT_READY while the host holds the volume
+  */
+FRESULT FATFS_Mount(void)
+{
+  FRESULT res;
+
+  res = f_mount(&USERFatFS, USERPath, 1);
+  if (res == FR_NO_FILESYSTEM)
+  {
+    /* Super floppy, cluster size picked by FatFs */
+    res = f_mkfs(USERPath, 1, 0);
+    if (res == FR_OK)
+    {
+      res = f_mount(&USERFatFS, USERPath, 1);
+    }
+  }
+
+  if (res != FR_OK)
+  {
+    f_mount(NULL, USERPath, 0);
+    DISK_Release(DISK_OWNER_FW);
+  }
+
+  return res;
+}
+
+/**
+  * @brief  Unmount the capture volume and hand it to the host
+  * @param  None
+  * @retval None
+  */
+void FATFS_Eject(void)
+{
+  f_mount(NULL, USERPath, 0);
+  DISK_Release(DISK_OWNER_FW);
+}
+
 /* USER CODE END Application */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
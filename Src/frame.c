@@ -0,0 +1,184 @@
+/**********************************************************************************************************************
+ * @file    frame.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   COBS packet framing
+ *
+ *          Consistent Overhead Byte Stuffing removes every zero from a packet at the cost of one byte per 254, so a
+ *          zero can delimit the frames. Each block starts with a code byte, the distance to the next zero, 0xFF
+ *          meaning 254 bytes with no zero after them. A receiver that lost track resynchronizes on the next
+ *          delimiter, and an empty frame is only a delimiter, which the decoder ignores.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include "frame.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define FRAME_MAX_CODE          0xFF
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+static void FRAME_Reset(FRAME_Decoder_t* pDec)
+{
+    pDec->Len      = 0;
+    pDec->Left     = 0;
+    pDec->Zero     = false;
+    pDec->Overflow = false;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Attach the buffer receiving the decoded packets, the next byte starts a frame
+  *
+  * @param  pDec            Decoder to initialize
+  * @param  pBuff           Decoded packet
+  * @param  Size            Largest packet, longer frames are dropped
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void FRAME_DecoderInit(FRAME_Decoder_t* pDec, uint8_t* pBuff, uint16_t Size)
+{
+    pDec->pBuff = pBuff;
+    pDec->Size  = Size;
+    FRAME_Reset(pDec);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Decode received bytes, stopping after the first delimiter
+  *
+  *         The packet stays in the buffer until the next call, which starts the following frame.
+  *
+  * @param  pDec            Decoder
+  * @param  pData           Received bytes
+  * @param  Len             Number of bytes
+  * @param  pFrameLen       Length of the decoded packet, FRAME_NONE or FRAME_DROPPED
+  *
+  * @retval uint16_t        Bytes used, the delimiter included
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t FRAME_Decode(FRAME_Decoder_t* pDec, const uint8_t* pData, uint16_t Len, int32_t* pFrameLen)
+{
+    uint16_t i;
+    uint8_t  Byte;
+
+    *pFrameLen = FRAME_NONE;
+
+    for(i = 0; i < Len; i++)
+    {
+        Byte = pData[i];
+
+        if(Byte == FRAME_DELIMITER)
+        {
+            // The zero after the last block is not part of the packet
+            if(pDec->Overflow || (pDec->Left != 0))
+            {
+                *pFrameLen = FRAME_DROPPED;
+            }
+            else if(pDec->Len > 0)
+            {
+                *pFrameLen = pDec->Len;
+            }
+            FRAME_Reset(pDec);
+
+            if(*pFrameLen != FRAME_NONE)
+            {
+                return i + 1;
+            }
+        }
+        else if(pDec->Left == 0)
+        {
+            if(pDec->Zero)
+            {
+                if(pDec->Len < pDec->Size)
+                {
+                    pDec->pBuff[pDec->Len++] = 0;
+                }
+                else
+                {
+                    pDec->Overflow = true;
+                }
+            }
+            pDec->Left = Byte - 1;
+            pDec->Zero = (Byte != FRAME_MAX_CODE);
+        }
+        else
+        {
+            if(pDec->Len < pDec->Size)
+            {
+                pDec->pBuff[pDec->Len++] = Byte;
+            }
+            else
+            {
+                pDec->Overflow = true;
+            }
+            pDec->Left--;
+        }
+    }
+
+    return Len;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Encode a packet as one frame, its delimiter included
+  *
+  * @param  pIn             Packet
+  * @param  Len             Packet length
+  * @param  pOut            Frame, can not overlap the packet
+  * @param  OutSize         Size of pOut, FRAME_ENCODED_SIZE(Len) is always enough
+  *
+  * @retval uint16_t        Frame length, 0 if pOut is too small
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t FRAME_Encode(const uint8_t* pIn, uint16_t Len, uint8_t* pOut, uint16_t OutSize)
+{
+    uint16_t i;
+    uint16_t CodePos = 0;
+    uint16_t Out     = 1;
+    uint8_t  Code    = 1;
+
+    if(OutSize < FRAME_ENCODED_SIZE(Len))
+    {
+        return 0;
+    }
+
+    for(i = 0; i < Len; i++)
+    {
+        if(pIn[i] != 0)
+        {
+            pOut[Out++] = pIn[i];
+            Code++;
+        }
+
+        if((pIn[i] == 0) || (Code == FRAME_MAX_CODE))
+        {
+            pOut[CodePos] = Code;
+            CodePos = Out++;
+            Code = 1;
+        }
+    }
+
+    pOut[CodePos] = Code;
+    pOut[Out++]   = FRAME_DELIMITER;
+
+    return Out;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,173 @@
+/**********************************************************************************************************************
+ * @file    histo.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Fixed width histogram for latency measurements
+ *
+ *          Samples are only counted, so the memory cost does not depend on the run length. Percentiles come back
+ *          with the bin resolution, rounded up to the upper edge of the bin.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "histo.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Attach the bins to the histogram and clear it
+  *
+  * @param  pHisto          Histogram to initialize
+  * @param  pBins           Storage, NumBins counters
+  * @param  NumBins         Number of bins
+  * @param  BinWidth        Width of one bin, in the unit of the samples
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void HISTO_Init(HISTO_t *pHisto, uint16_t *pBins, uint16_t NumBins, uint32_t BinWidth)
+{
+    pHisto->pBins    = pBins;
+    pHisto->NumBins  = NumBins;
+    pHisto->BinWidth = BinWidth;
+    HISTO_Reset(pHisto);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Forget all the samples
+  *
+  * @param  pHisto          Histogram
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void HISTO_Reset(HISTO_t *pHisto)
+{
+    memset(pHisto->pBins, 0, pHisto->NumBins * sizeof(uint16_t));
+    pHisto->Count    = 0;
+    pHisto->Overflow = 0;
+    pHisto->Min      = UINT32_MAX;
+    pHisto->Max      = 0;
+    pHisto->Sum      = 0;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Count one sample
+  *
+  * @param  pHisto          Histogram
+  * @param  Value           Sample
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void HISTO_Add(HISTO_t *pHisto, uint32_t Value)
+{
+    uint32_t bin;
+
+    bin = Value / pHisto->BinWidth;
+    if(bin < pHisto->NumBins)
+    {
+        // Saturate rather than wrap, a long run only loses precision on the dominant bin
+        if(pHisto->pBins[bin] < UINT16_MAX)
+        {
+            pHisto->pBins[bin]++;
+        }
+    }
+    else
+    {
+        pHisto->Overflow++;
+    }
+
+    pHisto->Count++;
+    pHisto->Sum += Value;
+    if(Value < pHisto->Min)
+    {
+        pHisto->Min = Value;
+    }
+    if(Value > pHisto->Max)
+    {
+        pHisto->Max = Value;
+    }
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Value under which Percent % of the samples are
+  *
+  * @param  pHisto          Histogram
+  * @param  Percent         0 to 100
+  *
+  * @retval uint32_t        Upper edge of the bin reaching the percentile, Max when it falls in the overflow
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint32_t HISTO_Percentile(HISTO_t *pHisto, uint8_t Percent)
+{
+    uint32_t target;
+    uint32_t total;
+    uint16_t i;
+
+    if(pHisto->Count == 0)
+    {
+        return 0;
+    }
+
+    // Rank of the sample, rounded up so p100 is the last one
+    target = (uint32_t)((((uint64_t)pHisto->Count * Percent) + 99) / 100);
+    if(target == 0)
+    {
+        target = 1;
+    }
+
+    total = 0;
+    for(i = 0; i < pHisto->NumBins; i++)
+    {
+        total += pHisto->pBins[i];
+        if(total >= target)
+        {
+            return ((i + 1) * pHisto->BinWidth < pHisto->Max) ? (i + 1) * pHisto->BinWidth : pHisto->Max;
+        }
+    }
+
+    return pHisto->Max;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Average of the samples
+  *
+  * @param  pHisto          Histogram
+  *
+  * @retval uint32_t        Mean value, 0 without sample
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint32_t HISTO_Mean(HISTO_t *pHisto)
+{
+    if(pHisto->Count == 0)
+    {
+        return 0;
+    }
+    return (uint32_t)(pHisto->Sum / pHisto->Count);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
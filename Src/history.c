@@ -0,0 +1,219 @@
+/**********************************************************************************************************************
+ * @file    history.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Command line history packed in a byte ring
+ *
+ *          Each line is stored as its length, its bytes, then its length again, with no null char. Walking one
+ *          line back reads the length in front of the cursor, walking forward reads the one under it, so browsing
+ *          never scans the ring and only the recalled line is copied. The oldest lines are dropped to make room, a
+ *          line equal to the newest one is not stored again.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "history.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define HIST_OVERHEAD           2       // Length byte on each side of a line
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static uint16_t HIST_Copy       (HIST_t *pHist, uint16_t Start, char *pOut, uint16_t OutSize);
+static bool     HIST_IsNewest   (HIST_t *pHist, const char *pLine, uint16_t Len);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Copy the line starting at Start, null terminated, truncated to the output
+  *
+  * @param  pHist           History
+  * @param  Start           Position of the leading length byte
+  * @param  pOut            Destination
+  * @param  OutSize         Destination size, null char included
+  *
+  * @retval uint16_t        Length copied
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static uint16_t HIST_Copy(HIST_t *pHist, uint16_t Start, char *pOut, uint16_t OutSize)
+{
+    uint16_t Mask = pHist->Size - 1;
+    uint16_t Len;
+    uint16_t First;
+
+    Len = pHist->pBuff[Start & Mask];
+    Len = (Len < OutSize) ? Len : (OutSize - 1);
+    Start++;
+
+    // At most two pieces, the line may wrap at the end of the buffer
+    First = pHist->Size - (Start & Mask);
+    First = (First < Len) ? First : Len;
+    memcpy(pOut, &pHist->pBuff[Start & Mask], First);
+    memcpy(&pOut[First], pHist->pBuff, Len - First);
+    pOut[Len] = '\0';
+
+    return Len;
+}
+
+static bool HIST_IsNewest(HIST_t *pHist, const char *pLine, uint16_t Len)
+{
+    uint16_t Mask = pHist->Size - 1;
+    uint16_t Pos;
+    uint16_t i;
+
+    if((pHist->Count == 0) || (pHist->pBuff[(pHist->Head - 1) & Mask] != Len))
+    {
+        return false;
+    }
+
+    Pos = pHist->Head - 1 - Len;
+    for(i = 0; i < Len; i++)
+    {
+        if(pHist->pBuff[(Pos + i) & Mask] != (uint8_t)pLine[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Attach a buffer to the history and empty it
+  *
+  * @param  pHist           History to initialize
+  * @param  pBuff           Storage, Size bytes
+  * @param  Size            Storage size, must be a power of 2
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void HIST_Init(HIST_t *pHist, uint8_t *pBuff, uint16_t Size)
+{
+    pHist->pBuff  = pBuff;
+    pHist->Size   = Size;
+    pHist->Head   = 0;
+    pHist->Tail   = 0;
+    pHist->Cursor = 0;
+    pHist->Count  = 0;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Store a line as the newest one and stop browsing
+  *
+  * @param  pHist           History
+  * @param  pLine           Line, not necessarily null terminated
+  * @param  Len             Line length, empty and too long lines are not stored
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void HIST_Add(HIST_t *pHist, const char *pLine, uint16_t Len)
+{
+    uint16_t Mask = pHist->Size - 1;
+    uint16_t i;
+
+    pHist->Cursor = pHist->Head;
+
+    if((Len == 0) || (Len > HIST_MAX_LINE) || ((Len + HIST_OVERHEAD) > pHist->Size) ||
+       HIST_IsNewest(pHist, pLine, Len))
+    {
+        return;
+    }
+
+    while((pHist->Size - (uint16_t)(pHist->Head - pHist->Tail)) < (Len + HIST_OVERHEAD))
+    {
+        pHist->Tail += pHist->pBuff[pHist->Tail & Mask] + HIST_OVERHEAD;
+        pHist->Count--;
+    }
+
+    pHist->pBuff[pHist->Head++ & Mask] = (uint8_t)Len;
+    for(i = 0; i < Len; i++)
+    {
+        pHist->pBuff[pHist->Head++ & Mask] = (uint8_t)pLine[i];
+    }
+    pHist->pBuff[pHist->Head++ & Mask] = (uint8_t)Len;
+
+    pHist->Count++;
+    pHist->Cursor = pHist->Head;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Recall the line before the current one, the oldest line stays recalled
+  *
+  * @param  pHist           History
+  * @param  pOut            Recalled line, null terminated
+  * @param  OutSize         Size of pOut
+  *
+  * @retval uint16_t        Length of the recalled line, 0 if the history is empty
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t HIST_Prev(HIST_t *pHist, char *pOut, uint16_t OutSize)
+{
+    if(pHist->Count == 0)
+    {
+        pOut[0] = '\0';
+        return 0;
+    }
+
+    if(pHist->Cursor != pHist->Tail)
+    {
+        pHist->Cursor -= pHist->pBuff[(pHist->Cursor - 1) & (pHist->Size - 1)] + HIST_OVERHEAD;
+    }
+
+    return HIST_Copy(pHist, pHist->Cursor, pOut, OutSize);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Recall the line after the current one, past the newest one the line is empty again
+  *
+  * @param  pHist           History
+  * @param  pOut            Recalled line, null terminated
+  * @param  OutSize         Size of pOut
+  *
+  * @retval uint16_t        Length of the recalled line, 0 past the newest one
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t HIST_Next(HIST_t *pHist, char *pOut, uint16_t OutSize)
+{
+    if(pHist->Cursor != pHist->Head)
+    {
+        pHist->Cursor += pHist->pBuff[pHist->Cursor & (pHist->Size - 1)] + HIST_OVERHEAD;
+    }
+
+    if(pHist->Cursor == pHist->Head)
+    {
+        pOut[0] = '\0';
+        return 0;
+    }
+
+    return HIST_Copy(pHist, pHist->Cursor, pOut, OutSize);
+}
+
+// Next recall starts again from the newest line
+void HIST_Rewind(HIST_t *pHist)
+{
+    pHist->Cursor = pHist->Head;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -49,31 +49,124 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "i2c.h"
+#include "i2c_dma.h"
+#include "i2c_timing.h"
+#include "usb_stream.h"
 #include "gpio.h"
 #include "nOS.h"
 #include "cli.h"
+#include "lat.h"
+#include "timestamp.h"
 #include "defines.h"
 
 /* Local Defines ----------------------------------------------------------------------------------------------------*/
 
+#define I2C_SCAN_MAX_STUCK  3       // Probes in a row not ending before the scan is given up
+#define I2C_SCAN_IRQ        (I2C_CR1_STOPIE | I2C_CR1_ERRIE)
+#define I2C_SCAN_ICR        (I2C_ICR_STOPCF | I2C_ICR_NACKCF | I2C_ICR_BERRCF | I2C_ICR_ARLOCF)
+#define I2C_STREAM_TIMEOUT  100     // ms without room in the stream Tx ring before a streamed read is aborted
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    const char* pName;
+    uint32_t    Hz;
+    uint32_t    Timing;     // For I2C_KERNEL_HZ and the default edges
+}I2C_Speed_t;
+
 /* Forward Declarations ---------------------------------------------------------------------------------------------*/
 
 void I2C_Task(void *arg);
 
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+I2C_TIMING_PRESET(I2C_TIMING_STD,  I2C_KERNEL_HZ, I2C_TIMING_SM_HZ,  I2C_RISE_NS, I2C_FALL_NS);
+I2C_TIMING_PRESET(I2C_TIMING_FAST, I2C_KERNEL_HZ, I2C_TIMING_FM_HZ,  I2C_RISE_NS, I2C_FALL_NS);
+I2C_TIMING_PRESET(I2C_TIMING_FMP,  I2C_KERNEL_HZ, I2C_TIMING_FMP_HZ, I2C_RISE_NS, I2C_FALL_NS);
+
+static const I2C_Speed_t I2C_Speeds[] =
+{
+    { "std",    I2C_TIMING_SM_HZ,   I2C_TIMING_VALUE(I2C_TIMING_STD)  },
+    { "fast",   I2C_TIMING_FM_HZ,   I2C_TIMING_VALUE(I2C_TIMING_FAST) },
+    { "fm+",    I2C_TIMING_FMP_HZ,  I2C_TIMING_VALUE(I2C_TIMING_FMP)  },
+};
+
 /* Local Variables --------------------------------------------------------------------------------------------------*/
 
 nOS_Thread  I2C_Thread;
 nOS_Stack   I2C_Stack[I2C_STACK_SIZE];
-nOS_Queue   I2C_RxQ;
-uint8_t     RxQ_Buff[I2C_MAX_NUM_CMD][I2C_RXQ_SIZE];
 uint8_t     CurrentAddr;
-uint8_t     CurrentCmd[I2C_RXQ_SIZE];
-uint8_t     Rx_Buff[I2C_RXQ_SIZE];
+uint16_t    I2C_RiseNs = I2C_RISE_NS;   // Edges the timing was computed for
+uint16_t    I2C_FallNs = I2C_FALL_NS;
+
+// Read output, raw on the vendor interface when the host has it open, else dumped on the console
+bool        I2C_ReadStreamed;
+uint32_t    I2C_ReadOffset;
+const char* I2C_ReadError;          // Why the sink stopped the read, NULL on a break
+
+// Scan state, shared with the interrupt
+nOS_Sem             I2C_ScanDone;
+volatile bool       I2C_ScanActive;
+volatile uint8_t    I2C_ScanAddr;
+uint8_t             I2C_ScanLast;
+uint8_t             I2C_ScanFound[16];  // One bit per 7 bits address
+uint8_t             I2C_ScanStuck[16];
+
+uint8_t             I2C_ListRx[I2C_LIST_RX_SIZE];
 
 I2C_HandleTypeDef hi2c1;
 
 /* Local Functions --------------------------------------------------------------------------------------------------*/
 
+// Chunk of a read, called by the DMA engine in the console task while the next chunk is received
+static bool I2C_ReadSink(const uint8_t* pData, uint16_t Len)
+{
+    uint16_t sent;
+    uint32_t stallStart;
+
+    if(!I2C_ReadStreamed)
+    {
+        CLI_Dump(I2C_ReadOffset, pData, Len);
+        I2C_ReadOffset += Len;
+        return !CLI_TakeBreak();
+    }
+
+    stallStart = HAL_GetTick();
+    while(Len > 0)
+    {
+        sent = STREAM_Write(pData, Len);
+        pData += sent;
+        Len -= sent;
+        I2C_ReadOffset += sent;
+
+        // Tx ring full, it empties at the bulk pace, a reader that stopped reading must not hold the bus forever
+        if(sent != 0)
+        {
+            stallStart = HAL_GetTick();
+        }
+        else
+        {
+            if(!STREAM_IsOpen())
+            {
+                I2C_ReadError = "Stream closed by the host";
+                return false;
+            }
+            if((HAL_GetTick() - stallStart) > I2C_STREAM_TIMEOUT)
+            {
+                I2C_ReadError = "Stream stalled, the host stopped reading";
+                return false;
+            }
+            if(CLI_TakeBreak())
+            {
+                return false;
+            }
+            nOS_Sleep(1);
+        }
+    }
+
+    return !CLI_TakeBreak();
+}
 
 /* Global Functions -------------------------------------------------------------------------------------------------*/
 
@@ -173,7 +266,8 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* i2cHandle)
 void I2C_Init()
 {
     MX_I2C1_Init();
-    nOS_QueueCreate(&I2C_RxQ, RxQ_Buff, I2C_RXQ_SIZE, I2C_MAX_NUM_CMD);
+    I2C_DMA_Init();
+    nOS_SemCreate(&I2C_ScanDone, 0, 1);
     nOS_ThreadCreate(&I2C_Thread, I2C_Task, NULL, I2C_Stack, I2C_STACK_SIZE, 1, "I2C Task");
     CurrentAddr = 0x00;
     CLI_Printf("[I2C] Starting...\r\n");
@@ -181,44 +275,123 @@ void I2C_Init()
 
 void I2C_Task(void *arg)
 {
-    memset(Rx_Buff,0,I2C_RXQ_SIZE);
     CLI_Printf("[I2C] Task Started.\r\n");
     while(1)
     {
-        if(!nOS_QueueIsEmpty(&I2C_RxQ))
-        {
-            nOS_QueueRead(&I2C_RxQ, CurrentCmd, NOS_NO_WAIT);
-            CLI_Printf("\r\n");
-            for(int i=0; i<CurrentCmd[0]; i++)
-            {
-              CLI_Printf("%02X", CurrentCmd[i+1]);
-            }
-            CLI_Printf("\r\n");
-        }
         HAL_GPIO_TogglePin(GPIOC, GPIO_PIN_8);
         nOS_Sleep(50);
     }
 }
 
-bool I2C_Cmd_Read(uint8_t* cmd)
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Read any number of bytes at the current address, after writing a register address if any
+  *
+  *         The bytes go raw to the vendor interface when the host has it open, else to the console as a dump. Either
+  *         way the byte count and the time taken end on the console.
+  *
+  * @param  reg             Register address bytes
+  * @param  regLen          Number of register bytes, 0 for a plain read
+  * @param  len             Bytes to read
+  *
+  * @retval bool            false on a NACK, a bus error or a break
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool I2C_Cmd_Read(const uint8_t* reg, uint8_t regLen, uint32_t len)
 {
-    memset(Rx_Buff,0,I2C_RXQ_SIZE);
-    HAL_I2C_Master_Receive_IT(&hi2c1, CurrentAddr, &Rx_Buff[1], cmd[0]);
-    Rx_Buff[0] = cmd[0];
+    I2C_DMA_Result_e result;
+    uint64_t start;
+    uint32_t elapsed;
+
+    I2C_ReadStreamed = STREAM_IsOpen();
+    I2C_ReadOffset = 0;
+    I2C_ReadError = NULL;
+
+    start = TS_GetUs();
+    result = I2C_DMA_Read(CurrentAddr, reg, regLen, len, I2C_ReadSink);
+    elapsed = (uint32_t)(TS_GetUs() - start);
+
+    CLI_Printf("\r\n%lu bytes %s in %lu us", I2C_ReadOffset, I2C_ReadStreamed ? "streamed" : "read", elapsed);
+    if(result != I2C_DMA_OK)
+    {
+        CLI_Printf("\r\n%s", ((result == I2C_DMA_ABORTED) && (I2C_ReadError != NULL)) ? I2C_ReadError :
+                                                                                          I2C_DMA_ResultName(result));
+        return false;
+    }
+
+    return true;
 }
 
-bool I2C_Cmd_Write(uint8_t* cmd, uint8_t size)
+bool I2C_Cmd_Write(uint8_t* cmd, uint16_t size)
 {
-    HAL_I2C_Master_Transmit_IT(&hi2c1, CurrentAddr, cmd, size);
-    return 0;
+    I2C_DMA_Result_e result;
+
+    result = I2C_DMA_Write(CurrentAddr, cmd, size);
+    CLI_Printf("\r\n%s", (result == I2C_DMA_OK) ? "I2C Sent" : I2C_DMA_ResultName(result));
+    return (result == I2C_DMA_OK);
 }
 
 bool I2C_Cmd_Write_Read(uint8_t* cmd) // Reg, ReadLength
 {
-    HAL_I2C_Master_Transmit(&hi2c1, CurrentAddr, cmd, 1, 5);
-    HAL_I2C_Master_Receive_IT(&hi2c1, CurrentAddr, &Rx_Buff[1], cmd[1]);
-    Rx_Buff[0] = cmd[1];
-    return 0;
+    return I2C_Cmd_Read(cmd, 1, cmd[1]);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run a list of operations at the current address, then dump what each read got
+  *
+  * @param  ops             Operations, the reads get their buffer here
+  * @param  count           Number of operations
+  *
+  * @retval bool            false if the reads do not fit I2C_LIST_RX_SIZE or the list did not complete
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool I2C_Cmd_List(I2C_DMA_Op_t* ops, uint8_t count)
+{
+    I2C_DMA_Result_e result;
+    uint64_t start;
+    uint32_t elapsed;
+    uint16_t used = 0;
+    uint8_t i;
+
+    for(i = 0; i < count; i++)
+    {
+        ops[i].Addr = CurrentAddr;
+        if(ops[i].Type == I2C_DMA_OP_READ)
+        {
+            if(ops[i].Len > (sizeof(I2C_ListRx) - used))
+            {
+                CLI_Printf("\r\nReads over %u bytes", (unsigned)sizeof(I2C_ListRx));
+                return false;
+            }
+            ops[i].pData = &I2C_ListRx[used];
+            used += ops[i].Len;
+        }
+    }
+
+    start = TS_GetUs();
+    result = I2C_DMA_Run(ops, count);
+    elapsed = (uint32_t)(TS_GetUs() - start);
+
+    if(result != I2C_DMA_OK)
+    {
+        CLI_Printf("\r\n%s", I2C_DMA_ResultName(result));
+        return false;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        if(ops[i].Type == I2C_DMA_OP_READ)
+        {
+            CLI_Printf("\r\nstep %u", i + 1);
+            CLI_Dump(0, ops[i].pData, ops[i].Len);
+        }
+    }
+    CLI_Printf("\r\n%u steps in %lu us", count, elapsed);
+
+    return true;
 }
 
 bool I2C_SetAddress(uint8_t addr)
@@ -227,49 +400,310 @@ bool I2C_SetAddress(uint8_t addr)
     return 0;
 }
 
-bool I2C_ScanForDevices()
+// SCL frequency from the timing register and the edges it was computed for
+uint32_t I2C_GetBusHz(void)
+{
+    return I2C_TimingHz(HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_I2C1), hi2c1.Instance->TIMINGR, I2C_RiseNs, I2C_FallNs);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Change the bus frequency, between transfers
+  *
+  *         The presets are used as they are for their frequency with the default edges, anything else is computed
+  *         from the kernel clock. Above fast mode the pins get the fast mode plus drive.
+  *
+  * @param  name            Preset name, or NULL to use hz
+  * @param  hz              Bus frequency, up to 1 MHz
+  * @param  riseNs          Rise time of the bus
+  * @param  fallNs          Fall time of the bus
+  *
+  * @retval bool            false if the peripheral is busy or the frequency out of range
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool I2C_SetSpeed(const char* name, uint32_t hz, uint16_t riseNs, uint16_t fallNs)
 {
-    CLI_Printf("Scanning the I2C bus ...");
-    for(uint8_t i=0; i<=0xFE; i+=2)
+    nOS_StatusReg sr;
+    uint32_t kernel;
+    uint32_t timing;
+    bool ready;
+    uint8_t i;
+
+    for(i = 0; (name != NULL) && (i < (sizeof(I2C_Speeds) / sizeof(I2C_Speeds[0]))); i++)
     {
-      if (HAL_I2C_Master_Transmit(&hi2c1, i, NULL, 0, 5) == HAL_OK)
-      {
-        CLI_Printf("0x%02X, ", i);
-      }
+        if(strcmp(name, I2C_Speeds[i].pName) == 0)
+        {
+            hz = I2C_Speeds[i].Hz;
+            name = NULL;
+        }
     }
-    return 0;
+
+    if((name != NULL) || (hz < I2C_SPEED_MIN_HZ) || (hz > I2C_TIMING_FMP_HZ))
+    {
+        return false;
+    }
+
+    kernel = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_I2C1);
+    timing = I2C_TimingCompute(kernel, hz, riseNs, fallNs);
+    for(i = 0; i < (sizeof(I2C_Speeds) / sizeof(I2C_Speeds[0])); i++)
+    {
+        if((hz == I2C_Speeds[i].Hz) && (kernel == I2C_KERNEL_HZ) && (riseNs == I2C_RISE_NS) &&
+           (fallNs == I2C_FALL_NS))
+        {
+            timing = I2C_Speeds[i].Timing;
+        }
+    }
+
+    nOS_EnterCritical(sr);
+    ready = (hi2c1.State == HAL_I2C_STATE_READY);
+    if(ready)
+    {
+        // TIMINGR only takes a write with the peripheral off
+        hi2c1.Instance->CR1 &= ~I2C_CR1_PE;
+        while(hi2c1.Instance->CR1 & I2C_CR1_PE)
+        {
+        }
+        hi2c1.Instance->TIMINGR = timing;
+        hi2c1.Init.Timing = timing;
+
+        if(hz > I2C_TIMING_FM_HZ)
+        {
+            HAL_I2CEx_EnableFastModePlus(I2C_FASTMODEPLUS_PB6);
+            HAL_I2CEx_EnableFastModePlus(I2C_FASTMODEPLUS_PB7);
+        }
+        else
+        {
+            HAL_I2CEx_DisableFastModePlus(I2C_FASTMODEPLUS_PB6);
+            HAL_I2CEx_DisableFastModePlus(I2C_FASTMODEPLUS_PB7);
+        }
+        hi2c1.Instance->CR1 |= I2C_CR1_PE;
+
+        I2C_RiseNs = riseNs;
+        I2C_FallNs = fallNs;
+    }
+    nOS_LeaveCritical(sr);
+
+    return ready;
 }
 
-void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
+void I2C_ShowSpeed(void)
 {
-    CLI_Printf("I2C Abort !\n");
+    uint8_t i;
+
+    CLI_Printf("\r\n%lu Hz, TIMINGR 0x%08lX for %u/%u ns edges, kernel %lu Hz", I2C_GetBusHz(),
+               hi2c1.Instance->TIMINGR, I2C_RiseNs, I2C_FallNs, HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_I2C1));
+    CLI_Printf("\r\nPresets :");
+    for(i = 0; i < (sizeof(I2C_Speeds) / sizeof(I2C_Speeds[0])); i++)
+    {
+        CLI_Printf(" %s %lu kHz", I2C_Speeds[i].pName, I2C_Speeds[i].Hz / 1000);
+    }
 }
 
-void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+// Address only write, the peripheral sends the STOP by itself after the ACK or the NACK
+static void I2C_ProbeStart(uint8_t addr)
 {
-    CLI_Printf("I2C Sent !\n");
+    hi2c1.Instance->ICR = I2C_SCAN_ICR;
+    hi2c1.Instance->CR2 = ((uint32_t)addr << 1) | I2C_CR2_AUTOEND | I2C_CR2_START;
 }
 
-void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+// Go on with the next address or end the scan, called from the interrupt or with it masked
+static void I2C_ProbeNext(void)
 {
-    CLI_Printf("I2C Rx ...\n");
-    nOS_QueueWrite(&I2C_RxQ, Rx_Buff, NOS_NO_WAIT);
-    memset(Rx_Buff,0,I2C_RXQ_SIZE);
+    if(I2C_ScanAddr < I2C_ScanLast)
+    {
+        I2C_ScanAddr++;
+        I2C_ProbeStart(I2C_ScanAddr);
+    }
+    else
+    {
+        // The last probe leaves its STOPF and NACKF, the HAL would take them for its own transfer
+        hi2c1.Instance->ICR = I2C_SCAN_ICR;
+        hi2c1.Instance->CR1 &= ~I2C_SCAN_IRQ;
+        I2C_ScanActive = false;
+        nOS_SemGive(&I2C_ScanDone);
+    }
 }
 
-void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Scan part of the I2C interrupt, one interrupt per probe at its STOP
+  *
+  * @retval bool            true if the interrupt was the scan one, the HAL handler must not run then
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool I2C_ScanIRQ(void)
 {
-  uint32_t error;
-  error = HAL_I2C_GetError(hi2c);
-  if (error == HAL_I2C_ERROR_TIMEOUT)
-  {
-    CLI_Printf("I2C Error - Timeout\n");
-  }
-  else if(error == HAL_I2C_ERROR_AF)
-  {
-    CLI_Printf("I2C Error - ACK error ( Device not present? )\n");
-  }
+    uint32_t isr;
+
+    if(!I2C_ScanActive)
+    {
+        return false;
+    }
+
+    isr = hi2c1.Instance->ISR;
+    if(isr & I2C_ISR_STOPF)
+    {
+        if(!(isr & I2C_ISR_NACKF))
+        {
+            I2C_ScanFound[I2C_ScanAddr >> 3] |= 1 << (I2C_ScanAddr & 7);
+        }
+    }
+    else if(isr & (I2C_ISR_BERR | I2C_ISR_ARLO))
+    {
+        I2C_ScanStuck[I2C_ScanAddr >> 3] |= 1 << (I2C_ScanAddr & 7);
+    }
+    else
+    {
+        return true;
+    }
+
+    I2C_ProbeNext();
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Probe a range of addresses and print the answers as an i2cdetect grid
+  *
+  *         Probes are chained by the interrupt, NACK ends a probe at once. The console task only sleeps, and checks
+  *         at every tick that the probe in progress moved on within the timeout, else the peripheral is reset and
+  *         the address shown as "??".
+  *
+  * @param  first           First 7 bits address
+  * @param  last            Last 7 bits address
+  * @param  clocks          SCL periods a probe may take, rounded up to the tick
+  *
+  * @retval bool            false if the range is invalid, the peripheral is busy or the bus is stuck
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool I2C_ScanForDevices(uint8_t first, uint8_t last, uint16_t clocks)
+{
+    nOS_StatusReg sr;
+    nOS_TickCounter ticks;
+    uint64_t start;
+    uint32_t elapsed;
+    uint8_t addr;
+    uint8_t hung = 0;
+    uint8_t found = 0;
+    uint8_t i;
+
+    if((first > last) || (last > I2C_SCAN_LAST))
+    {
+        CLI_Printf("\r\nInvalid address range");
+        return false;
+    }
+
+    if(hi2c1.State != HAL_I2C_STATE_READY)
+    {
+        CLI_Printf("\r\nI2C busy");
+        return false;
+    }
+
+    // One tick more since the first one may be almost over
+    ticks = ((((uint32_t)clocks * NOS_CONFIG_TICKS_PER_SECOND) + I2C_GetBusHz() - 1) / I2C_GetBusHz()) + 1;
+
+    // HAL calls from the other tasks are answered busy until the end
+    hi2c1.State = HAL_I2C_STATE_BUSY;
+    memset(I2C_ScanFound, 0, sizeof(I2C_ScanFound));
+    memset(I2C_ScanStuck, 0, sizeof(I2C_ScanStuck));
+    nOS_SemTake(&I2C_ScanDone, NOS_NO_WAIT);
+
+    LAT_Mark(LAT_MARK_BUS_START);
+    start = TS_GetUs();
+
+    nOS_EnterCritical(sr);
+    I2C_ScanAddr = first;
+    I2C_ScanLast = last;
+    I2C_ScanActive = true;
+    hi2c1.Instance->CR1 |= I2C_SCAN_IRQ;
+    I2C_ProbeStart(first);
+    nOS_LeaveCritical(sr);
+
+    addr = first;
+    while(nOS_SemTake(&I2C_ScanDone, ticks) != NOS_OK)
+    {
+        nOS_EnterCritical(sr);
+        // Still on the address of the previous check, the probe hangs
+        if(!I2C_ScanActive || (I2C_ScanAddr != addr))
+        {
+            hung = 0;
+        }
+        else
+        {
+            I2C_ScanStuck[addr >> 3] |= 1 << (addr & 7);
+
+            // Software reset, PE must read back 0 before it is set again
+            hi2c1.Instance->CR1 &= ~I2C_CR1_PE;
+            while(hi2c1.Instance->CR1 & I2C_CR1_PE)
+            {
+            }
+            hi2c1.Instance->CR1 |= I2C_CR1_PE;
+            hi2c1.Instance->ICR = I2C_SCAN_ICR;
+
+            if(++hung >= I2C_SCAN_MAX_STUCK)
+            {
+                I2C_ScanLast = addr;
+            }
+            I2C_ProbeNext();
+        }
+        addr = I2C_ScanAddr;
+        nOS_LeaveCritical(sr);
+    }
+
+    elapsed = (uint32_t)(TS_GetUs() - start);
+    LAT_Mark(LAT_MARK_BUS_DONE);
+    hi2c1.State = HAL_I2C_STATE_READY;
+
+    CLI_Printf("\r\n     0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f");
+    for(addr = 0; addr < 0x80; addr++)
+    {
+        if((addr & 0x0F) == 0)
+        {
+            CLI_Printf("\r\n%02x:", addr);
+        }
+
+        if((addr < first) || (addr > I2C_ScanLast))
+        {
+            CLI_Printf("   ");
+        }
+        else if(I2C_ScanStuck[addr >> 3] & (1 << (addr & 7)))
+        {
+            CLI_Printf(" ??");
+        }
+        else if(I2C_ScanFound[addr >> 3] & (1 << (addr & 7)))
+        {
+            CLI_Printf(" %02x", addr);
+            found++;
+        }
+        else
+        {
+            CLI_Printf(" --");
+        }
+    }
+
+    CLI_Printf("\r\n%u found in %lu us at %lu Hz", found, elapsed, I2C_GetBusHz());
+    if(found > 0)
+    {
+        CLI_Printf(", 8 bits addresses :");
+        for(i = first; i <= I2C_ScanLast; i++)
+        {
+            if(I2C_ScanFound[i >> 3] & (1 << (i & 7)))
+            {
+                CLI_Printf(" 0x%02X", i << 1);
+            }
+        }
+    }
+
+    if(hung >= I2C_SCAN_MAX_STUCK)
+    {
+        CLI_Printf("\r\nBus stuck, scan stopped at 0x%02x", I2C_ScanLast);
+        return false;
+    }
 
+    return true;
 }
 
 /* USER CODE END 1 */
@@ -0,0 +1,789 @@
+/**********************************************************************************************************************
+ * @file    i2c_dma.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   DMA driven I2C1 transfers of any length, and lists of them run from the interrupts
+ *
+ *          The I2C runs at register level, as the scan does, while a transfer is in progress. Transfers longer than
+ *          the 255 bytes of NBYTES are cut in reloaded segments from the TCR interrupt, a register written before a
+ *          read is followed by a repeated START from the TC interrupt, so the thread only hears of the end.
+ *
+ *          Reads go through two chunk buffers. The DMA channel fills one while the calling thread hands the other to
+ *          the sink, the USB output in practice. When both are full the channel is left idle and the peripheral
+ *          stretches SCL until the thread frees one, a slow sink slows the bus down instead of losing data.
+ *
+ *          A list of operations goes from one step to the next in the interrupts, the caller hears once at the
+ *          end. Transfers in a row in the same direction to the same address make one transfer on the bus, the DMA
+ *          channel moving from one buffer to the next as each completes. A transfer followed by anything but a STOP
+ *          ends with no AUTOEND, the TC interrupt then holds the bus for what comes next, and a delay runs on TIM14.
+ *
+ *          DMA1 channel 2 serves I2C1_TX and channel 3 I2C1_RX, the reset mapping of the F072.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "i2c_dma.h"
+#include "stm32f0xx_hal.h"
+#include "nOS.h"
+#include "lat.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define I2C_DMA_TX              DMA1_Channel2
+#define I2C_DMA_RX              DMA1_Channel3
+#define I2C_DMA_MAX_NBYTES      255
+#define I2C_DMA_IRQS            (I2C_CR1_TCIE | I2C_CR1_STOPIE | I2C_CR1_NACKIE | I2C_CR1_ERRIE)
+#define I2C_DMA_ERRORS          (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR)
+#define I2C_DMA_TIMEOUT_TICKS   ((I2C_DMA_TIMEOUT_MS * NOS_CONFIG_TICKS_PER_SECOND + 999) / 1000)
+#define I2C_DMA_TIMER           TIM14
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static uint32_t         I2C_DMA_Segment     (void);
+static void             I2C_DMA_ArmRx       (void);
+static void             I2C_DMA_Finish      (I2C_DMA_Result_e Result);
+static bool             I2C_DMA_Claim       (void);
+static uint32_t         I2C_DMA_Left        (void);
+static I2C_DMA_Result_e I2C_DMA_Wait        (I2C_DMA_Sink_t Sink);
+static void             I2C_DMA_ArmOp       (void);
+static void             I2C_DMA_ListRun     (void);
+static void             I2C_DMA_ListEndRun  (void);
+static void             I2C_DMA_ListNext    (void);
+static void             I2C_DMA_ListStop    (void);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+static const char* const I2C_DMA_ResultStr[] =
+{
+    "OK", "I2C busy", "NACK", "Bus error", "Timeout", "Aborted", "Bad list", "Register too long",
+};
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+extern I2C_HandleTypeDef    hi2c1;
+
+static nOS_Sem                      I2C_DMA_Event;
+static uint8_t                      I2C_DMA_Buff[2][I2C_DMA_CHUNK_SIZE];
+static uint8_t                      I2C_DMA_Reg[I2C_DMA_MAX_REG];
+static uint32_t                     I2C_DMA_ReadCR2;    // Address and direction of the read after the register
+
+// Shared with the interrupts
+static volatile uint16_t            I2C_DMA_Full[2];    // Bytes waiting for the sink, 0 once the buffer is free
+static volatile uint8_t             I2C_DMA_Fill;       // Buffer the channel fills, or fills next when idle
+static volatile uint16_t            I2C_DMA_Armed;      // Length of the chunk being received, 0 when idle
+static volatile uint32_t            I2C_DMA_ToArm;      // Bytes not yet given to the channel
+static volatile uint32_t            I2C_DMA_ToLoad;     // Bytes not yet given to NBYTES
+static volatile bool                I2C_DMA_Active;
+static volatile I2C_DMA_Result_e    I2C_DMA_Result;
+static volatile bool                I2C_DMA_SoftEnd;    // No AUTOEND on the last segment, TC holds the bus
+static volatile uint32_t            I2C_DMA_Steps;      // List steps done, the progress of a delay
+
+// List in progress, NULL for a single transfer
+static const I2C_DMA_Op_t* volatile I2C_DMA_List;
+static uint8_t                      I2C_DMA_Count;
+static volatile uint8_t             I2C_DMA_Index;      // Operation in progress
+static uint8_t                      I2C_DMA_RunEnd;     // Operation after the last one of the transfer in progress
+static bool                         I2C_DMA_Held;       // Transfer complete with no STOP, SCL held low
+static I2C_DMA_Done_t               I2C_DMA_Done;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+// NBYTES of the next segment with RELOAD if more follow, else AUTOEND for the STOP unless a soft end
+static uint32_t I2C_DMA_Segment(void)
+{
+    uint32_t Count;
+
+    Count = (I2C_DMA_ToLoad > I2C_DMA_MAX_NBYTES) ? I2C_DMA_MAX_NBYTES : I2C_DMA_ToLoad;
+    I2C_DMA_ToLoad -= Count;
+
+    return (Count << I2C_CR2_NBYTES_Pos) |
+           ((I2C_DMA_ToLoad > 0) ? I2C_CR2_RELOAD : I2C_DMA_SoftEnd ? 0 : I2C_CR2_AUTOEND);
+}
+
+// Receive the next chunk in the fill buffer, called from the interrupts or with them masked
+static void I2C_DMA_ArmRx(void)
+{
+    I2C_DMA_Armed = (I2C_DMA_ToArm > I2C_DMA_CHUNK_SIZE) ? I2C_DMA_CHUNK_SIZE : (uint16_t)I2C_DMA_ToArm;
+    I2C_DMA_ToArm -= I2C_DMA_Armed;
+
+    I2C_DMA_RX->CCR &= ~DMA_CCR_EN;
+    I2C_DMA_RX->CMAR = (uint32_t)I2C_DMA_Buff[I2C_DMA_Fill];
+    I2C_DMA_RX->CNDTR = I2C_DMA_Armed;
+    I2C_DMA_RX->CCR |= DMA_CCR_EN;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  End the transfer in progress, called from the interrupts or with them masked
+  *
+  *         What the channel already stored of a chunk cut short is left for the sink. The first error is kept.
+  *
+  * @param  Result          How the transfer ended
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void I2C_DMA_Finish(I2C_DMA_Result_e Result)
+{
+    I2C_DMA_Done_t Done;
+    uint16_t Got;
+
+    if(I2C_DMA_Armed > 0)
+    {
+        Got = I2C_DMA_Armed - (uint16_t)I2C_DMA_RX->CNDTR;
+        if(Got > 0)
+        {
+            I2C_DMA_Full[I2C_DMA_Fill] = Got;
+        }
+        I2C_DMA_Armed = 0;
+    }
+
+    I2C_DMA_TX->CCR &= ~DMA_CCR_EN;
+    I2C_DMA_RX->CCR &= ~DMA_CCR_EN;
+    DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+    hi2c1.Instance->CR1 &= ~(I2C_DMA_IRQS | I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN);
+    I2C_DMA_TIMER->CR1 &= ~TIM_CR1_CEN;
+
+    if(I2C_DMA_Result == I2C_DMA_OK)
+    {
+        I2C_DMA_Result = Result;
+    }
+    I2C_DMA_ToArm = 0;
+    I2C_DMA_List = NULL;
+    I2C_DMA_Active = false;
+    LAT_Mark(LAT_MARK_BUS_DONE);
+    nOS_SemGive(&I2C_DMA_Event);
+
+    // No thread waits on a submitted list, the peripheral goes back to the HAL here. Done may submit the next one.
+    Done = I2C_DMA_Done;
+    if(Done != NULL)
+    {
+        I2C_DMA_Done = NULL;
+        hi2c1.State = HAL_I2C_STATE_READY;
+        Done(I2C_DMA_Result);
+    }
+}
+
+// Take the peripheral from the HAL, calls from the other tasks are answered busy until the end
+static bool I2C_DMA_Claim(void)
+{
+    nOS_StatusReg sr;
+    bool Claimed;
+
+    nOS_EnterCritical(sr);
+    Claimed = (hi2c1.State == HAL_I2C_STATE_READY);
+    if(Claimed)
+    {
+        hi2c1.State = HAL_I2C_STATE_BUSY;
+    }
+    nOS_LeaveCritical(sr);
+
+    if(Claimed)
+    {
+        nOS_SemTake(&I2C_DMA_Event, NOS_NO_WAIT);
+        memset((void*)I2C_DMA_Full, 0, sizeof(I2C_DMA_Full));
+        I2C_DMA_Fill = 0;
+        I2C_DMA_Armed = 0;
+        I2C_DMA_Result = I2C_DMA_OK;
+        I2C_DMA_SoftEnd = false;
+        I2C_DMA_Steps = 0;
+        hi2c1.Instance->ICR = I2C_ICR_STOPCF | I2C_ICR_NACKCF | I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_OVRCF;
+        LAT_Mark(LAT_MARK_BUS_START);
+    }
+
+    return Claimed;
+}
+
+// Bytes still to move, only compared with itself to tell a stuck bus from a slow one
+static uint32_t I2C_DMA_Left(void)
+{
+    return I2C_DMA_ToArm + I2C_DMA_ToLoad + I2C_DMA_RX->CNDTR + I2C_DMA_TX->CNDTR;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Hand the chunks to the sink as they fill, until the transfer ends
+  *
+  *         A chunk freed while the channel waits for one is armed at once. When nothing moved and no list step was
+  *         done for the timeout, or the sink gives up, the peripheral is reset to let the bus go.
+  *
+  * @param  Sink            Receives the chunks in order, NULL for a write
+  *
+  * @retval I2C_DMA_Result_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static I2C_DMA_Result_e I2C_DMA_Wait(I2C_DMA_Sink_t Sink)
+{
+    nOS_StatusReg sr;
+    nOS_Error Status;
+    I2C_DMA_Result_e Stop = I2C_DMA_OK;
+    uint32_t Left;
+    uint32_t Steps;
+    uint8_t Drain = 0;
+
+    Left = I2C_DMA_Left();
+    Steps = I2C_DMA_Steps;
+    while(true)
+    {
+        Status = nOS_SemTake(&I2C_DMA_Event, I2C_DMA_TIMEOUT_TICKS);
+
+        while(I2C_DMA_Full[Drain] > 0)
+        {
+            if((Stop == I2C_DMA_OK) && !Sink(I2C_DMA_Buff[Drain], I2C_DMA_Full[Drain]))
+            {
+                Stop = I2C_DMA_ABORTED;
+            }
+
+            nOS_EnterCritical(sr);
+            I2C_DMA_Full[Drain] = 0;
+            if(I2C_DMA_Active && (I2C_DMA_Armed == 0) && (I2C_DMA_ToArm > 0))
+            {
+                I2C_DMA_ArmRx();
+            }
+            nOS_LeaveCritical(sr);
+            Drain ^= 1;
+        }
+
+        if(!I2C_DMA_Active)
+        {
+            break;
+        }
+
+        if((Stop == I2C_DMA_OK) && (Status != NOS_OK))
+        {
+            if((I2C_DMA_Left() == Left) && (I2C_DMA_Steps == Steps))
+            {
+                Stop = I2C_DMA_TIMEOUT;
+            }
+            Left = I2C_DMA_Left();
+            Steps = I2C_DMA_Steps;
+        }
+
+        if(Stop != I2C_DMA_OK)
+        {
+            nOS_EnterCritical(sr);
+            if(I2C_DMA_Active)
+            {
+                I2C_DMA_Finish(Stop);
+
+                // Software reset, PE must read back 0 before it is set again
+                hi2c1.Instance->CR1 &= ~I2C_CR1_PE;
+                while(hi2c1.Instance->CR1 & I2C_CR1_PE)
+                {
+                }
+                hi2c1.Instance->CR1 |= I2C_CR1_PE;
+            }
+            nOS_LeaveCritical(sr);
+        }
+    }
+
+    hi2c1.State = HAL_I2C_STATE_READY;
+    return I2C_DMA_Result;
+}
+
+// Point the channel of the transfer at the buffer of the operation in progress
+static void I2C_DMA_ArmOp(void)
+{
+    const I2C_DMA_Op_t* pOp = &I2C_DMA_List[I2C_DMA_Index];
+    DMA_Channel_TypeDef* pChannel;
+
+    pChannel = (pOp->Type == I2C_DMA_OP_READ) ? I2C_DMA_RX : I2C_DMA_TX;
+    pChannel->CCR &= ~DMA_CCR_EN;
+    pChannel->CMAR = (uint32_t)pOp->pData;
+    pChannel->CNDTR = pOp->Len;
+    pChannel->CCR |= DMA_CCR_EN;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Start the transfer made of the operation in progress and the ones following it in the same direction to
+  *         the same address, with a repeated START if the bus is held
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void I2C_DMA_ListRun(void)
+{
+    const I2C_DMA_Op_t* pOp = &I2C_DMA_List[I2C_DMA_Index];
+    I2C_TypeDef *pI2C = hi2c1.Instance;
+    uint32_t Total = 0;
+    uint8_t i;
+
+    for(i = I2C_DMA_Index;
+        (i < I2C_DMA_Count) && (I2C_DMA_List[i].Type == pOp->Type) && (I2C_DMA_List[i].Addr == pOp->Addr);
+        i++)
+    {
+        Total += I2C_DMA_List[i].Len;
+    }
+    I2C_DMA_RunEnd = i;
+    I2C_DMA_SoftEnd = (i < I2C_DMA_Count) && (I2C_DMA_List[i].Type != I2C_DMA_OP_STOP);
+    I2C_DMA_ToLoad = Total;
+
+    I2C_DMA_ArmOp();
+    if(pOp->Type == I2C_DMA_OP_READ)
+    {
+        pI2C->CR1 = (pI2C->CR1 & ~I2C_CR1_TXDMAEN) | I2C_CR1_RXDMAEN;
+        pI2C->CR2 = (pOp->Addr & 0xFE) | I2C_CR2_RD_WRN | I2C_DMA_Segment() | I2C_CR2_START;
+    }
+    else
+    {
+        pI2C->CR1 = (pI2C->CR1 & ~I2C_CR1_RXDMAEN) | I2C_CR1_TXDMAEN;
+        pI2C->CR2 = (pOp->Addr & 0xFE) | I2C_DMA_Segment() | I2C_CR2_START;
+    }
+    I2C_DMA_Held = false;
+}
+
+// Transfer over, a channel complete still pending is dropped, the lower vector number has it served first anyway
+static void I2C_DMA_ListEndRun(void)
+{
+    I2C_DMA_TX->CCR &= ~DMA_CCR_EN;
+    I2C_DMA_RX->CCR &= ~DMA_CCR_EN;
+    DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+    I2C_DMA_Index = I2C_DMA_RunEnd;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Go on with the list from the operation in progress, until something to wait for
+  *
+  *         A STOP with the bus already free and a repeated START are only markers, the end of the list releases a
+  *         held bus.
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void I2C_DMA_ListNext(void)
+{
+    const I2C_DMA_Op_t* pOp;
+
+    I2C_DMA_Steps++;
+    while(I2C_DMA_Index < I2C_DMA_Count)
+    {
+        pOp = &I2C_DMA_List[I2C_DMA_Index];
+        switch(pOp->Type)
+        {
+            case I2C_DMA_OP_WRITE:
+            case I2C_DMA_OP_READ:
+                I2C_DMA_ListRun();
+                return;
+
+            case I2C_DMA_OP_STOP:
+                if(I2C_DMA_Held)
+                {
+                    hi2c1.Instance->CR2 |= I2C_CR2_STOP;
+                    return;
+                }
+                break;
+
+            case I2C_DMA_OP_DELAY:
+                if(pOp->Len > 0)
+                {
+                    // TC stays set while the bus is held, it comes back with the next step
+                    hi2c1.Instance->CR1 &= ~I2C_CR1_TCIE;
+
+                    // Counting from 0 to ARR, at most a microsecond more than asked
+                    I2C_DMA_TIMER->ARR = pOp->Len;
+                    I2C_DMA_TIMER->CNT = 0;
+                    I2C_DMA_TIMER->SR = 0;
+                    I2C_DMA_TIMER->CR1 |= TIM_CR1_CEN;
+                    return;
+                }
+                break;
+
+            default:
+                break;
+        }
+        I2C_DMA_Index++;
+    }
+
+    if(I2C_DMA_Held)
+    {
+        hi2c1.Instance->CR2 |= I2C_CR2_STOP;
+        return;
+    }
+    I2C_DMA_Finish(I2C_DMA_OK);
+}
+
+// STOP sent, by a STOP operation, by AUTOEND after a transfer or at the end of the list
+static void I2C_DMA_ListStop(void)
+{
+    if(I2C_DMA_Index < I2C_DMA_Count)
+    {
+        if(I2C_DMA_List[I2C_DMA_Index].Type != I2C_DMA_OP_STOP)
+        {
+            I2C_DMA_ListEndRun();
+        }
+        if((I2C_DMA_Index < I2C_DMA_Count) && (I2C_DMA_List[I2C_DMA_Index].Type == I2C_DMA_OP_STOP))
+        {
+            I2C_DMA_Index++;
+        }
+    }
+    I2C_DMA_Held = false;
+    I2C_DMA_ListNext();
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+void I2C_DMA_Init(void)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    I2C_DMA_TX->CPAR = (uint32_t)&I2C1->TXDR;
+    I2C_DMA_RX->CPAR = (uint32_t)&I2C1->RXDR;
+    I2C_DMA_TX->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_PL_1;
+    I2C_DMA_RX->CCR = DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_PL_1;
+
+    // Delays of the lists, 1 us counts, stopped by its interrupt
+    __HAL_RCC_TIM14_CLK_ENABLE();
+    I2C_DMA_TIMER->PSC = (HAL_RCC_GetPCLK1Freq() / 1000000) - 1;
+    I2C_DMA_TIMER->CR1 = TIM_CR1_URS;
+    I2C_DMA_TIMER->EGR = TIM_EGR_UG;
+    I2C_DMA_TIMER->DIER = TIM_DIER_UIE;
+
+    // Same priority as the I2C interrupt, none preempts the others
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+    HAL_NVIC_SetPriority(TIM14_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(TIM14_IRQn);
+
+    nOS_SemCreate(&I2C_DMA_Event, 0, 1);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Read any number of bytes, after writing a register address if any
+  *
+  *         Blocks the calling thread until the STOP, the sink runs in it.
+  *
+  * @param  Addr            8 bits slave address
+  * @param  pReg            Register address sent first, then a repeated START
+  * @param  RegLen          Register address bytes, 0 for a plain read, up to I2C_DMA_MAX_REG
+  * @param  Len             Bytes to read
+  * @param  Sink            Receives the bytes, I2C_DMA_CHUNK_SIZE at a time except the last chunk
+  *
+  * @retval I2C_DMA_Result_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+I2C_DMA_Result_e I2C_DMA_Read(uint8_t Addr, const uint8_t* pReg, uint8_t RegLen, uint32_t Len, I2C_DMA_Sink_t Sink)
+{
+    nOS_StatusReg sr;
+
+    if(RegLen > I2C_DMA_MAX_REG)
+    {
+        return I2C_DMA_BAD_ARG;
+    }
+
+    if(Len == 0)
+    {
+        return I2C_DMA_OK;
+    }
+
+    if(!I2C_DMA_Claim())
+    {
+        return I2C_DMA_BUSY;
+    }
+
+    memcpy(I2C_DMA_Reg, pReg, RegLen);
+    I2C_DMA_ToArm = Len;
+    I2C_DMA_ToLoad = Len;
+    I2C_DMA_ReadCR2 = (Addr & 0xFE) | I2C_CR2_RD_WRN;
+    I2C_DMA_TX->CNDTR = 0;
+
+    nOS_EnterCritical(sr);
+    I2C_DMA_Active = true;
+    if(RegLen > 0)
+    {
+        // No AUTOEND, TC comes once the register is sent for the repeated START
+        I2C_DMA_TX->CCR &= ~DMA_CCR_EN;
+        I2C_DMA_TX->CMAR = (uint32_t)I2C_DMA_Reg;
+        I2C_DMA_TX->CNDTR = RegLen;
+        I2C_DMA_TX->CCR |= DMA_CCR_EN;
+        hi2c1.Instance->CR1 |= I2C_DMA_IRQS | I2C_CR1_TXDMAEN;
+        hi2c1.Instance->CR2 = (Addr & 0xFE) | ((uint32_t)RegLen << I2C_CR2_NBYTES_Pos) | I2C_CR2_START;
+    }
+    else
+    {
+        I2C_DMA_ArmRx();
+        hi2c1.Instance->CR1 |= I2C_DMA_IRQS | I2C_CR1_RXDMAEN;
+        hi2c1.Instance->CR2 = I2C_DMA_ReadCR2 | I2C_DMA_Segment() | I2C_CR2_START;
+    }
+    nOS_LeaveCritical(sr);
+
+    return I2C_DMA_Wait(Sink);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Write any number of bytes from one buffer
+  *
+  * @param  Addr            8 bits slave address
+  * @param  pData           Bytes to send, left untouched until the function returns
+  * @param  Len             Number of bytes
+  *
+  * @retval I2C_DMA_Result_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+I2C_DMA_Result_e I2C_DMA_Write(uint8_t Addr, const uint8_t* pData, uint16_t Len)
+{
+    nOS_StatusReg sr;
+
+    if(Len == 0)
+    {
+        return I2C_DMA_OK;
+    }
+
+    if(!I2C_DMA_Claim())
+    {
+        return I2C_DMA_BUSY;
+    }
+
+    I2C_DMA_ToArm = 0;
+    I2C_DMA_ToLoad = Len;
+
+    nOS_EnterCritical(sr);
+    I2C_DMA_Active = true;
+    I2C_DMA_TX->CCR &= ~DMA_CCR_EN;
+    I2C_DMA_TX->CMAR = (uint32_t)pData;
+    I2C_DMA_TX->CNDTR = Len;
+    I2C_DMA_TX->CCR |= DMA_CCR_EN;
+    hi2c1.Instance->CR1 |= I2C_DMA_IRQS | I2C_CR1_TXDMAEN;
+    hi2c1.Instance->CR2 = (Addr & 0xFE) | I2C_DMA_Segment() | I2C_CR2_START;
+    nOS_LeaveCritical(sr);
+
+    return I2C_DMA_Wait(NULL);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Start a list of operations, run to the end by the interrupts
+  *
+  *         A list with no transfer may be done before the function returns, Done is then called from it.
+  *
+  * @param  pOps            Operations, left untouched until the list is done
+  * @param  Count           Number of operations, up to I2C_DMA_MAX_OPS
+  * @param  Done            Called once with the result, from the interrupts, NULL when a thread waits instead
+  *
+  * @retval I2C_DMA_Result_e I2C_DMA_OK once started, I2C_DMA_BUSY or I2C_DMA_BAD_LIST if not
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+I2C_DMA_Result_e I2C_DMA_Submit(const I2C_DMA_Op_t* pOps, uint8_t Count, I2C_DMA_Done_t Done)
+{
+    nOS_StatusReg sr;
+    uint8_t i;
+
+    if((Count == 0) || (Count > I2C_DMA_MAX_OPS))
+    {
+        return I2C_DMA_BAD_LIST;
+    }
+
+    for(i = 0; i < Count; i++)
+    {
+        if((pOps[i].Type > I2C_DMA_OP_DELAY) ||
+           (((pOps[i].Type == I2C_DMA_OP_WRITE) || (pOps[i].Type == I2C_DMA_OP_READ)) &&
+            ((pOps[i].Len == 0) || (pOps[i].pData == NULL))))
+        {
+            return I2C_DMA_BAD_LIST;
+        }
+    }
+
+    if(!I2C_DMA_Claim())
+    {
+        return I2C_DMA_BUSY;
+    }
+
+    I2C_DMA_ToArm = 0;
+    I2C_DMA_ToLoad = 0;
+    I2C_DMA_TX->CNDTR = 0;
+    I2C_DMA_RX->CNDTR = 0;
+    I2C_DMA_Count = Count;
+    I2C_DMA_Index = 0;
+    I2C_DMA_Held = false;
+
+    nOS_EnterCritical(sr);
+    I2C_DMA_List = pOps;
+    I2C_DMA_Done = Done;
+    I2C_DMA_Active = true;
+    hi2c1.Instance->CR1 |= I2C_DMA_IRQS;
+    I2C_DMA_ListNext();
+    nOS_LeaveCritical(sr);
+
+    return I2C_DMA_OK;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run a list of operations, the calling thread sleeps until the end
+  *
+  * @param  pOps            Operations
+  * @param  Count           Number of operations, up to I2C_DMA_MAX_OPS
+  *
+  * @retval I2C_DMA_Result_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+I2C_DMA_Result_e I2C_DMA_Run(const I2C_DMA_Op_t* pOps, uint8_t Count)
+{
+    I2C_DMA_Result_e Result;
+
+    Result = I2C_DMA_Submit(pOps, Count, NULL);
+    if(Result != I2C_DMA_OK)
+    {
+        return Result;
+    }
+
+    return I2C_DMA_Wait(NULL);
+}
+
+const char* I2C_DMA_ResultName(I2C_DMA_Result_e Result)
+{
+    return (Result < (sizeof(I2C_DMA_ResultStr) / sizeof(I2C_DMA_ResultStr[0]))) ? I2C_DMA_ResultStr[Result] : "?";
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Transfer part of the I2C interrupt
+  *
+  * @retval bool            true if a transfer of this module is in progress, the HAL handler must not run then
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool I2C_DMA_IRQ(void)
+{
+    I2C_TypeDef *pI2C = hi2c1.Instance;
+    uint32_t isr;
+
+    if(!I2C_DMA_Active)
+    {
+        return false;
+    }
+
+    isr = pI2C->ISR;
+    if(isr & I2C_DMA_ERRORS)
+    {
+        pI2C->ICR = I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_OVRCF;
+        I2C_DMA_Finish(I2C_DMA_BUS_ERROR);
+        return true;
+    }
+
+    if(isr & I2C_ISR_NACKF)
+    {
+        pI2C->ICR = I2C_ICR_NACKCF;
+        I2C_DMA_Result = I2C_DMA_NACK;
+        if(!(pI2C->CR2 & I2C_CR2_AUTOEND))
+        {
+            pI2C->CR2 |= I2C_CR2_STOP;
+        }
+    }
+
+    if(isr & I2C_ISR_STOPF)
+    {
+        pI2C->ICR = I2C_ICR_STOPCF;
+        if((I2C_DMA_List != NULL) && (I2C_DMA_Result == I2C_DMA_OK))
+        {
+            I2C_DMA_ListStop();
+        }
+        else
+        {
+            I2C_DMA_Finish(I2C_DMA_OK);
+        }
+    }
+    else if(isr & I2C_ISR_TCR)
+    {
+        pI2C->CR2 = (pI2C->CR2 & ~(I2C_CR2_NBYTES | I2C_CR2_RELOAD | I2C_CR2_AUTOEND)) | I2C_DMA_Segment();
+    }
+    else if((isr & I2C_ISR_TC) && (I2C_DMA_Result == I2C_DMA_OK) && (I2C_DMA_List != NULL))
+    {
+        // Transfer of a list done with no STOP
+        I2C_DMA_ListEndRun();
+        I2C_DMA_Held = true;
+        I2C_DMA_ListNext();
+    }
+    else if((isr & I2C_ISR_TC) && (I2C_DMA_Result == I2C_DMA_OK))
+    {
+        // Register sent, the read starts over with a repeated START
+        I2C_DMA_TX->CCR &= ~DMA_CCR_EN;
+        pI2C->CR1 = (pI2C->CR1 & ~I2C_CR1_TXDMAEN) | I2C_CR1_RXDMAEN;
+        I2C_DMA_ArmRx();
+        pI2C->CR2 = I2C_DMA_ReadCR2 | I2C_DMA_Segment() | I2C_CR2_START;
+    }
+
+    return true;
+}
+
+// Chunk received, or buffer of a list operation done, DMA1 channel 2 and 3 interrupt
+void I2C_DMA_ChannelIRQ(void)
+{
+    uint32_t isr;
+
+    isr = DMA1->ISR;
+    if(isr & (DMA_ISR_TEIF2 | DMA_ISR_TEIF3))
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+        if(I2C_DMA_Active)
+        {
+            I2C_DMA_Finish(I2C_DMA_BUS_ERROR);
+        }
+        return;
+    }
+
+    if((isr & (DMA_ISR_TCIF2 | DMA_ISR_TCIF3)) && (I2C_DMA_List != NULL))
+    {
+        // The transfer goes on with the buffer of the next operation, NBYTES already counts it
+        DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+        I2C_DMA_Steps++;
+        if((I2C_DMA_Index + 1) < I2C_DMA_RunEnd)
+        {
+            I2C_DMA_Index++;
+            I2C_DMA_ArmOp();
+        }
+        return;
+    }
+
+    // A single write has nothing to do on its channel complete
+    if(isr & DMA_ISR_TCIF2)
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF2;
+    }
+
+    if(isr & DMA_ISR_TCIF3)
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF3;
+        if(I2C_DMA_Active && (I2C_DMA_Armed > 0))
+        {
+            I2C_DMA_Full[I2C_DMA_Fill] = I2C_DMA_Armed;
+            I2C_DMA_Armed = 0;
+            I2C_DMA_Fill ^= 1;
+
+            // Else the peripheral stretches SCL until the thread frees the buffer
+            if((I2C_DMA_ToArm > 0) && (I2C_DMA_Full[I2C_DMA_Fill] == 0))
+            {
+                I2C_DMA_ArmRx();
+            }
+            nOS_SemGive(&I2C_DMA_Event);
+        }
+    }
+}
+
+// Delay of a list over, TIM14 interrupt
+void I2C_DMA_TimerIRQ(void)
+{
+    I2C_DMA_TIMER->CR1 &= ~TIM_CR1_CEN;
+    I2C_DMA_TIMER->SR = 0;
+
+    if(I2C_DMA_Active && (I2C_DMA_List != NULL))
+    {
+        hi2c1.Instance->CR1 |= I2C_CR1_TCIE;
+        I2C_DMA_Index++;
+        I2C_DMA_ListNext();
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,262 @@
+/**********************************************************************************************************************
+ * @file    lat.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Per stage latency of the console commands
+ *
+ *          Each command line gets a timestamp at a few points of its life, see LAT_Mark_e. Once it is over, the
+ *          time between the points goes in one histogram per stage:
+ *
+ *          usb     CDC receive to parse start, the console task waking up and the line being assembled
+ *          parse   Parse start to the first transfer, or to the prompt for commands with no transfer
+ *          bus     First transfer start to the last transfer complete
+ *          output  Last transfer complete to the prompt
+ *          total   CDC receive, or parse start, to whichever of the prompt and the transfer complete comes last
+ *
+ *          A command is over at its prompt, or at its transfer complete when the transfer outlives the command. A
+ *          line sharing its CDC packet with the previous one has no receive time and is left out of the usb stage.
+ *          Transfer marks coming while no command is in progress, from a periodic job or a background task, are
+ *          ignored.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include "lat.h"
+#include "histo.h"
+#include "cli.h"
+#include "nOS.h"
+#include "timestamp.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define LAT_BINS                40
+
+#define LAT_HAS(Mark)           ((LAT_Valid & (1 << (Mark))) != 0)
+#define LAT_SPAN(From, To)      (LAT_Stamp[To] - LAT_Stamp[From])
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef enum
+{
+    LAT_STAGE_USB,
+    LAT_STAGE_PARSE,
+    LAT_STAGE_BUS,
+    LAT_STAGE_OUTPUT,
+    LAT_STAGE_TOTAL,
+    LAT_NUM_STAGES,
+}LAT_Stage_e;
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static void LAT_Close(void);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+static const char* const LAT_StageName[LAT_NUM_STAGES] = { "usb", "parse", "bus", "output", "total" };
+
+// us, a sample past LAT_BINS bins only counts in the overflow and p99 falls back to the max
+static const uint16_t LAT_BinWidth[LAT_NUM_STAGES] = { 50, 25, 100, 50, 250 };
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+static HISTO_t              LAT_Histo[LAT_NUM_STAGES];
+static uint16_t             LAT_Bins[LAT_NUM_STAGES][LAT_BINS];
+static uint32_t             LAT_Stamp[LAT_NUM_MARKS];
+static uint8_t              LAT_Valid;          // One bit per mark of the command in progress
+static bool                 LAT_Open;
+static volatile uint32_t    LAT_RxUs;
+static volatile bool        LAT_RxPending;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+// Count the stages of the command in progress, called with the interrupts off
+static void LAT_Close(void)
+{
+    uint8_t First;
+    uint8_t Last;
+
+    if(!LAT_Open)
+    {
+        return;
+    }
+    LAT_Open = false;
+
+    if(LAT_HAS(LAT_MARK_RX))
+    {
+        HISTO_Add(&LAT_Histo[LAT_STAGE_USB], LAT_SPAN(LAT_MARK_RX, LAT_MARK_PARSE));
+    }
+
+    if(LAT_HAS(LAT_MARK_BUS_START))
+    {
+        HISTO_Add(&LAT_Histo[LAT_STAGE_PARSE], LAT_SPAN(LAT_MARK_PARSE, LAT_MARK_BUS_START));
+        if(LAT_HAS(LAT_MARK_BUS_DONE))
+        {
+            HISTO_Add(&LAT_Histo[LAT_STAGE_BUS], LAT_SPAN(LAT_MARK_BUS_START, LAT_MARK_BUS_DONE));
+        }
+    }
+    else if(LAT_HAS(LAT_MARK_OUT))
+    {
+        HISTO_Add(&LAT_Histo[LAT_STAGE_PARSE], LAT_SPAN(LAT_MARK_PARSE, LAT_MARK_OUT));
+    }
+
+    // A transfer completing after the prompt has no output stage
+    Last = LAT_NUM_MARKS;
+    if(LAT_HAS(LAT_MARK_OUT))
+    {
+        Last = LAT_MARK_OUT;
+    }
+    if(LAT_HAS(LAT_MARK_BUS_DONE))
+    {
+        if((Last == LAT_NUM_MARKS) || ((int32_t)LAT_SPAN(LAT_MARK_BUS_DONE, LAT_MARK_OUT) < 0))
+        {
+            Last = LAT_MARK_BUS_DONE;
+        }
+        else
+        {
+            HISTO_Add(&LAT_Histo[LAT_STAGE_OUTPUT], LAT_SPAN(LAT_MARK_BUS_DONE, LAT_MARK_OUT));
+        }
+    }
+
+    if(Last != LAT_NUM_MARKS)
+    {
+        First = LAT_HAS(LAT_MARK_RX) ? LAT_MARK_RX : LAT_MARK_PARSE;
+        HISTO_Add(&LAT_Histo[LAT_STAGE_TOTAL], LAT_SPAN(First, Last));
+    }
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+void LAT_Init(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < LAT_NUM_STAGES; i++)
+    {
+        HISTO_Init(&LAT_Histo[i], LAT_Bins[i], LAT_BINS, LAT_BinWidth[i]);
+    }
+    LAT_Open = false;
+    LAT_RxPending = false;
+}
+
+// A CDC packet holding a line end was received, from the USB interrupt. Only the first one waiting is kept.
+void LAT_RxLine(void)
+{
+    if(!LAT_RxPending)
+    {
+        LAT_RxUs = (uint32_t)TS_GetUs();
+        LAT_RxPending = true;
+    }
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  A command line is handed to the parser, the previous command is counted if it was not yet
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void LAT_Begin(void)
+{
+    nOS_StatusReg sr;
+    uint32_t Now;
+
+    Now = (uint32_t)TS_GetUs();
+
+    nOS_EnterCritical(sr);
+    LAT_Close();
+
+    LAT_Stamp[LAT_MARK_PARSE] = Now;
+    LAT_Valid = 1 << LAT_MARK_PARSE;
+    if(LAT_RxPending)
+    {
+        LAT_Stamp[LAT_MARK_RX] = LAT_RxUs;
+        LAT_Valid |= 1 << LAT_MARK_RX;
+        LAT_RxPending = false;
+    }
+    LAT_Open = true;
+    nOS_LeaveCritical(sr);
+}
+
+// An empty line was received, its receive time must not go to the next command
+void LAT_SkipLine(void)
+{
+    LAT_RxPending = false;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Timestamp a point of the command in progress, from a thread or an interrupt
+  *
+  *         The first transfer start and the last transfer complete are kept. The prompt or the transfer complete,
+  *         whichever comes last, ends the command.
+  *
+  * @param  Mark            Point reached, LAT_MARK_RX is set by LAT_RxLine and LAT_MARK_PARSE by LAT_Begin
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void LAT_Mark(LAT_Mark_e Mark)
+{
+    nOS_StatusReg sr;
+    uint32_t Now;
+
+    Now = (uint32_t)TS_GetUs();
+
+    nOS_EnterCritical(sr);
+    if(LAT_Open &&
+       !((Mark == LAT_MARK_BUS_START) && LAT_HAS(LAT_MARK_BUS_START)) &&
+       !((Mark == LAT_MARK_BUS_DONE) && !LAT_HAS(LAT_MARK_BUS_START)))
+    {
+        LAT_Stamp[Mark] = Now;
+        LAT_Valid |= 1 << Mark;
+
+        if(((Mark == LAT_MARK_OUT) && (!LAT_HAS(LAT_MARK_BUS_START) || LAT_HAS(LAT_MARK_BUS_DONE))) ||
+           ((Mark == LAT_MARK_BUS_DONE) && LAT_HAS(LAT_MARK_OUT)))
+        {
+            LAT_Close();
+        }
+    }
+    nOS_LeaveCritical(sr);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Print the count, min, average, p99 and max of each stage, then start over
+  *
+  *         The command printing the report is not counted.
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void LAT_Report(void)
+{
+    nOS_StatusReg sr;
+    HISTO_t *pHisto;
+    uint8_t i;
+
+    CLI_Printf("\r\nstage     count      min      avg      p99      max (us)");
+    for(i = 0; i < LAT_NUM_STAGES; i++)
+    {
+        pHisto = &LAT_Histo[i];
+        CLI_Printf("\r\n%-6s %8lu %8lu %8lu %8lu %8lu", LAT_StageName[i], pHisto->Count,
+                   (pHisto->Count > 0) ? pHisto->Min : 0, HISTO_Mean(pHisto), HISTO_Percentile(pHisto, 99),
+                   pHisto->Max);
+        if(pHisto->Overflow > 0)
+        {
+            CLI_Printf(", %lu over %lu us", pHisto->Overflow, (uint32_t)LAT_BINS * LAT_BinWidth[i]);
+        }
+    }
+
+    nOS_EnterCritical(sr);
+    for(i = 0; i < LAT_NUM_STAGES; i++)
+    {
+        HISTO_Reset(&LAT_Histo[i]);
+    }
+    LAT_Open = false;
+    nOS_LeaveCritical(sr);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
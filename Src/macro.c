@@ -0,0 +1,623 @@
+/**********************************************************************************************************************
+ * @file    macro.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Named console command sequences kept on the device
+ *
+ *          A macro is a ';' separated command line, as typed in the console, stored under a short name. The bodies
+ *          are packed in one pool in the order they were created, a body only grows at its end so recording never
+ *          copies more than the macros created after it. The table slots never move, only the pool does.
+ *
+ *          The macros live in RAM, MACRO_Save and MACRO_Load keep them in MACRO_FILE on the capture volume, one
+ *          "name body" per line, while the firmware has it mounted.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include <ctype.h>
+#include "macro.h"
+#include "fatfs.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define MACRO_NONE              -1
+#define MACRO_LOAD_CHUNK        32
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+// Name[0] is null when the slot is free
+typedef struct
+{
+    char        Name[MACRO_NAME_SIZE];
+    uint16_t    Offset;
+    uint16_t    Len;
+}MACRO_t;
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static int8_t   MACRO_Find      (const char* pName);
+static int8_t   MACRO_Create    (const char* pName);
+static bool     MACRO_Insert    (int8_t Idx, const char* pData, uint16_t Len);
+static void     MACRO_Truncate  (int8_t Idx, uint16_t Len);
+static void     MACRO_Shift     (int8_t Idx, uint16_t At, int16_t Delta);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+MACRO_t     MACRO_Table[MACRO_MAX];
+char        MACRO_Pool[MACRO_POOL_SIZE];
+uint16_t    MACRO_Used;
+int8_t      MACRO_RecIdx  = MACRO_NONE;
+int8_t      MACRO_UndoIdx = MACRO_NONE;    // Macro and length before the last recorded command
+uint16_t    MACRO_UndoLen;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Find a macro by name, the case is ignored
+  *
+  * @param  pName           Name
+  *
+  * @retval int8_t          Slot or MACRO_NONE
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static int8_t MACRO_Find(const char* pName)
+{
+    int8_t  Idx;
+    uint8_t i;
+
+    for(Idx = 0; Idx < MACRO_MAX; Idx++)
+    {
+        if(MACRO_Table[Idx].Name[0] == '\0')
+        {
+            continue;
+        }
+
+        for(i = 0; (MACRO_Table[Idx].Name[i] != '\0') &&
+                   (MACRO_Table[Idx].Name[i] == tolower((unsigned char)pName[i])); i++);
+
+        if((MACRO_Table[Idx].Name[i] == '\0') && (pName[i] == '\0'))
+        {
+            return Idx;
+        }
+    }
+
+    return MACRO_NONE;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Take a free slot for an empty macro at the end of the pool
+  *
+  * @param  pName           Name, letters, digits and '_' only
+  *
+  * @retval int8_t          Slot or MACRO_NONE if the name is invalid or the table full
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static int8_t MACRO_Create(const char* pName)
+{
+    int8_t  Idx;
+    uint8_t i;
+
+    for(i = 0; pName[i] != '\0'; i++)
+    {
+        if((i >= (MACRO_NAME_SIZE - 1)) || (!isalnum((unsigned char)pName[i]) && (pName[i] != '_')))
+        {
+            return MACRO_NONE;
+        }
+    }
+
+    if(i == 0)
+    {
+        return MACRO_NONE;
+    }
+
+    for(Idx = 0; Idx < MACRO_MAX; Idx++)
+    {
+        if(MACRO_Table[Idx].Name[0] == '\0')
+        {
+            for(i = 0; pName[i] != '\0'; i++)
+            {
+                MACRO_Table[Idx].Name[i] = tolower((unsigned char)pName[i]);
+            }
+            MACRO_Table[Idx].Name[i] = '\0';
+            MACRO_Table[Idx].Offset  = MACRO_Used;
+            MACRO_Table[Idx].Len     = 0;
+            return Idx;
+        }
+    }
+
+    return MACRO_NONE;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Move the end of the pool and the macros stored there
+  *
+  * @param  Idx             Macro that grows or shrinks, its offset does not change
+  * @param  At              First pool byte to move
+  * @param  Delta           Bytes to open (positive) or to remove before At (negative)
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void MACRO_Shift(int8_t Idx, uint16_t At, int16_t Delta)
+{
+    int8_t i;
+
+    memmove(&MACRO_Pool[At + Delta], &MACRO_Pool[At], MACRO_Used - At);
+    MACRO_Used += Delta;
+
+    for(i = 0; i < MACRO_MAX; i++)
+    {
+        if((i != Idx) && (MACRO_Table[i].Name[0] != '\0') && (MACRO_Table[i].Offset >= At))
+        {
+            MACRO_Table[i].Offset += Delta;
+        }
+    }
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Add text at the end of a macro
+  *
+  * @param  Idx             Macro
+  * @param  pData           Text
+  * @param  Len             Text length
+  *
+  * @retval bool            false if the pool is full, nothing is added then
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static bool MACRO_Insert(int8_t Idx, const char* pData, uint16_t Len)
+{
+    uint16_t End;
+
+    if(Len > (MACRO_POOL_SIZE - MACRO_Used))
+    {
+        return false;
+    }
+
+    End = MACRO_Table[Idx].Offset + MACRO_Table[Idx].Len;
+    MACRO_Shift(Idx, End, Len);
+    memcpy(&MACRO_Pool[End], pData, Len);
+    MACRO_Table[Idx].Len += Len;
+
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Cut a macro body to a shorter length
+  *
+  * @param  Idx             Macro
+  * @param  Len             New length
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void MACRO_Truncate(int8_t Idx, uint16_t Len)
+{
+    uint16_t End;
+
+    if(Len < MACRO_Table[Idx].Len)
+    {
+        End = MACRO_Table[Idx].Offset + MACRO_Table[Idx].Len;
+        MACRO_Shift(Idx, End, -(int16_t)(MACRO_Table[Idx].Len - Len));
+        MACRO_Table[Idx].Len = Len;
+    }
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Create a macro, or replace the one with the same name
+  *
+  * @param  pName           Name, up to MACRO_NAME_SIZE - 1 letters, digits or '_'
+  * @param  pBody           ';' separated commands
+  *
+  * @retval bool            false if the name is invalid or there is no room left
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool MACRO_Define(const char* pName, const char* pBody)
+{
+    int8_t Idx;
+
+    MACRO_Delete(pName);
+
+    Idx = MACRO_Create(pName);
+    if(Idx == MACRO_NONE)
+    {
+        return false;
+    }
+
+    if(!MACRO_Insert(Idx, pBody, strlen(pBody)))
+    {
+        MACRO_Table[Idx].Name[0] = '\0';
+        return false;
+    }
+
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Add commands at the end of a macro, it is created if needed
+  *
+  * @param  pName           Name
+  * @param  pBody           ';' separated commands
+  *
+  * @retval bool            false if the name is invalid or there is no room left
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool MACRO_Append(const char* pName, const char* pBody)
+{
+    int8_t   Idx;
+    uint16_t Len;
+
+    Idx = MACRO_Find(pName);
+    if(Idx == MACRO_NONE)
+    {
+        return MACRO_Define(pName, pBody);
+    }
+
+    Len = strlen(pBody);
+    if(MACRO_Table[Idx].Len > 0)
+    {
+        if((Len + 1) > (MACRO_POOL_SIZE - MACRO_Used))
+        {
+            return false;
+        }
+        MACRO_Insert(Idx, ";", 1);
+    }
+
+    return MACRO_Insert(Idx, pBody, Len);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Forget a macro, a recording in it is stopped
+  *
+  * @param  pName           Name
+  *
+  * @retval bool            false if there is no such macro
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool MACRO_Delete(const char* pName)
+{
+    int8_t Idx;
+
+    Idx = MACRO_Find(pName);
+    if(Idx == MACRO_NONE)
+    {
+        return false;
+    }
+
+    MACRO_Truncate(Idx, 0);
+    MACRO_Table[Idx].Name[0] = '\0';
+
+    if(MACRO_RecIdx == Idx)
+    {
+        MACRO_RecIdx = MACRO_NONE;
+    }
+    if(MACRO_UndoIdx == Idx)
+    {
+        MACRO_UndoIdx = MACRO_NONE;
+    }
+
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Get the body of a macro
+  *
+  * @param  pName           Name
+  * @param  pLen            Returns the body length, the body is not null terminated
+  *
+  * @retval const char*     Body or NULL if there is no such macro. Valid until a macro is changed.
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+const char* MACRO_Get(const char* pName, uint16_t* pLen)
+{
+    int8_t Idx;
+
+    Idx = MACRO_Find(pName);
+    if(Idx == MACRO_NONE)
+    {
+        return NULL;
+    }
+
+    *pLen = MACRO_Table[Idx].Len;
+    return &MACRO_Pool[MACRO_Table[Idx].Offset];
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Number of table slots, used or not, to walk with MACRO_GetByIndex
+  *
+  * @param  none
+  *
+  * @retval uint8_t         MACRO_MAX
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint8_t MACRO_GetCount(void)
+{
+    return MACRO_MAX;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Get a macro by table slot
+  *
+  * @param  Idx             Slot, 0 to MACRO_GetCount() - 1
+  * @param  ppBody          Returns the body, not null terminated
+  * @param  pLen            Returns the body length
+  *
+  * @retval const char*     Name or NULL if the slot is free
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+const char* MACRO_GetByIndex(uint8_t Idx, const char** ppBody, uint16_t* pLen)
+{
+    if((Idx >= MACRO_MAX) || (MACRO_Table[Idx].Name[0] == '\0'))
+    {
+        return NULL;
+    }
+
+    *ppBody = &MACRO_Pool[MACRO_Table[Idx].Offset];
+    *pLen   = MACRO_Table[Idx].Len;
+    return MACRO_Table[Idx].Name;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Room left in the pool
+  *
+  * @param  none
+  *
+  * @retval uint16_t        Free bytes
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t MACRO_GetFree(void)
+{
+    return MACRO_POOL_SIZE - MACRO_Used;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Empty a macro, or create it, and record the next successful console commands in it
+  *
+  * @param  pName           Name
+  *
+  * @retval bool            false if the name is invalid or the table full
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool MACRO_RecordStart(const char* pName)
+{
+    if(!MACRO_Define(pName, ""))
+    {
+        return false;
+    }
+
+    MACRO_RecIdx = MACRO_Find(pName);
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Stop recording, the last recorded command can still be undone
+  *
+  * @param  none
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void MACRO_RecordStop(void)
+{
+    MACRO_RecIdx = MACRO_NONE;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Name of the macro being recorded
+  *
+  * @param  none
+  *
+  * @retval const char*     Name or NULL when not recording
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+const char* MACRO_GetRecording(void)
+{
+    return (MACRO_RecIdx == MACRO_NONE) ? NULL : MACRO_Table[MACRO_RecIdx].Name;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Add a command to the macro being recorded, before it runs
+  *
+  * @param  pCmd            Command, without ';'
+  *
+  * @retval bool            false if not recording or the pool is full
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool MACRO_RecordCmd(const char* pCmd)
+{
+    if(MACRO_RecIdx == MACRO_NONE)
+    {
+        return false;
+    }
+
+    MACRO_UndoIdx = MACRO_RecIdx;
+    MACRO_UndoLen = MACRO_Table[MACRO_RecIdx].Len;
+
+    return MACRO_Append(MACRO_Table[MACRO_RecIdx].Name, pCmd);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Remove the last recorded command, when it failed or when it stopped the recording
+  *
+  * @param  none
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void MACRO_RecordUndo(void)
+{
+    if(MACRO_UndoIdx != MACRO_NONE)
+    {
+        MACRO_Truncate(MACRO_UndoIdx, MACRO_UndoLen);
+        MACRO_UndoIdx = MACRO_NONE;
+    }
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Write all the macros in MACRO_FILE, the volume must be mounted by the firmware
+  *
+  * @param  none
+  *
+  * @retval FRESULT         FatFs result
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+FRESULT MACRO_Save(void)
+{
+    FRESULT res;
+    UINT    written;
+    uint8_t Idx;
+
+    res = f_open(&USERFile, MACRO_FILE, FA_CREATE_ALWAYS | FA_WRITE);
+    for(Idx = 0; (res == FR_OK) && (Idx < MACRO_MAX); Idx++)
+    {
+        if(MACRO_Table[Idx].Name[0] != '\0')
+        {
+            res = f_write(&USERFile, MACRO_Table[Idx].Name, strlen(MACRO_Table[Idx].Name), &written);
+            if(res == FR_OK)  res = f_write(&USERFile, " ", 1, &written);
+            if(res == FR_OK)  res = f_write(&USERFile, &MACRO_Pool[MACRO_Table[Idx].Offset], MACRO_Table[Idx].Len, &written);
+            if(res == FR_OK)  res = f_write(&USERFile, "\r\n", 2, &written);
+        }
+    }
+
+    if(res == FR_OK)
+    {
+        res = f_close(&USERFile);
+    }
+    else
+    {
+        f_close(&USERFile);
+    }
+
+    return res;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Replace all the macros by the ones of MACRO_FILE, the volume must be mounted by the firmware
+  *
+  * @param  none
+  *
+  * @retval FRESULT         FatFs result, FR_DENIED if the file does not fit, the macros read so far are kept
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+FRESULT MACRO_Load(void)
+{
+    FRESULT res;
+    UINT    readLen;
+    UINT    i;
+    char    chunk[MACRO_LOAD_CHUNK];
+    char    name[MACRO_NAME_SIZE];
+    uint8_t nameLen;
+    int8_t  Idx;
+    char    c;
+
+    res = f_open(&USERFile, MACRO_FILE, FA_OPEN_EXISTING | FA_READ);
+    if(res != FR_OK)
+    {
+        return res;
+    }
+
+    memset(MACRO_Table, 0, sizeof(MACRO_Table));
+    MACRO_Used    = 0;
+    MACRO_RecIdx  = MACRO_NONE;
+    MACRO_UndoIdx = MACRO_NONE;
+
+    Idx = MACRO_NONE;
+    nameLen = 0;
+    do
+    {
+        res = f_read(&USERFile, chunk, sizeof(chunk), &readLen);
+        for(i = 0; (res == FR_OK) && (i < readLen); i++)
+        {
+            c = chunk[i];
+            if((c == '\r') || (c == '\n'))
+            {
+                // A name alone on its line is an empty macro
+                if((Idx == MACRO_NONE) && (nameLen > 0))
+                {
+                    name[nameLen] = '\0';
+                    res = MACRO_Define(name, "") ? FR_OK : FR_DENIED;
+                }
+                Idx = MACRO_NONE;
+                nameLen = 0;
+            }
+            else if(Idx != MACRO_NONE)
+            {
+                res = MACRO_Insert(Idx, &c, 1) ? FR_OK : FR_DENIED;
+            }
+            else if(c == ' ')
+            {
+                if(nameLen == 0)
+                {
+                    continue;
+                }
+                name[nameLen] = '\0';
+                MACRO_Delete(name);
+                Idx = MACRO_Create(name);
+                res = (Idx != MACRO_NONE) ? FR_OK : FR_DENIED;
+            }
+            else if(nameLen < (MACRO_NAME_SIZE - 1))
+            {
+                name[nameLen++] = c;
+            }
+            else
+            {
+                res = FR_DENIED;
+            }
+        }
+    }
+    while((res == FR_OK) && (readLen == sizeof(chunk)));
+
+    // Last line without end of line
+    if((res == FR_OK) && (Idx == MACRO_NONE) && (nameLen > 0))
+    {
+        name[nameLen] = '\0';
+        res = MACRO_Define(name, "") ? FR_OK : FR_DENIED;
+    }
+
+    f_close(&USERFile);
+    return res;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
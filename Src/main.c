@@ -116,7 +116,7 @@ int main(void)
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_USART1_UART_Init();
-  //MX_FATFS_Init();
+  MX_FATFS_Init();
   MX_USB_DEVICE_Init();
   MX_CRC_Init();
   MX_CAN_Init();
@@ -0,0 +1,411 @@
+/**********************************************************************************************************************
+ * @file    payload.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Bus payload parser
+ *
+ *          Turns the argument of a write command into bytes. The text is read in place, without strtok and
+ *          without modifying it, and the bytes go straight into the caller buffer. Items are separated by spaces,
+ *          ',' or '.':
+ *
+ *              1F 0x1F 0b00011111 0d31     Bytes, bare numbers are hex as they always were in this console
+ *              0x1234:16 0x1234:16le       16 or 32 bits words, big endian unless "le" follows the width
+ *              00-0F                       Range, both ends included, counting down when the end is lower
+ *              "text\r\n" 'text'           String, \r \n \t \0 \\ \" \' and \xHH escapes
+ *              0xFF*256 "ab"*4 0-3*2       Repeat the item, the count is decimal unless prefixed
+ *
+ *          A repeat copies the bytes of the item already written, doubling the copied block each pass, so a
+ *          full page of filler costs a few memcpy.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "payload.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint8_t*    pOut;
+    size_t      Size;
+    size_t      Len;
+}PAYLOAD_Out_t;
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static bool             PAYLOAD_IsDelim     (char c);
+static int8_t           PAYLOAD_Digit       (char c, uint8_t Base);
+static const char*      PAYLOAD_Number      (const char* p, uint8_t DefaultBase, uint32_t* pValue);
+static const char*      PAYLOAD_String      (const char* p, PAYLOAD_Out_t* pOut, PAYLOAD_Status_e* pStatus);
+static PAYLOAD_Status_e PAYLOAD_Words       (PAYLOAD_Out_t* pOut, uint32_t First, uint32_t Last, uint8_t Width,
+                                             bool LittleEndian);
+static PAYLOAD_Status_e PAYLOAD_Repeat      (PAYLOAD_Out_t* pOut, size_t Start, uint32_t Count);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+static const char* PAYLOAD_StatusName[] =
+{
+    "ok",
+    "syntax error",
+    "value too large for the word",
+    "payload too large",
+};
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+static bool PAYLOAD_IsDelim(char c)
+{
+    return (c == ' ') || (c == ',') || (c == '.') || (c == '\t') || (c == '\0');
+}
+
+// Value of a digit in a base, -1 if it is not one
+static int8_t PAYLOAD_Digit(char c, uint8_t Base)
+{
+    int8_t Digit;
+
+    if((c >= '0') && (c <= '9'))        Digit = c - '0';
+    else if((c >= 'a') && (c <= 'f'))   Digit = c - 'a' + 10;
+    else if((c >= 'A') && (c <= 'F'))   Digit = c - 'A' + 10;
+    else                                return -1;
+
+    return (Digit < Base) ? Digit : -1;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Read a number, a 0x, 0b or 0d prefix followed by a digit of its base overrides the default base
+  *
+  * @param  p               First char of the number
+  * @param  DefaultBase     Base without prefix
+  * @param  pValue          Value read
+  *
+  * @retval const char*     First char after the number, NULL if there is no digit or the value overflows 32 bits
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static const char* PAYLOAD_Number(const char* p, uint8_t DefaultBase, uint32_t* pValue)
+{
+    uint8_t     Base = DefaultBase;
+    uint32_t    Value = 0;
+    int8_t      Digit;
+    const char* pStart;
+
+    if(p[0] == '0')
+    {
+        if(((p[1] == 'x') || (p[1] == 'X')) && (PAYLOAD_Digit(p[2], 16) >= 0))      Base = 16;
+        else if(((p[1] == 'b') || (p[1] == 'B')) && (PAYLOAD_Digit(p[2], 2) >= 0))  Base = 2;
+        else if(((p[1] == 'd') || (p[1] == 'D')) && (PAYLOAD_Digit(p[2], 10) >= 0)) Base = 10;
+        else                                                                        Base = 0;
+
+        p    += (Base != 0) ? 2 : 0;
+        Base  = (Base != 0) ? Base : DefaultBase;
+    }
+
+    for(pStart = p; (Digit = PAYLOAD_Digit(*p, Base)) >= 0; p++)
+    {
+        if(Value > ((UINT32_MAX - (uint32_t)Digit) / Base))
+        {
+            return NULL;
+        }
+        Value = (Value * Base) + (uint32_t)Digit;
+    }
+
+    *pValue = Value;
+    return (p != pStart) ? p : NULL;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Write the bytes of a quoted string
+  *
+  * @param  p               Opening quote, the same quote closes the string
+  * @param  pOut            Output
+  * @param  pStatus         Set on error
+  *
+  * @retval const char*     First char after the closing quote, NULL on error
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static const char* PAYLOAD_String(const char* p, PAYLOAD_Out_t* pOut, PAYLOAD_Status_e* pStatus)
+{
+    char    Quote = *p++;
+    uint8_t Byte;
+    int8_t  Hi;
+    int8_t  Lo;
+
+    while(*p != Quote)
+    {
+        if(*p == '\0')
+        {
+            *pStatus = PAYLOAD_ERR_SYNTAX;
+            return NULL;
+        }
+
+        Byte = (uint8_t)*p++;
+
+        if(Byte == '\\')
+        {
+            switch(*p++)
+            {
+                case 'n':   Byte = '\n';    break;
+                case 'r':   Byte = '\r';    break;
+                case 't':   Byte = '\t';    break;
+                case '0':   Byte = '\0';    break;
+                case '\\':  Byte = '\\';    break;
+                case '"':   Byte = '"';     break;
+                case '\'':  Byte = '\'';    break;
+                case 'x':
+                {
+                    Hi = PAYLOAD_Digit(p[0], 16);
+                    Lo = (Hi >= 0) ? PAYLOAD_Digit(p[1], 16) : -1;
+                    if(Lo < 0)
+                    {
+                        *pStatus = PAYLOAD_ERR_SYNTAX;
+                        return NULL;
+                    }
+                    Byte = (uint8_t)((Hi << 4) | Lo);
+                    p += 2;
+                    break;
+                }
+                default:
+                {
+                    *pStatus = PAYLOAD_ERR_SYNTAX;
+                    return NULL;
+                }
+            }
+        }
+
+        if(pOut->Len >= pOut->Size)
+        {
+            *pStatus = PAYLOAD_ERR_FULL;
+            return NULL;
+        }
+        pOut->pOut[pOut->Len++] = Byte;
+    }
+
+    return p + 1;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Write the words from First to Last, both included
+  *
+  * @param  pOut            Output
+  * @param  First           First value
+  * @param  Last            Last value, equal to First for a single word
+  * @param  Width           Bytes per word, 1, 2 or 4
+  * @param  LittleEndian    Byte order of the words
+  *
+  * @retval PAYLOAD_Status_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static PAYLOAD_Status_e PAYLOAD_Words(PAYLOAD_Out_t* pOut, uint32_t First, uint32_t Last, uint8_t Width,
+                                      bool LittleEndian)
+{
+    uint32_t    Count;
+    uint32_t    Value;
+    uint8_t*    pDst;
+    uint8_t     i;
+
+    if((Width < 4) && ((First >> (Width * 8)) || (Last >> (Width * 8))))
+    {
+        return PAYLOAD_ERR_RANGE;
+    }
+
+    Count = ((Last >= First) ? (Last - First) : (First - Last)) + 1;
+    if((Count == 0) || (Count > ((pOut->Size - pOut->Len) / Width)))
+    {
+        return PAYLOAD_ERR_FULL;
+    }
+
+    pDst  = &pOut->pOut[pOut->Len];
+    pOut->Len += (size_t)Count * Width;
+    Value = First;
+
+    while(Count-- != 0)
+    {
+        for(i = 0; i < Width; i++)
+        {
+            pDst[LittleEndian ? i : (Width - 1 - i)] = (uint8_t)(Value >> (i * 8));
+        }
+        pDst  += Width;
+        Value += (Last >= First) ? 1 : -1;
+    }
+
+    return PAYLOAD_OK;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Repeat the bytes written since Start so they appear Count times
+  *
+  * @param  pOut            Output
+  * @param  Start           First byte of the item
+  * @param  Count           Total number of copies, 0 removes the item
+  *
+  * @retval PAYLOAD_Status_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static PAYLOAD_Status_e PAYLOAD_Repeat(PAYLOAD_Out_t* pOut, size_t Start, uint32_t Count)
+{
+    uint8_t*    pItem = &pOut->pOut[Start];
+    size_t      ItemLen = pOut->Len - Start;
+    size_t      Total;
+    size_t      Done;
+    size_t      Chunk;
+
+    if((ItemLen == 0) || (Count == 1))
+    {
+        return PAYLOAD_OK;
+    }
+
+    if(Count > ((pOut->Size - Start) / ItemLen))
+    {
+        return PAYLOAD_ERR_FULL;
+    }
+
+    Total = ItemLen * Count;
+
+    if(ItemLen == 1)
+    {
+        memset(pItem, *pItem, Total);
+    }
+    else
+    {
+        for(Done = ItemLen; Done < Total; Done += Chunk)
+        {
+            Chunk = ((Total - Done) < Done) ? (Total - Done) : Done;
+            memcpy(&pItem[Done], pItem, Chunk);
+        }
+    }
+
+    pOut->Len = Start + Total;
+    return PAYLOAD_OK;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Parse a payload into a buffer
+  *
+  * @param  pStr            Null terminated text, not modified
+  * @param  pOut            Output buffer
+  * @param  OutSize         Output buffer size
+  * @param  pLen            Bytes written, also set on error
+  * @param  pErrPos         Offset in pStr of the faulty item, may be NULL
+  *
+  * @retval PAYLOAD_Status_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+PAYLOAD_Status_e PAYLOAD_Parse(const char* pStr, uint8_t* pOut, size_t OutSize, size_t* pLen, size_t* pErrPos)
+{
+    PAYLOAD_Out_t       Out = { pOut, OutSize, 0 };
+    PAYLOAD_Status_e    Status = PAYLOAD_OK;
+    const char*         p = pStr;
+    const char*         pItem = pStr;
+    size_t              Start;
+    uint32_t            First;
+    uint32_t            Last;
+    uint32_t            Width;
+    uint32_t            Count;
+    bool                LittleEndian;
+
+    while(Status == PAYLOAD_OK)
+    {
+        while((*p != '\0') && PAYLOAD_IsDelim(*p))
+        {
+            p++;
+        }
+
+        if(*p == '\0')
+        {
+            break;
+        }
+
+        pItem = p;
+        Start = Out.Len;
+
+        if((*p == '"') || (*p == '\''))
+        {
+            p = PAYLOAD_String(p, &Out, &Status);
+        }
+        else
+        {
+            Width = 1;
+            LittleEndian = false;
+
+            p = PAYLOAD_Number(p, 16, &First);
+            Last = First;
+
+            if((p != NULL) && (*p == '-'))
+            {
+                p = PAYLOAD_Number(p + 1, 16, &Last);
+            }
+
+            if((p != NULL) && (*p == ':'))
+            {
+                p = PAYLOAD_Number(p + 1, 10, &Width);
+                if((p != NULL) && (p[0] == 'l') && (p[1] == 'e'))
+                {
+                    LittleEndian = true;
+                    p += 2;
+                }
+                else if((p != NULL) && (p[0] == 'b') && (p[1] == 'e'))
+                {
+                    p += 2;
+                }
+
+                if((Width != 8) && (Width != 16) && (Width != 32))
+                {
+                    p = NULL;
+                }
+                Width /= 8;
+            }
+
+            if(p == NULL)
+            {
+                Status = PAYLOAD_ERR_SYNTAX;
+            }
+            else
+            {
+                Status = PAYLOAD_Words(&Out, First, Last, (uint8_t)Width, LittleEndian);
+            }
+        }
+
+        if((Status == PAYLOAD_OK) && (*p == '*'))
+        {
+            p = PAYLOAD_Number(p + 1, 10, &Count);
+            Status = (p == NULL) ? PAYLOAD_ERR_SYNTAX : PAYLOAD_Repeat(&Out, Start, Count);
+        }
+
+        if((Status == PAYLOAD_OK) && !PAYLOAD_IsDelim(*p))
+        {
+            Status = PAYLOAD_ERR_SYNTAX;
+        }
+    }
+
+    *pLen = Out.Len;
+    if(pErrPos != NULL)
+    {
+        *pErrPos = (Status == PAYLOAD_OK) ? 0 : (size_t)(pItem - pStr);
+    }
+
+    return Status;
+}
+
+const char* PAYLOAD_StatusStr(PAYLOAD_Status_e Status)
+{
+    return ((uint32_t)Status < (sizeof(PAYLOAD_StatusName) / sizeof(char*))) ? PAYLOAD_StatusName[Status] : "?";
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
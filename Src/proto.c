@@ -0,0 +1,396 @@
+/**********************************************************************************************************************
+ * @file    proto.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Binary command protocol of the console data mode
+ *
+ *          Requests are decoded straight from the console Rx ring and run one after the other in the console task.
+ *          I2C writes, reads and register reads go through the DMA driver (i2c_dma.c) and the task sleeps until the
+ *          STOP. The address only I2C probe, SPI, UART and CAN are still blocking HAL calls, as are the I2C words of
+ *          the bus sequences. The host does not have to wait for a response to send the next request, it can keep
+ *          several in flight and match the responses by their id. USB NAKs the host once the Rx ring is full,
+ *          nothing is lost.
+ *
+ *          The response is built over the request in the same buffer, arguments are read before any data is
+ *          written. Both CRC are computed by the CRC unit.
+ *
+ *          I2C addresses are the 8 bits ones printed by the bus scan, as for the i2c menu.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "proto.h"
+#include "frame.h"
+#include "cli.h"
+#include "crc.h"
+#include "usart.h"
+#include "can.h"
+#include "i2c_dma.h"
+#include "stm32f0xx_hal.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define PROTO_XFER_TIMEOUT      10      // ms per byte of an I2C probe, SPI or UART write
+#define PROTO_CAN_TIMEOUT       10      // ms to get a Tx mailbox and send
+#define PROTO_CAN_MAX_DATA      8
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static void             PROTO_Execute       (uint16_t Len);
+static void             PROTO_Reply         (PROTO_Status_e Status, uint16_t DataLen);
+static PROTO_Status_e   PROTO_Dispatch      (uint8_t Op, const uint8_t* pArgs, uint16_t ArgLen, uint8_t* pData,
+                                             uint16_t* pDataLen);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+extern I2C_HandleTypeDef    hi2c1;
+extern SPI_HandleTypeDef    hspi1;
+
+static uint8_t          PROTO_Packet[PROTO_MAX_PACKET];
+static uint8_t          PROTO_Frame[FRAME_ENCODED_SIZE(PROTO_MAX_PACKET)];
+static FRAME_Decoder_t  PROTO_Decoder;
+static CanTxMsgTypeDef  PROTO_CanTx;
+static CanRxMsgTypeDef  PROTO_CanRx;
+static bool             PROTO_CanFilterSet;
+static bool             PROTO_Exit;
+static uint32_t         PROTO_Requests;
+static uint32_t         PROTO_CrcErrors;
+static uint32_t         PROTO_Dropped;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+static uint16_t PROTO_Get16(const uint8_t* pData)
+{
+    return (uint16_t)(pData[0] | (pData[1] << 8));
+}
+
+static uint32_t PROTO_Get32(const uint8_t* pData)
+{
+    return (uint32_t)pData[0] | ((uint32_t)pData[1] << 8) | ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24);
+}
+
+static void PROTO_Put32(uint8_t* pData, uint32_t Value)
+{
+    pData[0] = (uint8_t)Value;
+    pData[1] = (uint8_t)(Value >> 8);
+    pData[2] = (uint8_t)(Value >> 16);
+    pData[3] = (uint8_t)(Value >> 24);
+}
+
+static PROTO_Status_e PROTO_HalStatus(HAL_StatusTypeDef Status)
+{
+    switch(Status)
+    {
+        case HAL_OK:        return PROTO_OK;
+        case HAL_BUSY:      return PROTO_ERR_BUSY;
+        case HAL_TIMEOUT:   return PROTO_ERR_TIMEOUT;
+        default:            return PROTO_ERR_BUS;
+    }
+}
+
+static PROTO_Status_e PROTO_I2CStatus(I2C_DMA_Result_e Result)
+{
+    switch(Result)
+    {
+        case I2C_DMA_OK:        return PROTO_OK;
+        case I2C_DMA_BUSY:      return PROTO_ERR_BUSY;
+        case I2C_DMA_TIMEOUT:   return PROTO_ERR_TIMEOUT;
+        case I2C_DMA_BAD_ARG:   return PROTO_ERR_ARG;
+        default:                return PROTO_ERR_BUS;
+    }
+}
+
+// Reception is off until a filter is set, the first receive request lets every frame in FIFO 0
+static void PROTO_CanAcceptAll(void)
+{
+    CAN_FilterConfTypeDef Filter;
+
+    if(PROTO_CanFilterSet)
+    {
+        return;
+    }
+
+    Filter.FilterIdHigh         = 0;
+    Filter.FilterIdLow          = 0;
+    Filter.FilterMaskIdHigh     = 0;
+    Filter.FilterMaskIdLow      = 0;
+    Filter.FilterFIFOAssignment = CAN_FIFO0;
+    Filter.FilterNumber         = 0;
+    Filter.FilterMode           = CAN_FILTERMODE_IDMASK;
+    Filter.FilterScale          = CAN_FILTERSCALE_32BIT;
+    Filter.FilterActivation     = ENABLE;
+    Filter.BankNumber           = 14;
+
+    PROTO_CanFilterSet = (HAL_CAN_ConfigFilter(&hcan, &Filter) == HAL_OK);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run one operation
+  *
+  * @param  Op              Operation, PROTO_Op_e
+  * @param  pArgs           Arguments, overlapped by pData one byte further
+  * @param  ArgLen          Length of the arguments
+  * @param  pData           Response data
+  * @param  pDataLen        Length of the response data, left to 0 when there is none
+  *
+  * @retval PROTO_Status_e  Response status
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static PROTO_Status_e PROTO_Dispatch(uint8_t Op, const uint8_t* pArgs, uint16_t ArgLen, uint8_t* pData,
+                                     uint16_t* pDataLen)
+{
+    HAL_StatusTypeDef   Status;
+    I2C_DMA_Op_t        Ops[2];
+    I2C_DMA_Result_e    Result;
+    uint16_t            Len;
+    uint32_t            Timeout;
+
+    switch(Op)
+    {
+        case PROTO_OP_PING:
+            if(ArgLen > PROTO_MAX_DATA)
+            {
+                return PROTO_ERR_ARG;
+            }
+            memmove(pData, pArgs, ArgLen);
+            *pDataLen = ArgLen;
+            return PROTO_OK;
+
+        case PROTO_OP_I2C_WRITE:
+            if((ArgLen < 1) || (ArgLen > (PROTO_MAX_DATA + 1)))
+            {
+                return PROTO_ERR_ARG;
+            }
+            // An address alone is a probe, a transfer of no byte the DMA path does not make
+            if(ArgLen == 1)
+            {
+                return PROTO_HalStatus(HAL_I2C_Master_Transmit(&hi2c1, pArgs[0], NULL, 0, PROTO_XFER_TIMEOUT));
+            }
+            return PROTO_I2CStatus(I2C_DMA_Write(pArgs[0], &pArgs[1], ArgLen - 1));
+
+        case PROTO_OP_I2C_READ:
+        case PROTO_OP_I2C_REG:
+            Len = (ArgLen >= 3) ? PROTO_Get16(&pArgs[1]) : 0;
+            if((Len == 0) || (Len > PROTO_MAX_DATA) ||
+               ((Op == PROTO_OP_I2C_READ) && (ArgLen != 3)) ||
+               ((Op == PROTO_OP_I2C_REG) && (ArgLen != 4) && (ArgLen != 5)))
+            {
+                return PROTO_ERR_ARG;
+            }
+
+            // Register bytes in the order they go on the bus, then the read with a repeated START. The register
+            // is sent before the read overwrites it.
+            Ops[0].Type  = I2C_DMA_OP_WRITE;
+            Ops[0].Addr  = pArgs[0];
+            Ops[0].Len   = ArgLen - 3;
+            Ops[0].pData = (uint8_t*)&pArgs[3];
+            Ops[1].Type  = I2C_DMA_OP_READ;
+            Ops[1].Addr  = pArgs[0];
+            Ops[1].Len   = Len;
+            Ops[1].pData = pData;
+
+            if(Op == PROTO_OP_I2C_READ)
+            {
+                Result = I2C_DMA_Run(&Ops[1], 1);
+            }
+            else
+            {
+                Result = I2C_DMA_Run(Ops, 2);
+            }
+
+            *pDataLen = (Result == I2C_DMA_OK) ? Len : 0;
+            return PROTO_I2CStatus(Result);
+
+        case PROTO_OP_SPI_XFER:
+            if((ArgLen < 1) || (ArgLen > PROTO_MAX_DATA))
+            {
+                return PROTO_ERR_ARG;
+            }
+            // In place, byte n is received after byte n went out
+            memmove(pData, pArgs, ArgLen);
+            Status = HAL_SPI_TransmitReceive(&hspi1, pData, pData, ArgLen, PROTO_XFER_TIMEOUT * ArgLen);
+            *pDataLen = (Status == HAL_OK) ? ArgLen : 0;
+            return PROTO_HalStatus(Status);
+
+        case PROTO_OP_UART_WRITE:
+            if(ArgLen < 1)
+            {
+                return PROTO_ERR_ARG;
+            }
+            return PROTO_HalStatus(HAL_UART_Transmit(&huart1, (uint8_t*)pArgs, ArgLen, PROTO_XFER_TIMEOUT * ArgLen));
+
+        case PROTO_OP_UART_READ:
+            Len = (ArgLen == 4) ? PROTO_Get16(pArgs) : 0;
+            if((Len == 0) || (Len > PROTO_MAX_DATA))
+            {
+                return PROTO_ERR_ARG;
+            }
+            Timeout = PROTO_Get16(&pArgs[2]);
+
+            Status = HAL_UART_Receive(&huart1, pData, Len, Timeout);
+
+            // The HAL counts the byte it waits for as received, what came before the timeout is still returned
+            *pDataLen = (Status == HAL_OK) ? Len :
+                        (Status == HAL_TIMEOUT) ? (Len - huart1.RxXferCount - 1) : 0;
+            return PROTO_HalStatus(Status);
+
+        case PROTO_OP_CAN_SEND:
+            if((ArgLen < 4) || (ArgLen > (4 + PROTO_CAN_MAX_DATA)))
+            {
+                return PROTO_ERR_ARG;
+            }
+            PROTO_CanTx.IDE   = (PROTO_Get32(pArgs) & PROTO_CAN_EXT_ID) ? CAN_ID_EXT : CAN_ID_STD;
+            PROTO_CanTx.StdId = PROTO_Get32(pArgs) & 0x7FF;
+            PROTO_CanTx.ExtId = PROTO_Get32(pArgs) & 0x1FFFFFFF;
+            PROTO_CanTx.RTR   = CAN_RTR_DATA;
+            PROTO_CanTx.DLC   = ArgLen - 4;
+            memcpy(PROTO_CanTx.Data, &pArgs[4], PROTO_CanTx.DLC);
+
+            hcan.pTxMsg = &PROTO_CanTx;
+            return PROTO_HalStatus(HAL_CAN_Transmit(&hcan, PROTO_CAN_TIMEOUT));
+
+        case PROTO_OP_CAN_RECV:
+            if(ArgLen != 2)
+            {
+                return PROTO_ERR_ARG;
+            }
+            Timeout = PROTO_Get16(pArgs);
+            PROTO_CanAcceptAll();
+
+            hcan.pRxMsg = &PROTO_CanRx;
+            Status = HAL_CAN_Receive(&hcan, CAN_FIFO0, Timeout);
+            if(Status == HAL_OK)
+            {
+                PROTO_Put32(pData, (PROTO_CanRx.IDE == CAN_ID_EXT) ? (PROTO_CanRx.ExtId | PROTO_CAN_EXT_ID) :
+                                                                     PROTO_CanRx.StdId);
+                memcpy(&pData[4], PROTO_CanRx.Data, PROTO_CanRx.DLC);
+                *pDataLen = 4 + PROTO_CanRx.DLC;
+            }
+            return PROTO_HalStatus(Status);
+
+        case PROTO_OP_EXIT:
+            PROTO_Exit = true;
+            return PROTO_OK;
+
+        default:
+            return PROTO_ERR_OP;
+    }
+}
+
+// Check a decoded request, run it and answer
+static void PROTO_Execute(uint16_t Len)
+{
+    PROTO_Status_e  Status;
+    uint16_t        DataLen = 0;
+
+    // Too short to carry an id, nothing to answer to
+    if(Len < (PROTO_REQ_HEADER + PROTO_CRC_SIZE))
+    {
+        PROTO_Dropped++;
+        return;
+    }
+
+    Len -= PROTO_CRC_SIZE;
+    if(CRC_Calc(PROTO_Packet, Len) != PROTO_Get32(&PROTO_Packet[Len]))
+    {
+        PROTO_CrcErrors++;
+        Status = PROTO_ERR_CRC;
+    }
+    else
+    {
+        PROTO_Requests++;
+        Status = PROTO_Dispatch(PROTO_Packet[1], &PROTO_Packet[PROTO_REQ_HEADER], Len - PROTO_REQ_HEADER,
+                                &PROTO_Packet[PROTO_RSP_HEADER], &DataLen);
+    }
+
+    PROTO_Reply(Status, DataLen);
+}
+
+// Id and op are still those of the request, the data is already in place
+static void PROTO_Reply(PROTO_Status_e Status, uint16_t DataLen)
+{
+    uint16_t Len;
+
+    Len = PROTO_RSP_HEADER + DataLen;
+    PROTO_Packet[2] = (uint8_t)Status;
+    PROTO_Put32(&PROTO_Packet[Len], CRC_Calc(PROTO_Packet, Len));
+
+    Len = FRAME_Encode(PROTO_Packet, Len + PROTO_CRC_SIZE, PROTO_Frame, sizeof(PROTO_Frame));
+    CLI_Send((char*)PROTO_Frame, Len);
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Start a binary session, the counters are cleared
+  *
+  *         A lone delimiter is sent first, it ends whatever text the host decoder got before.
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void PROTO_Start(void)
+{
+    uint8_t Delimiter = FRAME_DELIMITER;
+
+    FRAME_DecoderInit(&PROTO_Decoder, PROTO_Packet, sizeof(PROTO_Packet));
+    PROTO_Exit      = false;
+    PROTO_Requests  = 0;
+    PROTO_CrcErrors = 0;
+    PROTO_Dropped   = 0;
+
+    CLI_Send((char*)&Delimiter, 1);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Decode received bytes and run the complete requests
+  *
+  * @param  pData           Received bytes
+  * @param  Len             Number of bytes
+  *
+  * @retval bool            false once the host asked to leave, the bytes after its request are ignored
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool PROTO_Rx(const uint8_t* pData, uint16_t Len)
+{
+    uint16_t Used;
+    int32_t  FrameLen;
+
+    while((Len > 0) && !PROTO_Exit)
+    {
+        Used = FRAME_Decode(&PROTO_Decoder, pData, Len, &FrameLen);
+        pData += Used;
+        Len -= Used;
+
+        if(FrameLen == FRAME_DROPPED)
+        {
+            PROTO_Dropped++;
+        }
+        else if(FrameLen != FRAME_NONE)
+        {
+            PROTO_Execute((uint16_t)FrameLen);
+        }
+    }
+
+    return !PROTO_Exit;
+}
+
+// Session report, printed once back in text mode
+void PROTO_ShowStats(void)
+{
+    CLI_Printf("\r\nBinary mode : %lu requests, %lu CRC errors, %lu frames dropped", PROTO_Requests, PROTO_CrcErrors,
+               PROTO_Dropped);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,220 @@
+/**********************************************************************************************************************
+ * @file    ring.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Single producer / single consumer byte ring
+ *
+ *          The producer only moves Head and the consumer only moves Tail, so one side can live in an interrupt
+ *          without any locking. When several threads write in the same ring, the caller has to serialize them.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "ring.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Attach a buffer to the ring and empty it
+  *
+  * @param  pRing           Ring to initialize
+  * @param  pBuff           Storage, Size bytes
+  * @param  Size            Storage size, must be a power of 2
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void RING_Init(RING_t *pRing, uint8_t *pBuff, uint16_t Size)
+{
+    pRing->pBuff = pBuff;
+    pRing->Size  = Size;
+    pRing->Head  = 0;
+    pRing->Tail  = 0;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Drop everything pending in the ring, consumer side only
+  *
+  * @param  pRing           Ring to flush
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void RING_Flush(RING_t *pRing)
+{
+    pRing->Tail = pRing->Head;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Number of bytes waiting to be read
+  *
+  * @param  pRing           Ring
+  *
+  * @retval uint16_t        Pending bytes
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t RING_Count(RING_t *pRing)
+{
+    return (uint16_t)(pRing->Head - pRing->Tail);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Number of bytes that can still be written
+  *
+  * @param  pRing           Ring
+  *
+  * @retval uint16_t        Free bytes
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t RING_Free(RING_t *pRing)
+{
+    return pRing->Size - RING_Count(pRing);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Copy as much as possible of pData in the ring
+  *
+  * @param  pRing           Ring
+  * @param  pData           Data to write
+  * @param  Len             Data length
+  *
+  * @retval uint16_t        Number of bytes written, less than Len when the ring is full
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t RING_Write(RING_t *pRing, const uint8_t *pData, uint16_t Len)
+{
+    uint16_t Head;
+    uint16_t Idx;
+    uint16_t Chunk;
+    uint16_t Free;
+
+    Free = RING_Free(pRing);
+    if(Len > Free)
+    {
+        Len = Free;
+    }
+
+    Head  = pRing->Head;
+    Idx   = Head & (pRing->Size - 1);
+    Chunk = pRing->Size - Idx;
+    if(Chunk > Len)
+    {
+        Chunk = Len;
+    }
+
+    memcpy(&pRing->pBuff[Idx], pData, Chunk);
+    memcpy(pRing->pBuff, pData + Chunk, Len - Chunk);
+
+    // Publish only once the data is in place
+    pRing->Head = Head + Len;
+
+    return Len;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Copy up to Len pending bytes out of the ring
+  *
+  * @param  pRing           Ring
+  * @param  pData           Destination
+  * @param  Len             Destination size
+  *
+  * @retval uint16_t        Number of bytes read
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t RING_Read(RING_t *pRing, uint8_t *pData, uint16_t Len)
+{
+    uint16_t Tail;
+    uint16_t Idx;
+    uint16_t Chunk;
+    uint16_t Count;
+
+    Count = RING_Count(pRing);
+    if(Len > Count)
+    {
+        Len = Count;
+    }
+
+    Tail  = pRing->Tail;
+    Idx   = Tail & (pRing->Size - 1);
+    Chunk = pRing->Size - Idx;
+    if(Chunk > Len)
+    {
+        Chunk = Len;
+    }
+
+    memcpy(pData, &pRing->pBuff[Idx], Chunk);
+    memcpy(pData + Chunk, pRing->pBuff, Len - Chunk);
+
+    pRing->Tail = Tail + Len;
+
+    return Len;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Get the longest contiguous block of pending bytes without consuming it
+  *
+  * @param  pRing           Ring
+  * @param  ppData          Returns a pointer on the first pending byte
+  *
+  * @retval uint16_t        Contiguous length, call RING_Skip once done with it
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t RING_Peek(RING_t *pRing, uint8_t **ppData)
+{
+    uint16_t Idx;
+    uint16_t Chunk;
+    uint16_t Count;
+
+    Count = RING_Count(pRing);
+    Idx   = pRing->Tail & (pRing->Size - 1);
+    Chunk = pRing->Size - Idx;
+
+    *ppData = &pRing->pBuff[Idx];
+
+    return (Chunk < Count) ? Chunk : Count;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Consume Len bytes previously returned by RING_Peek
+  *
+  * @param  pRing           Ring
+  * @param  Len             Number of bytes to release
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void RING_Skip(RING_t *pRing, uint16_t Len)
+{
+    pRing->Tail += Len;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
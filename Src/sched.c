@@ -0,0 +1,287 @@
+/**********************************************************************************************************************
+ * @file    sched.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Console commands repeated at a fixed period
+ *
+ *          Each job owns a free running nOS timer. The timer callback only stamps the release time and wakes the
+ *          console task, the command itself runs in the console task between two typed lines, so it never races
+ *          with the commands typed by the user. The release stamp is taken at the tick, the output is prefixed by
+ *          the start stamp, both on the host correlated time base. Releases land on tick boundaries, so the jitter is
+ *          measured between two starts: it is what the console task adds, a typed command running when the job is
+ *          released delays it by its own run time.
+ *
+ *          A release finding the previous one still waiting or running is dropped and counted as an overrun.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "sched.h"
+#include "nOS.h"
+#include "cli.h"
+#include "cli_menu.h"
+#include "timestamp.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define SCHED_MS_TO_TICKS(ms)   ((((ms) * NOS_CONFIG_TICKS_PER_SECOND) + 999) / 1000)
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    nOS_Timer           Timer;
+    bool                Active;
+    volatile bool       Pending;        // Released, cleared once the run is done
+    volatile uint32_t   ReleaseUs;
+    volatile uint32_t   Overruns;
+    uint32_t            PrevStartUs;
+    uint32_t            PrevOverruns;   // Overruns at the previous run, a gap in the releases skips the jitter
+    uint32_t            PeriodMs;
+    uint8_t             Menu;
+    char                Cmd[SCHED_CMD_SIZE];
+    uint32_t            Runs;
+    uint32_t            Errors;
+    uint32_t            MaxLate;
+    uint32_t            MaxJitter;
+    uint32_t            MaxRun;
+}SCHED_Job_t;
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static void SCHED_Release   (nOS_Timer* pTimer, void* pArg);
+static void SCHED_Run       (uint8_t Id);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+SCHED_Job_t     SCHED_Jobs[SCHED_MAX_JOBS];
+char            SCHED_RunCmd[SCHED_CMD_SIZE];   // Command of the running job, the parser modifies it
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Timer callback, flags the job and wakes the console task
+  *
+  * @param  pTimer          Timer of the job
+  * @param  pArg            Job
+  *
+  * @retval None
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void SCHED_Release(nOS_Timer* pTimer, void* pArg)
+{
+    SCHED_Job_t* pJob = (SCHED_Job_t*)pArg;
+
+    (void)pTimer;
+
+    if(pJob->Pending)
+    {
+        pJob->Overruns++;
+        return;
+    }
+
+    pJob->ReleaseUs = (uint32_t)TS_GetUs();
+    pJob->Pending   = true;
+    CLI_Wake();
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run a released job in the console task and update its counters
+  *
+  * @param  Id              Job
+  *
+  * @retval None
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void SCHED_Run(uint8_t Id)
+{
+    SCHED_Job_t*    pJob = &SCHED_Jobs[Id];
+    uint64_t        Now;
+    uint32_t        Start;
+    uint32_t        Late;
+    uint32_t        Jitter;
+    uint32_t        Overruns;
+    uint32_t        PeriodUs;
+
+    Now      = TS_GetUs();
+    Start    = (uint32_t)Now;
+    Late     = Start - pJob->ReleaseUs;
+    Overruns = pJob->Overruns;
+    PeriodUs = pJob->PeriodMs * 1000;
+
+    if((pJob->Runs != 0) && (Overruns == pJob->PrevOverruns))
+    {
+        Jitter = Start - pJob->PrevStartUs;
+        Jitter = (Jitter > PeriodUs) ? (Jitter - PeriodUs) : (PeriodUs - Jitter);
+        pJob->MaxJitter = (Jitter > pJob->MaxJitter) ? Jitter : pJob->MaxJitter;
+    }
+
+    pJob->PrevStartUs   = Start;
+    pJob->PrevOverruns  = Overruns;
+    pJob->MaxLate       = (Late > pJob->MaxLate) ? Late : pJob->MaxLate;
+
+    CLI_Printf("\r\n[%lu.%06lu] job %u", (uint32_t)(Now / 1000000), (uint32_t)(Now % 1000000), Id);
+
+    strcpy(SCHED_RunCmd, pJob->Cmd);
+    if(!CLI_MENU_ExecIn(pJob->Menu, SCHED_RunCmd))
+    {
+        pJob->Errors++;
+    }
+
+    Start = (uint32_t)TS_GetUs() - Start;
+    pJob->MaxRun = (Start > pJob->MaxRun) ? Start : pJob->MaxRun;
+    pJob->Runs++;
+    pJob->Pending = false;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Start repeating a command
+  *
+  * @param  PeriodMs        Period, rounded up to the nOS tick
+  * @param  Menu            Menu the command is run in
+  * @param  pCmd            Command as typed in the console, one command, copied
+  *
+  * @retval int8_t          Job number or SCHED_NONE if the table is full, the period is 0 or the command too long
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+int8_t SCHED_Add(uint32_t PeriodMs, uint8_t Menu, const char* pCmd)
+{
+    SCHED_Job_t*    pJob;
+    int8_t          Id;
+
+    if((PeriodMs == 0) || (strlen(pCmd) >= SCHED_CMD_SIZE))
+    {
+        return SCHED_NONE;
+    }
+
+    for(Id = 0; (Id < SCHED_MAX_JOBS) && SCHED_Jobs[Id].Active; Id++);
+
+    if(Id == SCHED_MAX_JOBS)
+    {
+        return SCHED_NONE;
+    }
+
+    pJob = &SCHED_Jobs[Id];
+    memset(pJob, 0, sizeof(SCHED_Job_t));
+    strcpy(pJob->Cmd, pCmd);
+    pJob->PeriodMs = PeriodMs;
+    pJob->Menu     = Menu;
+
+    if(nOS_TimerCreate(&pJob->Timer, SCHED_Release, pJob, SCHED_MS_TO_TICKS(PeriodMs), NOS_TIMER_FREE_RUNNING) != NOS_OK)
+    {
+        return SCHED_NONE;
+    }
+
+    pJob->Active = true;
+    nOS_TimerStart(&pJob->Timer);
+
+    return Id;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Stop a job and free its slot
+  *
+  * @param  Id              Job
+  *
+  * @retval bool            false if there is no such job
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool SCHED_Stop(uint8_t Id)
+{
+    if((Id >= SCHED_MAX_JOBS) || !SCHED_Jobs[Id].Active)
+    {
+        return false;
+    }
+
+    nOS_TimerDelete(&SCHED_Jobs[Id].Timer);
+    SCHED_Jobs[Id].Active  = false;
+    SCHED_Jobs[Id].Pending = false;
+
+    return true;
+}
+
+void SCHED_StopAll(void)
+{
+    uint8_t Id;
+
+    for(Id = 0; Id < SCHED_MAX_JOBS; Id++)
+    {
+        SCHED_Stop(Id);
+    }
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Get the command and the counters of a job
+  *
+  * @param  Id              Job
+  * @param  pInfo           Filled with the job counters
+  *
+  * @retval bool            false if there is no such job
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool SCHED_GetInfo(uint8_t Id, SCHED_Info_t* pInfo)
+{
+    SCHED_Job_t* pJob;
+
+    if((Id >= SCHED_MAX_JOBS) || !SCHED_Jobs[Id].Active)
+    {
+        return false;
+    }
+
+    pJob = &SCHED_Jobs[Id];
+    pInfo->pCmd      = pJob->Cmd;
+    pInfo->PeriodMs  = pJob->PeriodMs;
+    pInfo->Runs      = pJob->Runs;
+    pInfo->Overruns  = pJob->Overruns;
+    pInfo->Errors    = pJob->Errors;
+    pInfo->MaxLate   = pJob->MaxLate;
+    pInfo->MaxJitter = pJob->MaxJitter;
+    pInfo->MaxRun    = pJob->MaxRun;
+
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run the released jobs, called by the console task when woken
+  *
+  * @param  None
+  *
+  * @retval bool            true if a job ran and printed
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool SCHED_Poll(void)
+{
+    uint8_t Id;
+    bool    Ran = false;
+
+    for(Id = 0; Id < SCHED_MAX_JOBS; Id++)
+    {
+        // Checked again for each job, a command may stop the others
+        if(SCHED_Jobs[Id].Active && SCHED_Jobs[Id].Pending)
+        {
+            SCHED_Run(Id);
+            Ran = true;
+        }
+    }
+
+    return Ran;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
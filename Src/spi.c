@@ -52,6 +52,8 @@
 #include "gpio.h"
 #include "defines.h"
 #include "nOS.h"
+#include "cli.h"
+#include "lat.h"
 
 /* USER CODE BEGIN 0 */
 
@@ -64,31 +66,15 @@ static void SPI_Task(void *arg);
 SPI_HandleTypeDef hspi1;
 nOS_Thread SPI_Thread;
 nOS_Stack SPI_Stack[SPI_STACK_SIZE];
-nOS_Queue SPI_RxQ;
-uint8_t RxQ_Buff[SPI_MAX_NUM_CMD][SPI_RXQ_SIZE];
-uint8_t CurrentCmn[SPI_RXQ_SIZE];
-uint8_t Rx_Buff[SPI_RXQ_SIZE];
-uint8_t CurrentCmd[SPI_RXQ_SIZE];
 
 /* Local Functions --------------------------------------------------------------------------------------------------*/
 
 static void SPI_Task(void *arg)
 {
     char testStr[] = "test";
-    memset(Rx_Buff, 0, SPI_RXQ_SIZE);
     CLI_Printf("[SPI] Task Started.\r\n");
     while(1)
     {
-        if(!nOS_QueueIsEmpty(&SPI_RxQ))
-        {
-            nOS_QueueRead(&SPI_RxQ, CurrentCmd, NOS_NO_WAIT);
-            CLI_Printf("\r\n");
-            for(int i=0; i<CurrentCmd[0]; i++)
-            {
-                CLI_Printf("%02X ", CurrentCmd[i+1]);
-            }
-            CLI_Printf("\r\n");
-        }
         HAL_SPI_Transmit_IT(&hspi1, testStr, 4);
         HAL_GPIO_TogglePin(GPIOC, GPIO_PIN_9);
         nOS_Sleep(50);
@@ -187,16 +173,44 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef* spiHandle)
 void SPI_Init()
 {
     MX_SPI1_Init();
-    nOS_QueueCreate(&SPI_RxQ, RxQ_Buff, SPI_RXQ_SIZE, SPI_MAX_NUM_CMD);
     nOS_ThreadCreate(&SPI_Thread, SPI_Task, NULL, SPI_Stack, SPI_STACK_SIZE, 1, "SPI Task");
     CLI_Printf("[SPI] Starting...\r\n");
 }
 
+// Sent in place, the caller's buffer is only reused by the next command so the transfer is waited for
 bool SPI_dataWrite(uint8_t *ptr, uint16_t len)
 {
-	static char sendBuff[256];
-	memcpy(sendBuff, ptr, len);
-    HAL_SPI_Transmit_IT(&hspi1, sendBuff, len);
+    uint32_t start;
+
+    LAT_Mark(LAT_MARK_BUS_START);
+    if(HAL_SPI_Transmit_IT(&hspi1, ptr, len) != HAL_OK)
+    {
+        return false;
+    }
+
+    start = HAL_GetTick();
+    while(HAL_SPI_GetState(&hspi1) == HAL_SPI_STATE_BUSY_TX)
+    {
+        if((HAL_GetTick() - start) > SPI_WRITE_TIMEOUT)
+        {
+            HAL_SPI_Abort(&hspi1);
+            return false;
+        }
+        nOS_Sleep(1);
+    }
+
+    return true;
+}
+
+// Also ends the background test frames of SPI_Task, only counted while a command has a transfer started
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    LAT_Mark(LAT_MARK_BUS_DONE);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    LAT_Mark(LAT_MARK_BUS_DONE);
 }
 
 /* USER CODE END 1 */
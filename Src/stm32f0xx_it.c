@@ -37,7 +37,8 @@
 #include "nOS.h"
 
 /* USER CODE BEGIN 0 */
-
+#include "i2c.h"
+#include "i2c_dma.h"
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
@@ -72,13 +73,41 @@ NOS_ISR(SysTick_Handler)
 /* please refer to the startup file (startup_stm32f0xx.s).                    */
 /******************************************************************************/
 
+/**
+* @brief This function handles DMA1 channel 2 and 3 interrupts.
+*/
+NOS_ISR(DMA1_Channel2_3_IRQHandler)
+{
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 0 */
+  I2C_DMA_ChannelIRQ();
+  /* USER CODE END DMA1_Channel2_3_IRQn 0 */
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 1 */
+
+  /* USER CODE END DMA1_Channel2_3_IRQn 1 */
+}
+
+/**
+* @brief This function handles TIM14 global interrupt.
+*/
+NOS_ISR(TIM14_IRQHandler)
+{
+  /* USER CODE BEGIN TIM14_IRQn 0 */
+  I2C_DMA_TimerIRQ();
+  /* USER CODE END TIM14_IRQn 0 */
+  /* USER CODE BEGIN TIM14_IRQn 1 */
+
+  /* USER CODE END TIM14_IRQn 1 */
+}
+
 /**
 * @brief This function handles I2C1 event global interrupt / I2C1 wake-up interrupt through EXTI line 23.
 */
 NOS_ISR(I2C1_IRQHandler)
 {
   /* USER CODE BEGIN I2C1_IRQn 0 */
-
+  if (I2C_ScanIRQ() || I2C_DMA_IRQ()) {
+    return;
+  }
   /* USER CODE END I2C1_IRQn 0 */
   if (hi2c1.Instance->ISR & (I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR)) {
     HAL_I2C_ER_IRQHandler(&hi2c1);
@@ -20,6 +20,14 @@
 #define STR_OPT_LOWERCASE           32   	// value in bit Position for base
 #define STR_OPT_SIGN_NEGATIVE       16     	// value in bit Position for sign
 #define STR_OPT_BASE_HEXA           8       // value in bit Position for base
+#define STR_OPT_SIGN_PLUS           4       // value in bit Position for '+' on positive value
+#define STR_OPT_SIGN_SPACE          2       // value in bit Position for ' ' on positive value
+#define STR_OPT_ALTERNATE           1       // value in bit Position for 0x prefix
+
+#define STR_NO_PRECISION            -1
+
+#define STR_DUMP_BYTES_PER_LINE     16
+#define STR_DUMP_LINE_MAX           (8 + 1 + (STR_DUMP_BYTES_PER_LINE * 3) + 2 + 1 + STR_DUMP_BYTES_PER_LINE + 1 + 2)
 
 #define STR_putchar(s,c)            {*((char*)s) = (char)(c);}
 
@@ -27,38 +35,173 @@
 
 typedef enum __STR_VarLength_e
 {
-    STR_VAR_16,
-    STR_VAR_32,
-    STR_VAR_64,
+    STR_VAR_CHAR,
+    STR_VAR_SHORT,
+    STR_VAR_INT,
+    STR_VAR_LONG,
+    STR_VAR_LONGLONG,
+    STR_VAR_SIZE,
 } STR_VarLength_e;
 
+// Context of the STR_vsnprintf sink
+typedef struct
+{
+    char*   pOut;
+    size_t  Size;
+    size_t  Count;
+} STR_BuffSink_t;
+
 
 /* Forward Declarations ---------------------------------------------------------------------------------------------*/
 
-static size_t STR_printi     (char* pOut, int64_t Value, size_t Width, uint8_t Option);
-static size_t STR_prints     (char* pOut, char* pString,  size_t Width, uint8_t Option);
+static char*  STR_utoa       (char* pEnd, uint64_t Value, uint8_t Option);
+static size_t STR_printi     (STR_Sink_t Sink, void* pCtx, uint64_t Value, bool Negative, size_t Width, int Precision, uint8_t Option);
+static size_t STR_prints     (STR_Sink_t Sink, void* pCtx, const char* pString, size_t Width, int Precision, uint8_t Option);
+static size_t STR_pad        (STR_Sink_t Sink, void* pCtx, char PadChar, size_t Count);
+static void   STR_BuffSink   (void* pCtx, const char* pData, size_t Len);
 
 /* Local Constants --------------------------------------------------------------------------------------------------*/
 
+static const char STR_PadSpace[] = "                ";
+static const char STR_PadZero[]  = "0000000000000000";
+
+// Two digits per division, the costly part of a decimal conversion
+static const char STR_DecPairs[] = "0001020304050607080910111213141516171819"
+                                     "2021222324252627282930313233343536373839"
+                                     "4041424344454647484950515253545556575859"
+                                     "6061626364656667686970717273747576777879"
+                                     "8081828384858687888990919293949596979899";
+
+#ifdef STR_USE_HEX_SUPPORT
+static const char STR_HexUpper[] = "0123456789ABCDEF";
+static const char STR_HexLower[] = "0123456789abcdef";
+#endif
+
 /* Local Variables --------------------------------------------------------------------------------------------------*/
 
 /* Local Functions --------------------------------------------------------------------------------------------------*/
 
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  *
+  * @brief  Send padding characters to the sink, by blocks
+  *
+  * @param  Sink            Output callback
+  * @param  pCtx            Output callback context
+  * @param  PadChar         ' ' or '0'
+  * @param  Count           Number of padding characters
+  *
+  * @retval size_t          Number of character printed
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static size_t STR_pad(STR_Sink_t Sink, void* pCtx, char PadChar, size_t Count)
+{
+    const char* pPad;
+    size_t      Chunk;
+    size_t      Total;
+
+    pPad  = (PadChar == '0') ? STR_PadZero : STR_PadSpace;
+    Total = Count;
+
+    while(Count > 0)
+    {
+        Chunk = (Count < (sizeof(STR_PadSpace) - 1)) ? Count : (sizeof(STR_PadSpace) - 1);
+        Sink(pCtx, pPad, Chunk);
+        Count -= Chunk;
+    }
+
+    return Total;
+}
+
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  *
+  * @brief  Convert an unsigned value to digits, from the end of the buffer
+  *
+  * @param  pEnd            One past the last digit
+  * @param  Value           Value to convert
+  * @param  Option          STR_OPT_BASE_HEXA and STR_OPT_LOWERCASE are used
+  *
+  * @retval char*           First digit, at least one digit is produced
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static char* STR_utoa(char* pEnd, uint64_t Value, uint8_t Option)
+{
+    const char* pPair;
+    uint32_t    Value32;
+  #ifdef STR_USE_HEX_SUPPORT
+    const char* pDigit;
+
+    if(Option & STR_OPT_BASE_HEXA)
+    {
+        pDigit = (Option & STR_OPT_LOWERCASE) ? STR_HexLower : STR_HexUpper;
+
+        do
+        {
+            *--pEnd = pDigit[Value & 0x0F];
+            Value >>= 4;
+        }
+        while(Value != 0);
+
+        return pEnd;
+    }
+  #else
+    (void)Option;
+  #endif
+
+    // 64 bits divisions are done in software, only use them until the value fits in 32 bits
+    while(Value > UINT32_MAX)
+    {
+        pPair  = &STR_DecPairs[(Value % 100) * 2];
+        Value /= 100;
+        *--pEnd = pPair[1];
+        *--pEnd = pPair[0];
+    }
+
+    Value32 = (uint32_t)Value;
+    while(Value32 >= 100)
+    {
+        pPair    = &STR_DecPairs[(Value32 % 100) * 2];
+        Value32 /= 100;
+        *--pEnd  = pPair[1];
+        *--pEnd  = pPair[0];
+    }
+
+    if(Value32 >= 10)
+    {
+        pPair   = &STR_DecPairs[Value32 * 2];
+        *--pEnd = pPair[1];
+        *--pEnd = pPair[0];
+    }
+    else
+    {
+        *--pEnd = (char)('0' + Value32);
+    }
+
+    return pEnd;
+}
+
+
 /**
   *--------------------------------------------------------------------------------------------------------------------
   *
   * @brief  Service function to print string for printf and sprintf
   *
-  * @param  pOut            Pointer on output string
+  * @param  Sink            Output callback
+  * @param  pCtx            Output callback context
   * @param  pString         String to print
   * @param  Width           Width in the print string
+  * @param  Precision       Maximum number of character of pString printed, STR_NO_PRECISION for all
   * @param  Option          Padding, Space or 0
   *
   * @retval size_t          Size of string
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static size_t STR_prints(char* pOut, char* pString, size_t Width, uint8_t Option)
+static size_t STR_prints(STR_Sink_t Sink, void* pCtx, const char* pString, size_t Width, int Precision, uint8_t Option)
 {
     size_t  Counter;
     size_t  Len;
@@ -67,10 +210,18 @@ static size_t STR_prints(char* pOut, char* pString, size_t Width, uint8_t Option
     Counter = 0;
     PadChar = ' ';
 
-    if(Width > 0)                                           // If different than '0' -> there is padding
+    if(Precision == STR_NO_PRECISION)
     {
         Len = strlen(pString);
+    }
+    else
+    {
+        // The string may not be null terminated within the precision
+        for(Len = 0; (Len < (size_t)Precision) && (pString[Len] != '\0'); Len++);
+    }
 
+    if(Width > 0)                                           // If different than '0' -> there is padding
+    {
         // Check if length of the string is bigger or equal than the width of padding
         if(Len >= Width)               Width   = 0;         // No padding necessary, the number is bigger than the padding space
         else                           Width  -= Len;       // Remove unnecessary padding because of the length of the number
@@ -78,21 +229,15 @@ static size_t STR_prints(char* pOut, char* pString, size_t Width, uint8_t Option
 
         if(Option & STR_OPT_PAD_LEFT)
         {
-            for(; Width > 0; Width--)
-            {
-            	STR_putchar(&pOut[Counter], PadChar);
-                Counter++;
-            }
+            Counter += STR_pad(Sink, pCtx, PadChar, Width);
+            Width = 0;
         }
     }
 
-    Counter += STR_str2str(&pOut[Counter], pString);        // Print character until EOL
+    Sink(pCtx, pString, Len);                               // Whole string in one go
+    Counter += Len;
 
-    for(; Width > 0; Width--)                               // Print padding character if any
-    {
-    	STR_putchar(&pOut[Counter], PadChar);
-        Counter++;
-    }
+    Counter += STR_pad(Sink, pCtx, ' ', Width);             // Left justified, trailing space if any
 
     return Counter;
 }
@@ -101,97 +246,121 @@ static size_t STR_prints(char* pOut, char* pString, size_t Width, uint8_t Option
 /**
   *--------------------------------------------------------------------------------------------------------------------
   *
-  * @brief  Service function to print string for printf and sprintf
+  * @brief  Service function to print integer for printf and sprintf
   *
-  * @param  pOut            Pointer on output string
-  * @param  Value           Value to print
+  *         The field is laid out as: [space padding] [sign or 0x] [zero padding] [digits] [space padding]
+  *
+  * @param  Sink            Output callback
+  * @param  pCtx            Output callback context
+  * @param  Value           Magnitude of the value to print
+  * @param  Negative        Print a '-' in front of the value
   * @param  Width           Width in the print string
-  * @param  Option          Padding, Space or 0
+  * @param  Precision       Minimum number of digits, STR_NO_PRECISION when not specified
+  * @param  Option          Padding, Space or 0, sign and base
   *
-  * @retval uint8_t         Number of character printed
+  * @retval size_t          Number of character printed
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-static size_t STR_printi(char* pOut, int64_t Value, size_t Width, uint8_t Option)
+static size_t STR_printi(STR_Sink_t Sink, void* pCtx, uint64_t Value, bool Negative, size_t Width, int Precision, uint8_t Option)
 {
-    size_t      Counter;
-    uint64_t    _Value;
     char        PrintBuffer[STR_MAX_PRINT_VALUE];
+    char        Prefix[2];
+    char*       pEnd;
     char*       pString;
-    bool        Negative;
-    char        Temp;
-  #ifdef STR_USE_HEX_SUPPORT
-    uint8_t     LetterBase;
-    uint8_t     Base;
-  #endif
+    size_t      Len;
+    size_t      PrefixLen;
+    size_t      Zeros;
+    size_t      Total;
+    size_t      Counter;
 
-    Counter    = 0;
-    Negative   = false;
-    _Value     = Value;
+    pEnd    = PrintBuffer + STR_MAX_PRINT_VALUE;
+    pString = STR_utoa(pEnd, Value, Option);
+    Len     = pEnd - pString;
 
-  #ifdef STR_USE_HEX_SUPPORT
-    LetterBase = 'A' + (Option & STR_OPT_LOWERCASE);
-    Base       = (Option & STR_OPT_BASE_HEXA) ? 16 : 10;
-  #endif
-
-    if(Value == 0)
+    // A zero with a precision of 0 prints no digit
+    if((Value == 0) && (Precision == 0))
     {
-        PrintBuffer[0] = '0';
-        PrintBuffer[1] = '\0';
-        return STR_prints(pOut, PrintBuffer, Width, Option);
+        Len = 0;
     }
 
+    PrefixLen = 0;
+    if(Negative)                            Prefix[PrefixLen++] = '-';
+    else if(Option & STR_OPT_SIGN_PLUS)     Prefix[PrefixLen++] = '+';
+    else if(Option & STR_OPT_SIGN_SPACE)    Prefix[PrefixLen++] = ' ';
+
   #ifdef STR_USE_HEX_SUPPORT
-    if((Option & STR_OPT_SIGN_NEGATIVE) && (Base == 10) && (Value < 0))
-  #else
-    if((Option & STR_OPT_SIGN_NEGATIVE) && (Value < 0))
-  #endif
+    if((Option & STR_OPT_ALTERNATE) && (Option & STR_OPT_BASE_HEXA) && (Value != 0))
     {
-        Negative = true;
-        _Value   = -Value;
+        Prefix[0] = '0';
+        Prefix[1] = (Option & STR_OPT_LOWERCASE) ? 'x' : 'X';
+        PrefixLen = 2;
     }
+  #endif
 
-    pString = PrintBuffer + (STR_MAX_PRINT_VALUE - 1);
-    *pString = '\0';
-
-    while(_Value)
+    Zeros = 0;
+    if(Precision != STR_NO_PRECISION)
     {
-      #ifdef STR_USE_HEX_SUPPORT
-
-        Temp = _Value % Base;
-
-        if(Temp >= 10)
+        if((size_t)Precision > Len)
         {
-            Temp += (LetterBase -'0' - 10);
+            Zeros = Precision - Len;
         }
+    }
+    else if(((Option & (STR_OPT_PAD_ZERO | STR_OPT_PAD_LEFT)) == (STR_OPT_PAD_ZERO | STR_OPT_PAD_LEFT)) &&
+            (Width > (PrefixLen + Len)))
+    {
+        Zeros = Width - PrefixLen - Len;
+    }
 
-        *--pString = Temp + '0';
-        _Value = _Value / Base;
-
-      #else
+    Total   = PrefixLen + Zeros + Len;
+    Width   = (Width > Total) ? (Width - Total) : 0;
+    Counter = Total + Width;
 
-        Temp = _Value % 10;
-        *--pString = Temp + '0';
-        _Value = _Value / 10;
+    if(Option & STR_OPT_PAD_LEFT)
+    {
+        STR_pad(Sink, pCtx, ' ', Width);
+        Width = 0;
+    }
 
-      #endif
+    if(PrefixLen != 0)
+    {
+        Sink(pCtx, Prefix, PrefixLen);
     }
+    STR_pad(Sink, pCtx, '0', Zeros);
+    Sink(pCtx, pString, Len);
+    STR_pad(Sink, pCtx, ' ', Width);
 
-    if(Negative == true)
+    return Counter;
+}
+
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  *
+  * @brief  Sink of STR_vsnprintf, copies in the buffer and drops what does not fit
+  *
+  * @param  pCtx            STR_BuffSink_t
+  * @param  pData           Characters to output
+  * @param  Len             Number of characters
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void STR_BuffSink(void* pCtx, const char* pData, size_t Len)
+{
+    STR_BuffSink_t* pBuff = (STR_BuffSink_t*)pCtx;
+    size_t          Room;
+
+    // Keep room for the null char
+    Room = pBuff->Size - 1 - pBuff->Count;
+    if(Len > Room)
     {
-        if((Width != 0) && (Option & STR_OPT_PAD_ZERO))
-        {
-            STR_putchar(pOut, '-');
-            Counter++;
-            Width--;
-        }
-        else
-        {
-            *--pString = '-';
-        }
+        Len = Room;
     }
 
-    return Counter + STR_prints(pOut, pString, Width, Option);
+    memcpy(&pBuff->pOut[pBuff->Count], pData, Len);
+    pBuff->Count += Len;
 }
 
 
@@ -203,49 +372,85 @@ static size_t STR_printi(char* pOut, int64_t Value, size_t Width, uint8_t Option
   * @brief  Print a formatted text in a buffer from ...
   *
   * @param  pOut            Pointer on output string
-  * @param  Size            Maximum character to print
+  * @param  Size            Size of the output buffer, null char included
   * @param  pFormat         Formatted string
   * @param  ...             variable list of argument
   *
-  * @note           Will support the following Parameter
+  * @note   See STR_vcbprintf for the supported format
   *
-  *                  %s               Print a string
-  *                  %0               pad with zero
-  *                  %1 to %255       number of padding space
-  *                  %01 to %0255     number of padding 0
-  *                  %c               special character
-  *                  %l               for long support                  ( valid only for d,u,x,X )
-  *                  %ll              for longlong (64 Bits) support    ( valid only for d,u,x,X )
-  *                  %u               unsigned integer
-  *                  %d               integer
-  *                  %x               hexadecimal in lower case
-  *                  %X               hexadecimal in upper case
+  * @retval size_t          Number of character written in pOut
   *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+size_t STR_snprintf(char* pOut, size_t Size, const char* pFormat, ...)
+{
+    va_list vaArg;
+
+    va_start(vaArg, (const char*)pFormat);
+    Size = STR_vsnprintf(pOut, Size, pFormat, vaArg);
+    va_end(vaArg);
+
+    return Size;
+}
+
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
   *
-  *                   note: this is the order in which they must be use
+  * @brief  Print a formatted text in a buffer from a va list of argument
   *
-  *                   ex.  %05lX   pad with ZERO +
-  *                                5 padding character +
-  *                                it will be a long +
-  *                                it's a HEX printed in uppercase
+  * @param  pOut            Pointer on output string
+  * @param  Size            Size of the output buffer, null char included
+  * @param  pFormat         Formatted string
+  * @param  va              list of argument
   *
-  *                   ex. %6ld     normal padding ( no Parameter ) +
-  *                                padding with space ( no Parameter ) +
-  *                                6  padding space on the left +
-  *                                it will be a long +
-  *                                it is a decimal value
+  * @note   See STR_vcbprintf for the supported format, the output is cut to fit the buffer
   *
+  * @retval size_t          Number of character written in pOut
   *
-  * @retval uint8_t         Number of character printed
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+size_t STR_vsnprintf(char* pOut, size_t Size, const char* pFormat, va_list va)
+{
+    STR_BuffSink_t  Buff;
+
+    if(Size == 0)
+    {
+        return 0;
+    }
+
+    Buff.pOut  = pOut;
+    Buff.Size  = Size;
+    Buff.Count = 0;
+
+    STR_vcbprintf(STR_BuffSink, &Buff, pFormat, va);
+    pOut[Buff.Count] = '\0';
+
+    return Buff.Count;
+}
+
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  *
+  * @brief  Print a formatted text through a sink callback from ...
+  *
+  * @param  Sink            Output callback
+  * @param  pCtx            Passed as is to the callback
+  * @param  pFormat         Formatted string
+  * @param  ...             variable list of argument
+  *
+  * @retval size_t          Number of character sent to the sink
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-size_t STR_snprintf(char* pOut, size_t Size, const char* pFormat, ...)
+size_t STR_cbprintf(STR_Sink_t Sink, void* pCtx, const char* pFormat, ...)
 {
     va_list vaArg;
+    size_t  Size;
 
     va_start(vaArg, (const char*)pFormat);
-    Size = STR_vsnprintf(pOut, Size, pFormat, vaArg);
+    Size = STR_vcbprintf(Sink, pCtx, pFormat, vaArg);
     va_end(vaArg);
 
     return Size;
@@ -255,156 +460,361 @@ size_t STR_snprintf(char* pOut, size_t Size, const char* pFormat, ...)
 /**
   *--------------------------------------------------------------------------------------------------------------------
   *
-  * @brief  Print a formatted text in a buffer from a va list of argument
+  * @brief  Print a formatted text through a sink callback from a va list of argument
   *
-  * @param  pOut            Pointer on output string
-   * @param  Size            Maximum character to print
+  *         Nothing is buffered: literal text goes to the sink in runs, each field as soon as it is converted, so the
+  *         output length is not limited.
+  *
+  * @param  Sink            Output callback
+  * @param  pCtx            Passed as is to the callback
   * @param  pFormat         Formatted string
   * @param  va              list of argument
   *
-  * @note           Will support the following Parameter
+  * @note           Follow the C standard for the following subset
+  *
+  *                  %[flags][width][.precision][length]conversion
+  *
+  *                  flags           -               left justify
+  *                                  0               pad with zero
+  *                                  +               print the sign of positive value
+  *                                  space           print a space in front of positive value
+  *                                  #               0x or 0X in front of non zero hexadecimal
   *
-  *                  %%               Print symbol %
-  *                  %s               Print a string
-  *                  %0               pad with zero
-  *                  %1 to %255       number of padding space
-  *                  %01 to %0255     number of padding 0
-  *                  %c               special character
-  *                  %l               for long     (32 Bits) support        ( valid only for d,u,x,X )  Ex. %llu
-  *                  %ll              for longlong (64 Bits) support        ( valid only for d,u,x,X )
-  *                  %u               unsigned integer
-  *                  %d               integer
-  *                  %x               hexadecimal in lower case
-  *                  %X               hexadecimal in upper case
+  *                  width           1 to n          minimum field width
+  *                                  *               width from an int argument, negative is left justified
   *
+  *                  precision       .1 to .n        minimum number of digits, or maximum length of a string
+  *                                  .*              precision from an int argument, negative is ignored
   *
-  *                   note: this is the order in which they must be use
+  *                  length          hh h            char, short
+  *                                  l ll            long, long long
+  *                                  z               size_t
+  *
+  *                  conversion      %               Print symbol %
+  *                                  s               Print a string
+  *                                  c               Print a character
+  *                                  d i             integer
+  *                                  u               unsigned integer
+  *                                  x               hexadecimal in lower case
+  *                                  X               hexadecimal in upper case
+  *                                  p               pointer, as 0x followed by lower case hexadecimal
   *
   *                   ex.  %05lX   pad with ZERO +
   *                                5 padding character +
   *                                it will be a long +
   *                                it's a HEX printed in uppercase
   *
-  *                   ex. %6ld     normal padding ( no Parameter ) +
-  *                                padding with space ( no Parameter ) +
-  *                                6  padding space on the left +
-  *                                it will be a long +
+  *                   ex. %-*.3d   left justified +
+  *                                width from the argument list +
+  *                                at least 3 digits +
   *                                it is a decimal value
   *
+  *                   floating point is not supported.
   *
-  * @retval uint8_t         Number of character printed
+  * @retval size_t          Number of character sent to the sink
   *
   *--------------------------------------------------------------------------------------------------------------------
   */
-size_t STR_vsnprintf(char* pOut, size_t Size, const char* pFormat, va_list va)
+size_t STR_vcbprintf(STR_Sink_t Sink, void* pCtx, const char* pFormat, va_list va)
 {
-    uint32_t            Counter;
+    size_t              Counter;
     size_t              Width;
+    int                 Precision;
+    int                 Arg;
     STR_VarLength_e     SizeVar;
-    int64_t             n;
+    uint64_t            n;
+    int64_t             Signed;
+    bool                Negative;
     uint8_t             Option;
-    char*               s;
+    const char*         pRun;
+    const char*         s;
     char                scr[2];
 
     Counter = 0;
 
-    for(; (*pFormat != '\0') && (Counter < Size); pFormat++)
+    while(*pFormat != '\0')
     {
-        if(*pFormat == '%')
+        if(*pFormat != '%')
         {
-            pFormat++;
-            Width   = 0;
-            Option  = STR_OPT_PAD_LEFT;
-            SizeVar = STR_VAR_16;
-
-            if(*pFormat == 's')
+            // Literal text up to the next field in one call
+            pRun = pFormat;
+            while((*pFormat != '\0') && (*pFormat != '%'))
             {
-                s = va_arg(va, char *);
-                Counter += STR_prints(&pOut[Counter], s ? s : "(null)", Width, Option);
-                continue;
+                pFormat++;
             }
+            Sink(pCtx, pRun, pFormat - pRun);
+            Counter += pFormat - pRun;
+            continue;
+        }
 
-            if(*pFormat == 'c')
-            {
-                scr[0] = (uint8_t)va_arg(va, int);
-                scr[1] = '\0';
-                Counter += STR_prints(&pOut[Counter], scr, Width, Option);
-                continue;
-            }
+        pFormat++;
+        Width     = 0;
+        Precision = STR_NO_PRECISION;
+        Option    = STR_OPT_PAD_LEFT;
+        SizeVar   = STR_VAR_INT;
+        Negative  = false;
 
-            while(*pFormat == '0')
+        // Flags
+        for(;; pFormat++)
+        {
+            if     (*pFormat == '-')  Option &= ~STR_OPT_PAD_LEFT;
+            else if(*pFormat == '0')  Option |= STR_OPT_PAD_ZERO;
+            else if(*pFormat == '+')  Option |= STR_OPT_SIGN_PLUS;
+            else if(*pFormat == ' ')  Option |= STR_OPT_SIGN_SPACE;
+            else if(*pFormat == '#')  Option |= STR_OPT_ALTERNATE;
+            else                      break;
+        }
+
+        // Width
+        if(*pFormat == '*')
+        {
+            pFormat++;
+            Arg = va_arg(va, int);
+            if(Arg < 0)
             {
-                pFormat++;
-                Option |= STR_OPT_PAD_ZERO;
+                Option &= ~STR_OPT_PAD_LEFT;
+                Arg = -Arg;
             }
-
+            Width = (size_t)Arg;
+        }
+        else
+        {
             for(; (*pFormat >= '0') && (*pFormat <= '9'); pFormat++)
             {
                 Width *= 10;
                 Width += *pFormat - '0';
             }
+        }
 
-            if(*pFormat == 'l')
+        // Precision
+        if(*pFormat == '.')
+        {
+            pFormat++;
+            if(*pFormat == '*')
             {
-                SizeVar = STR_VAR_32;
                 pFormat++;
-                if(*pFormat == 'l')
+                Arg = va_arg(va, int);
+                Precision = (Arg < 0) ? STR_NO_PRECISION : Arg;
+            }
+            else
+            {
+                for(Precision = 0; (*pFormat >= '0') && (*pFormat <= '9'); pFormat++)
                 {
-                    SizeVar = STR_VAR_64;
-                    pFormat++;
+                    Precision *= 10;
+                    Precision += *pFormat - '0';
                 }
             }
+        }
+
+        // Length
+        if(*pFormat == 'h')
+        {
+            SizeVar = STR_VAR_SHORT;
+            pFormat++;
+            if(*pFormat == 'h')
+            {
+                SizeVar = STR_VAR_CHAR;
+                pFormat++;
+            }
+        }
+        else if(*pFormat == 'l')
+        {
+            SizeVar = STR_VAR_LONG;
+            pFormat++;
+            if(*pFormat == 'l')
+            {
+                SizeVar = STR_VAR_LONGLONG;
+                pFormat++;
+            }
+        }
+        else if(*pFormat == 'z')
+        {
+            SizeVar = STR_VAR_SIZE;
+            pFormat++;
+        }
+
+        switch(*pFormat)
+        {
+            case '\0':
+            {
+                return Counter;
+            }
+
+            case '%':
+            {
+                Sink(pCtx, pFormat, 1);
+                Counter++;
+                break;
+            }
+
+            case 's':
+            {
+                s = va_arg(va, const char*);
+                Counter += STR_prints(Sink, pCtx, (s != NULL) ? s : "(null)", Width, Precision, Option & ~STR_OPT_PAD_ZERO);
+                break;
+            }
 
-            if(*pFormat == 'd')
+            case 'c':
+            {
+                scr[0] = (char)va_arg(va, int);
+                scr[1] = '\0';
+                Counter += STR_prints(Sink, pCtx, scr, Width, STR_NO_PRECISION, Option & ~STR_OPT_PAD_ZERO);
+                break;
+            }
+
+            case 'd':
+            case 'i':
             {
                 switch(SizeVar)
                 {
-                    case STR_VAR_16: n = (int16_t)va_arg(va, int32_t);    break;
-                    case STR_VAR_32: n = (int32_t)va_arg(va, int32_t);    break;
-                    case STR_VAR_64: n = (int64_t)va_arg(va, int64_t);    break;
+                    case STR_VAR_CHAR:      Signed = (signed char)va_arg(va, int);  break;
+                    case STR_VAR_SHORT:     Signed = (short)va_arg(va, int);        break;
+                    case STR_VAR_LONG:      Signed = va_arg(va, long);              break;
+                    case STR_VAR_LONGLONG:  Signed = va_arg(va, long long);         break;
+                    case STR_VAR_SIZE:      Signed = (int64_t)va_arg(va, size_t);   break;
+                    default:                Signed = va_arg(va, int);               break;
                 }
-                Counter += STR_printi(&pOut[Counter], n, Width, Option | STR_OPT_SIGN_NEGATIVE | STR_OPT_LOWERCASE);
-                continue;
-            }
 
-            switch(SizeVar)
-            {
-                case STR_VAR_16: n = (uint16_t)va_arg(va, uint32_t);    break;
-                case STR_VAR_32: n = (uint32_t)va_arg(va, uint32_t);    break;
-                case STR_VAR_64: n = (uint64_t)va_arg(va, uint64_t);    break;
+                if(Signed < 0)
+                {
+                    Negative = true;
+                    n = 0 - (uint64_t)Signed;
+                }
+                else
+                {
+                    n = (uint64_t)Signed;
+                }
+                Counter += STR_printi(Sink, pCtx, n, Negative, Width, Precision, Option);
+                break;
             }
 
+            case 'u':
           #ifdef STR_USE_HEX_SUPPORT
-            if(*pFormat == 'x')
+            case 'x':
+            case 'X':
+          #endif
             {
-                Counter += STR_printi(&pOut[Counter], n, Width, Option | STR_OPT_BASE_HEXA | STR_OPT_LOWERCASE);
-                continue;
+                switch(SizeVar)
+                {
+                    case STR_VAR_CHAR:      n = (unsigned char)va_arg(va, unsigned int);    break;
+                    case STR_VAR_SHORT:     n = (unsigned short)va_arg(va, unsigned int);   break;
+                    case STR_VAR_LONG:      n = va_arg(va, unsigned long);                  break;
+                    case STR_VAR_LONGLONG:  n = va_arg(va, unsigned long long);             break;
+                    case STR_VAR_SIZE:      n = va_arg(va, size_t);                         break;
+                    default:                n = va_arg(va, unsigned int);                   break;
+                }
+
+                // Sign flags only apply to signed conversion
+                Option &= ~(STR_OPT_SIGN_PLUS | STR_OPT_SIGN_SPACE);
+                if(*pFormat == 'x')  Option |= STR_OPT_BASE_HEXA | STR_OPT_LOWERCASE;
+                if(*pFormat == 'X')  Option |= STR_OPT_BASE_HEXA;
+                if(*pFormat == 'u')  Option &= ~STR_OPT_ALTERNATE;
+                Counter += STR_printi(Sink, pCtx, n, false, Width, Precision, Option);
+                break;
             }
 
-            if(*pFormat == 'X')
+          #ifdef STR_USE_HEX_SUPPORT
+            case 'p':
             {
-                Counter += STR_printi(&pOut[Counter], n, Width, Option | STR_OPT_BASE_HEXA);
-                continue;
+                n = (uintptr_t)va_arg(va, void*);
+                Option &= ~(STR_OPT_SIGN_PLUS | STR_OPT_SIGN_SPACE);
+                Option |= STR_OPT_BASE_HEXA | STR_OPT_LOWERCASE | STR_OPT_ALTERNATE;
+                Counter += STR_printi(Sink, pCtx, n, false, Width, Precision, Option);
+                break;
             }
           #endif
 
-            if(*pFormat == 'u')
+            default:
             {
-                Counter += STR_printi(&pOut[Counter], n, Width, Option | STR_OPT_LOWERCASE);
-                continue;
+                // Unknown conversion, skipped
+                break;
             }
         }
-        else
+
+        pFormat++;
+    }
+
+    return Counter;
+}
+
+
+#ifdef STR_USE_HEX_SUPPORT
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  *
+  * @brief  Dump a buffer as offset, hexadecimal and ASCII lines through a sink callback
+  *
+  *         ex. 0010: 48 65 6C 6C 6F 00 FF 7E 41 42 43 44 45 46 47 48  |Hello..~ABCDEFGH|
+  *
+  *         Each line is built with the nibble table and sent to the sink in one call.
+  *
+  * @param  Sink            Output callback
+  * @param  pCtx            Passed as is to the callback
+  * @param  Offset          Offset printed for the first byte
+  * @param  pData           Data to dump
+  * @param  Len             Number of bytes
+  *
+  * @retval size_t          Number of character sent to the sink
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+size_t STR_HexDump(STR_Sink_t Sink, void* pCtx, uint32_t Offset, const uint8_t* pData, size_t Len)
+{
+    char        Line[STR_DUMP_LINE_MAX];
+    char*       pHex;
+    char*       pAscii;
+    size_t      Counter;
+    size_t      Count;
+    size_t      i;
+    int         Digits;
+    int         Shift;
+    uint8_t     Value;
+
+    Counter = 0;
+
+    // Offsets above 64 KB need 8 digits, the whole dump uses the same width
+    Digits = ((Offset + Len) > 0x10000) ? 8 : 4;
+
+    while(Len > 0)
+    {
+        Count = (Len < STR_DUMP_BYTES_PER_LINE) ? Len : STR_DUMP_BYTES_PER_LINE;
+
+        pHex = Line;
+        for(Shift = (Digits - 1) * 4; Shift >= 0; Shift -= 4)
         {
-        	STR_putchar(&pOut[Counter], *pFormat);
-            Counter++;
+            *pHex++ = STR_HexUpper[(Offset >> Shift) & 0x0F];
         }
-    }
+        *pHex++ = ':';
 
-    STR_putchar(&pOut[Counter], '\0');
+        // Short last line keeps the ASCII column aligned
+        memset(pHex, ' ', (STR_DUMP_BYTES_PER_LINE * 3) + 2);
+        pAscii  = pHex + (STR_DUMP_BYTES_PER_LINE * 3) + 2;
+        *pAscii++ = '|';
+
+        for(i = 0; i < Count; i++)
+        {
+            Value     = pData[i];
+            pHex[1]   = STR_HexUpper[Value >> 4];
+            pHex[2]   = STR_HexUpper[Value & 0x0F];
+            pHex     += 3;
+            *pAscii++ = ((Value >= 0x20) && (Value < 0x7F)) ? (char)Value : '.';
+        }
+
+        *pAscii++ = '|';
+        *pAscii++ = '\r';
+        *pAscii++ = '\n';
+
+        Sink(pCtx, Line, pAscii - Line);
+        Counter += pAscii - Line;
+
+        pData  += Count;
+        Offset += Count;
+        Len    -= Count;
+    }
 
     return Counter;
 }
+#endif
 
 
 /**
@@ -0,0 +1,180 @@
+/**********************************************************************************************************************
+ * @file    timestamp.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Host correlated time base built on the USB start of frame
+ *
+ *          The host sends a SOF every millisecond with an 11 bits frame number. Extending that number to 32 bits
+ *          gives a 1 kHz counter whose low 11 bits match the host controller frame number, so device events can
+ *          be lined up with host side logs without any extra request. SysTick gives the position inside the
+ *          frame. Without SOF (suspended, unplugged), the counter keeps running on the HAL tick.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include "timestamp.h"
+#include "nOS.h"
+#include "stm32f0xx_hal.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define TS_SYNC_TIMEOUT     3   // ms without SOF before the host time base is considered lost
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+volatile uint32_t   TS_Frames;      // Extended frame number of the last SOF
+volatile uint16_t   TS_LastFrame;   // Raw frame number of the last SOF
+volatile uint32_t   TS_SofHalTick;  // HAL tick at the last SOF
+volatile uint32_t   TS_SofSysTick;  // SysTick value at the last SOF
+volatile bool       TS_Started;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+// HAL tick and SysTick value sampled together, called in a critical section
+static void TS_ReadClock(uint32_t *pTick, uint32_t *pSysTick)
+{
+    *pSysTick = SysTick->VAL;
+    *pTick = HAL_GetTick();
+
+    // SysTick reloaded but its interrupt is held off, the HAL tick is one behind
+    if(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        *pSysTick = SysTick->VAL;
+        *pTick += 1;
+    }
+}
+
+// Frames and cycles elapsed in the current frame, called in a critical section
+static uint32_t TS_Now(uint32_t *pCycles)
+{
+    uint32_t tick;
+    uint32_t sysTick;
+    uint32_t elapsed;
+
+    TS_ReadClock(&tick, &sysTick);
+    elapsed = tick - TS_SofHalTick;
+
+    // SysTick counts down and reloads every HAL tick
+    if(sysTick <= TS_SofSysTick)
+    {
+        *pCycles = TS_SofSysTick - sysTick;
+    }
+    else if(elapsed > 0)
+    {
+        elapsed--;
+        *pCycles = SysTick->LOAD + 1 + TS_SofSysTick - sysTick;
+    }
+    else
+    {
+        *pCycles = 0;
+    }
+
+    return TS_Frames + elapsed;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Start of frame from the USB interrupt
+  *
+  * @param  FrameNumber     Frame number of the SOF, USB FNR register
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void TS_SofTick(uint16_t FrameNumber)
+{
+    nOS_StatusReg sr;
+    uint32_t tick;
+    uint32_t sysTick;
+
+    FrameNumber &= TS_FRAME_MASK;
+    nOS_EnterCritical(sr);
+    TS_ReadClock(&tick, &sysTick);
+
+    if(!TS_Started)
+    {
+        TS_Frames = FrameNumber;
+        TS_Started = true;
+    }
+    else if((tick - TS_SofHalTick) > TS_SYNC_TIMEOUT)
+    {
+        // Back from a gap, keep the counter monotonic while realigning the low bits on the host frame number
+        TS_Frames += tick - TS_SofHalTick;
+        TS_Frames += (uint16_t)(FrameNumber - TS_Frames) & TS_FRAME_MASK;
+    }
+    else
+    {
+        TS_Frames += (uint16_t)(FrameNumber - TS_LastFrame) & TS_FRAME_MASK;
+    }
+
+    TS_LastFrame = FrameNumber;
+    TS_SofHalTick = tick;
+    TS_SofSysTick = sysTick;
+    nOS_LeaveCritical(sr);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Current time in USB frames (ms), the low 11 bits are the host frame number while synced
+  *
+  * @retval uint32_t        Timestamp in ms
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint32_t TS_Get(void)
+{
+    nOS_StatusReg sr;
+    uint32_t frames;
+    uint32_t cycles;
+
+    nOS_EnterCritical(sr);
+    frames = TS_Now(&cycles);
+    nOS_LeaveCritical(sr);
+
+    return frames;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Current time in us, frame based with the position inside the frame taken from SysTick
+  *
+  * @retval uint64_t        Timestamp in us
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint64_t TS_GetUs(void)
+{
+    nOS_StatusReg sr;
+    uint32_t frames;
+    uint32_t cycles;
+
+    nOS_EnterCritical(sr);
+    frames = TS_Now(&cycles);
+    nOS_LeaveCritical(sr);
+
+    return ((uint64_t)frames * 1000) + (cycles / (SystemCoreClock / 1000000));
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Whether the time base currently follows the host SOF
+  *
+  * @retval bool            false before enumeration or while suspended
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool TS_IsSynced(void)
+{
+    return TS_Started && ((HAL_GetTick() - TS_SofHalTick) <= TS_SYNC_TIMEOUT);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -54,8 +54,11 @@
 #include "usbd_desc.h"
 #include "usbd_cdc.h"
 #include "usbd_cdc_if.h"
+#include "usbd_composite.h"
 
 /* USER CODE BEGIN Includes */
+#include "usb_stream.h"
+#include "usb_disk.h"
 
 /* USER CODE END Includes */
 
@@ -93,16 +96,21 @@ USBD_HandleTypeDef hUsbDeviceFS;
 void MX_USB_DEVICE_Init(void)
 {
   /* USER CODE BEGIN USB_DEVICE_Init_PreTreatment */
-  
+  STREAM_Init();
+  USBDISK_Init();
   /* USER CODE END USB_DEVICE_Init_PreTreatment */
   
   /* Init Device Library, add supported class and start the library. */
   USBD_Init(&hUsbDeviceFS, &FS_Desc, DEVICE_FS);
 
-  USBD_RegisterClass(&hUsbDeviceFS, &USBD_CDC);
+  USBD_RegisterClass(&hUsbDeviceFS, &USBD_COMPOSITE);
 
   USBD_CDC_RegisterInterface(&hUsbDeviceFS, &USBD_Interface_fops_FS);
 
+  USBD_VND_RegisterInterface(&hUsbDeviceFS, &STREAM_fops);
+
+  USBD_MSC_RegisterStorage(&hUsbDeviceFS, &USBDISK_fops);
+
   USBD_Start(&hUsbDeviceFS);
 
   /* USER CODE BEGIN USB_DEVICE_Init_PostTreatment */
@@ -0,0 +1,297 @@
+/**********************************************************************************************************************
+ * @file    usb_disk.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Capture volume exposed on the USB mass storage interface
+ *
+ *          Glue between the mass storage class and the flash block device. The class calls in from the USB
+ *          interrupt, so whatever erases or programs the flash is posted to the disk task instead: the call reports
+ *          busy and the class holds the transfer back until the task is done. The CPU still stalls on the flash
+ *          while a page is erased, but the USB interrupt no longer holds every other interrupt off for a whole
+ *          page program. While the firmware owns the volume the host sees an empty drive, and it is told the medium
+ *          changed every time the volume comes back to it.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include "usb_disk.h"
+#include "nOS.h"
+#include "defines.h"
+#include "disk.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+// Work posted to the disk task
+#define USBDISK_JOB_SYNC        0x01    // Program the cached page back
+#define USBDISK_JOB_EJECT       0x02    // Flush and give the volume up
+#define USBDISK_JOB_DETACH      0x04    // Same once the interface is gone, unless the host came back
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static int8_t           USBDISK_Attach          (uint8_t Attached);
+static int8_t           USBDISK_IsReady         (void);
+static int8_t           USBDISK_IsWriteProtected(void);
+static int8_t           USBDISK_GetCapacity     (uint32_t *pBlockNum, uint16_t *pBlockSize);
+static const uint8_t   *USBDISK_MapRead         (uint32_t Block);
+static int8_t           USBDISK_MapWrite        (uint32_t Block, uint8_t **ppBlock);
+static int8_t           USBDISK_Sync            (void);
+static int8_t           USBDISK_Eject           (void);
+static void             USBDISK_Post            (uint8_t Job);
+static int8_t           USBDISK_Pending         (void);
+static void             USBDISK_Task            (void *arg);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+// Standard INQUIRY data: direct access, removable
+static const uint8_t USBDISK_Inquiry[MSC_REPLY_SIZE] =
+{
+    0x00, 0x80, 0x02, 0x02, (MSC_REPLY_SIZE - 5), 0x00, 0x00, 0x00,
+    'S', 'T', 'M', ' ', ' ', ' ', ' ', ' ',
+    'P', 'r', 'o', 't', 'o', 'c', 'o', 'l', 'G', 'u', 'y', ' ', 'L', 'o', 'g', 's',
+    '1', '.', '0', '0',
+};
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+static uint32_t         USBDISK_Generation;
+static volatile uint8_t USBDISK_Jobs;
+static volatile bool    USBDISK_Failed;
+
+static nOS_Sem          USBDISK_Wake;
+static nOS_Thread       USBDISK_Thread;
+static nOS_Stack        USBDISK_Stack[USBDISK_STACK_SIZE];
+
+USBD_MSC_StorageTypeDef USBDISK_fops =
+{
+    USBDISK_Attach,
+    USBDISK_IsReady,
+    USBDISK_IsWriteProtected,
+    USBDISK_GetCapacity,
+    USBDISK_MapRead,
+    USBDISK_MapWrite,
+    USBDISK_Sync,
+    USBDISK_Eject,
+    USBDISK_Inquiry,
+};
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+// Interface configured or gone, the host takes the volume only if the firmware is not using it
+static int8_t USBDISK_Attach(uint8_t Attached)
+{
+    DISK_HostAttach(Attached != 0);
+    USBDISK_Generation = DISK_GetGeneration();
+
+    if(!Attached)
+    {
+        USBDISK_Post(USBDISK_JOB_DETACH);
+    }
+
+    return USBD_OK;
+}
+
+static int8_t USBDISK_IsReady(void)
+{
+    if(DISK_GetOwner() != DISK_OWNER_HOST)
+    {
+        return USBD_MSC_MEDIUM_ABSENT;
+    }
+
+    // Reported once, the host rereads the volume after a medium change
+    if(USBDISK_Generation != DISK_GetGeneration())
+    {
+        USBDISK_Generation = DISK_GetGeneration();
+        return USBD_MSC_MEDIUM_CHANGED;
+    }
+
+    return USBD_MSC_MEDIUM_READY;
+}
+
+static int8_t USBDISK_IsWriteProtected(void)
+{
+    return 0;
+}
+
+static int8_t USBDISK_GetCapacity(uint32_t *pBlockNum, uint16_t *pBlockSize)
+{
+    *pBlockNum  = DISK_SECTOR_COUNT;
+    *pBlockSize = DISK_SECTOR_SIZE;
+    return USBD_OK;
+}
+
+static const uint8_t *USBDISK_MapRead(uint32_t Block)
+{
+    if(DISK_GetOwner() != DISK_OWNER_HOST)
+    {
+        return NULL;
+    }
+
+    return DISK_MapRead(Block);
+}
+
+// A sector of another page first needs the cached one programmed, that is left to the task
+static int8_t USBDISK_MapWrite(uint32_t Block, uint8_t **ppBlock)
+{
+    int8_t  Status;
+
+    if(DISK_GetOwner() != DISK_OWNER_HOST)
+    {
+        return USBD_FAIL;
+    }
+
+    Status = USBDISK_Pending();
+    if(Status != USBD_OK)
+    {
+        return Status;
+    }
+
+    if(DISK_NeedsFlush(Block))
+    {
+        USBDISK_Post(USBDISK_JOB_SYNC);
+        return USBD_BUSY;
+    }
+
+    *ppBlock = DISK_MapWrite(Block);
+    return (*ppBlock != NULL) ? USBD_OK : USBD_FAIL;
+}
+
+static int8_t USBDISK_Sync(void)
+{
+    int8_t  Status;
+
+    if(DISK_GetOwner() != DISK_OWNER_HOST)
+    {
+        return USBD_OK;
+    }
+
+    Status = USBDISK_Pending();
+    if((Status == USBD_OK) && DISK_IsDirty())
+    {
+        USBDISK_Post(USBDISK_JOB_SYNC);
+        Status = USBD_BUSY;
+    }
+
+    return Status;
+}
+
+// Eject from the host file manager, the firmware may mount the volume from now on
+static int8_t USBDISK_Eject(void)
+{
+    int8_t  Status;
+
+    Status = USBDISK_Pending();
+    if((Status == USBD_OK) && (DISK_GetOwner() == DISK_OWNER_HOST))
+    {
+        USBDISK_Post(USBDISK_JOB_EJECT);
+        Status = USBD_BUSY;
+    }
+
+    return Status;
+}
+
+// From the USB interrupt
+static void USBDISK_Post(uint8_t Job)
+{
+    nOS_StatusReg   sr;
+
+    nOS_EnterCritical(sr);
+    USBDISK_Jobs |= Job;
+    nOS_LeaveCritical(sr);
+
+    nOS_SemGive(&USBDISK_Wake);
+}
+
+// USBD_BUSY until the task is done with the posted jobs, then USBD_FAIL once if the flash failed
+static int8_t USBDISK_Pending(void)
+{
+    if(USBDISK_Jobs != 0)
+    {
+        return USBD_BUSY;
+    }
+
+    if(USBDISK_Failed)
+    {
+        USBDISK_Failed = false;
+        return USBD_FAIL;
+    }
+
+    return USBD_OK;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Erase and program the flash on behalf of the host, the USB interrupt keeps polling until the jobs clear
+  *
+  * @param  arg             Unused
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void USBDISK_Task(void *arg)
+{
+    nOS_StatusReg   sr;
+    uint8_t         Jobs;
+    bool            Success;
+
+    (void)arg;
+
+    while(1)
+    {
+        nOS_SemTake(&USBDISK_Wake, NOS_WAIT_INFINITE);
+
+        nOS_EnterCritical(sr);
+        Jobs = USBDISK_Jobs;
+        nOS_LeaveCritical(sr);
+
+        Success = true;
+        if(((Jobs & USBDISK_JOB_SYNC) != 0) && (DISK_GetOwner() == DISK_OWNER_HOST))
+        {
+            Success = DISK_Sync();
+        }
+
+        if((Jobs & USBDISK_JOB_EJECT) != 0)
+        {
+            DISK_Release(DISK_OWNER_HOST);
+        }
+
+        if((Jobs & USBDISK_JOB_DETACH) != 0)
+        {
+            DISK_HostDetach();
+        }
+
+        // The error is latched before the jobs clear, the interrupt sees both at once
+        nOS_EnterCritical(sr);
+        if(!Success)
+        {
+            USBDISK_Failed = true;
+        }
+        USBDISK_Jobs &= (uint8_t)~Jobs;
+        nOS_LeaveCritical(sr);
+    }
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Start the disk task, before the USB device so the host never finds it missing
+  *
+  * @param  none
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void USBDISK_Init(void)
+{
+    USBDISK_Jobs   = 0;
+    USBDISK_Failed = false;
+
+    nOS_SemCreate(&USBDISK_Wake, 0, 1);
+    nOS_ThreadCreate(&USBDISK_Thread, USBDISK_Task, NULL, USBDISK_Stack, USBDISK_STACK_SIZE, 1, "Disk Task");
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
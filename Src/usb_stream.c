@@ -0,0 +1,325 @@
+/**********************************************************************************************************************
+ * @file    usb_stream.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Raw binary streaming over the vendor bulk interface
+ *
+ *          Same ring scheme as the console: writers fill the Tx ring, the IN endpoint drains it from the transfer
+ *          complete interrupt. Nothing else ever goes on this pipe, no echo, no prompt.
+ *
+ *          Configuring the interface is not enough for data to flow, the host reader sends VND_REQ_STREAM with
+ *          wValue 1 once it claimed the interface and 0 before it lets go, nothing is queued while it is closed.
+ *          The Tx ring has no RAM of its own: it borrows the disk page cache while the stream is open, so opening
+ *          fails while the volume has writes not yet in flash.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include "usb_stream.h"
+#include "nOS.h"
+#include "ring.h"
+#include "cli.h"
+#include "usb_device.h"
+#include "disk.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define STREAM_TX_RING_SIZE     DISK_PAGE_SIZE // The lent disk cache, must be a power of 2
+#define STREAM_RX_RING_SIZE     256  // Must be a power of 2
+#define STREAM_PACKET_SIZE      VND_DATA_FS_MAX_PACKET_SIZE
+#define STREAM_XFER_SIZE        (STREAM_PACKET_SIZE * 8)
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static int8_t STREAM_ItfInit        (void);
+static int8_t STREAM_ItfDeInit      (void);
+static int8_t STREAM_ItfReceive     (uint8_t *pBuf, uint32_t *pLen);
+static int8_t STREAM_ItfTransmitCplt(uint8_t *pBuf, uint32_t *pLen, uint8_t epnum);
+static int8_t STREAM_ItfControl     (uint8_t Request, uint16_t Value);
+static void   STREAM_TxKick         (void);
+static void   STREAM_TxReturn       (void);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+RING_t      STREAM_TxRing;
+bool        STREAM_TxBorrowed;
+RING_t      STREAM_RxRing;
+uint8_t     STREAM_RxRing_Buff[STREAM_RX_RING_SIZE];
+volatile bool       STREAM_Open;
+volatile bool       STREAM_TxBusy;
+volatile bool       STREAM_TxZlpPending;
+volatile uint16_t   STREAM_TxInFlight;
+volatile bool       STREAM_RxPaused;
+volatile uint32_t   STREAM_TxBytes;
+volatile uint32_t   STREAM_RxBytes;
+
+USBD_VND_ItfTypeDef STREAM_fops =
+{
+    STREAM_ItfInit,
+    STREAM_ItfDeInit,
+    STREAM_ItfReceive,
+    STREAM_ItfTransmitCplt,
+    STREAM_ItfControl,
+};
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+// Interface configured by the host, restart from an empty ring, the stream stays closed until the reader opens it
+static int8_t STREAM_ItfInit(void)
+{
+    RING_Flush(&STREAM_RxRing);
+    STREAM_TxBusy = false;
+    STREAM_TxZlpPending = false;
+    STREAM_TxInFlight = 0;
+    STREAM_RxPaused = false;
+    STREAM_Open = false;
+    return USBD_OK;
+}
+
+// Endpoints closed, a transfer in progress is gone with them
+static int8_t STREAM_ItfDeInit(void)
+{
+    STREAM_Open = false;
+    STREAM_TxBusy = false;
+    STREAM_TxInFlight = 0;
+    STREAM_TxReturn();
+    return USBD_OK;
+}
+
+// VND_REQ_STREAM from the USB interrupt, leftovers of a previous reader are dropped unless a transfer holds them
+static int8_t STREAM_ItfControl(uint8_t Request, uint16_t Value)
+{
+    uint8_t *pBuff;
+
+    if((Request != VND_REQ_STREAM) || (Value > 1))
+    {
+        return USBD_FAIL;
+    }
+
+    if(Value == 0)
+    {
+        STREAM_Open = false;
+        if(!STREAM_TxBusy)
+        {
+            STREAM_TxReturn();
+        }
+        return USBD_OK;
+    }
+
+    if(!STREAM_TxBorrowed)
+    {
+        pBuff = DISK_LendCache();
+        if(pBuff == NULL)
+        {
+            return USBD_FAIL;
+        }
+        RING_Init(&STREAM_TxRing, pBuff, STREAM_TX_RING_SIZE);
+        STREAM_TxBorrowed = true;
+        STREAM_TxZlpPending = false;
+    }
+    else if(!STREAM_TxBusy)
+    {
+        RING_Flush(&STREAM_TxRing);
+        STREAM_TxZlpPending = false;
+    }
+    STREAM_Open = true;
+
+    STREAM_TxKick();
+    return USBD_OK;
+}
+
+// Rx from the USB interrupt, the endpoint stays NAKed while the ring can't take another packet
+static int8_t STREAM_ItfReceive(uint8_t *pBuf, uint32_t *pLen)
+{
+    STREAM_RxBytes += RING_Write(&STREAM_RxRing, pBuf, (uint16_t)*pLen);
+
+    if(RING_Free(&STREAM_RxRing) < STREAM_PACKET_SIZE)
+    {
+        STREAM_RxPaused = true;
+    }
+    else
+    {
+        USBD_VND_ReceivePacket(&hUsbDeviceFS);
+    }
+    return USBD_OK;
+}
+
+// Tx complete from the USB interrupt
+static int8_t STREAM_ItfTransmitCplt(uint8_t *pBuf, uint32_t *pLen, uint8_t epnum)
+{
+    RING_Skip(&STREAM_TxRing, STREAM_TxInFlight);
+    STREAM_TxBytes += STREAM_TxInFlight;
+
+    // A transfer ending on a full packet needs a ZLP so the host returns the data right away
+    STREAM_TxZlpPending = (STREAM_TxInFlight > 0) && ((STREAM_TxInFlight % STREAM_PACKET_SIZE) == 0) &&
+                          (RING_Count(&STREAM_TxRing) == 0);
+    STREAM_TxInFlight = 0;
+    STREAM_TxBusy = false;
+
+    // The last transfer of a closed stream was holding the cache
+    if(!STREAM_Open)
+    {
+        STREAM_TxReturn();
+    }
+
+    STREAM_TxKick();
+    return USBD_OK;
+}
+
+// Start the next IN transfer from the Tx ring if the endpoint is idle
+static void STREAM_TxKick(void)
+{
+    nOS_StatusReg sr;
+    uint8_t *pData;
+    uint16_t len;
+
+    nOS_EnterCritical(sr);
+    if(STREAM_Open && !STREAM_TxBusy)
+    {
+        len = RING_Peek(&STREAM_TxRing, &pData);
+        if(len > STREAM_XFER_SIZE)
+        {
+            len = STREAM_XFER_SIZE;
+        }
+
+        if((len > 0) || STREAM_TxZlpPending)
+        {
+            if(USBD_VND_TransmitPacket(&hUsbDeviceFS, pData, len) == USBD_OK)
+            {
+                STREAM_TxBusy = true;
+                STREAM_TxInFlight = len;
+                STREAM_TxZlpPending = false;
+            }
+        }
+    }
+    nOS_LeaveCritical(sr);
+}
+
+// Hand the Tx ring back to the disk, never with a transfer in progress
+static void STREAM_TxReturn(void)
+{
+    if(STREAM_TxBorrowed)
+    {
+        STREAM_TxBorrowed = false;
+        DISK_ReturnCache();
+    }
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Prepare the Rx ring, call before the USB device is started. The Tx ring is set up when the stream opens.
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void STREAM_Init(void)
+{
+    RING_Init(&STREAM_RxRing, STREAM_RxRing_Buff, STREAM_RX_RING_SIZE);
+    STREAM_TxBorrowed = false;
+    STREAM_Open = false;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Whether a host reader opened the stream with VND_REQ_STREAM
+  *
+  * @retval bool            true from the open request to the close request or the USB reset
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool STREAM_IsOpen(void)
+{
+    return STREAM_Open;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Queue data for the host, never blocks
+  *
+  * @param  pData           Data to send
+  * @param  Len             Data length
+  *
+  * @retval uint16_t        Number of bytes queued, less than Len when the ring is full or the host is not there
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t STREAM_Write(const uint8_t *pData, uint16_t Len)
+{
+    nOS_StatusReg sr;
+    uint16_t written;
+
+    // Checked with the interrupt masked, the close request flushes the ring
+    nOS_EnterCritical(sr);
+    written = STREAM_Open ? RING_Write(&STREAM_TxRing, pData, Len) : 0;
+    nOS_LeaveCritical(sr);
+
+    STREAM_TxKick();
+
+    return written;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Free room in the Tx ring, lets a producer size its next chunk
+  *
+  * @retval uint16_t        Free bytes, 0 while the stream is closed
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t STREAM_TxFree(void)
+{
+    return STREAM_Open ? RING_Free(&STREAM_TxRing) : 0;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Get data received from the host, single reader only
+  *
+  * @param  pData           Destination
+  * @param  Len             Destination size
+  *
+  * @retval uint16_t        Number of bytes read
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+uint16_t STREAM_Read(uint8_t *pData, uint16_t Len)
+{
+    nOS_StatusReg sr;
+    uint16_t read;
+
+    read = RING_Read(&STREAM_RxRing, pData, Len);
+
+    // Re-arm the OUT endpoint once there is room for a full packet again
+    nOS_EnterCritical(sr);
+    if(STREAM_RxPaused && (RING_Free(&STREAM_RxRing) >= STREAM_PACKET_SIZE))
+    {
+        STREAM_RxPaused = false;
+        USBD_VND_ReceivePacket(&hUsbDeviceFS);
+    }
+    nOS_LeaveCritical(sr);
+
+    return read;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Print the stream counters on the console
+  *
+  * @retval none
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+void STREAM_ShowStats(void)
+{
+    CLI_Printf("\r\nStream : %s, Tx %lu bytes, Rx %lu bytes", STREAM_Open ? "open" : "closed",
+               STREAM_TxBytes, STREAM_RxBytes);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -94,8 +94,7 @@
 /* USER CODE BEGIN PRIVATE_DEFINES */
 /* Define size for the receive and transmit buffer over CDC */
 /* It's up to user to redefine and/or remove those define */
-#define APP_RX_DATA_SIZE  256
-#define APP_TX_DATA_SIZE  256
+#define APP_RX_DATA_SIZE  CDC_DATA_FS_OUT_PACKET_SIZE  /* One packet, the console copies it to its ring right away */
 /* USER CODE END PRIVATE_DEFINES */
 
 /**
@@ -124,8 +123,7 @@
 /** Received data over USB are stored in this buffer      */
 uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
 
-/** Data to send over USB CDC are stored in this buffer   */
-uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
+/** Nothing is sent from a buffer of this file, CDC_Transmit_FS points the class to the console Tx ring */
 
 /* USER CODE BEGIN PRIVATE_VARIABLES */
 
@@ -159,6 +157,7 @@ static int8_t CDC_Init_FS(void);
 static int8_t CDC_DeInit_FS(void);
 static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length);
 static int8_t CDC_Receive_FS(uint8_t* pbuf, uint32_t *Len);
+static int8_t CDC_TransmitCplt_FS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
 
@@ -173,7 +172,8 @@ USBD_CDC_ItfTypeDef USBD_Interface_fops_FS =
   CDC_Init_FS,
   CDC_DeInit_FS,
   CDC_Control_FS,
-  CDC_Receive_FS
+  CDC_Receive_FS,
+  CDC_TransmitCplt_FS
 };
 
 /* Private functions ---------------------------------------------------------*/
@@ -185,8 +185,10 @@ static int8_t CDC_Init_FS(void)
 {
   /* USER CODE BEGIN 3 */
   /* Set Application Buffers */
-  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
+  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, NULL, 0);
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+  // Any transfer in progress was lost with the previous configuration
+  CLI_TxRestart();
   return (USBD_OK);
   /* USER CODE END 3 */
 }
@@ -198,6 +200,8 @@ static int8_t CDC_Init_FS(void)
 static int8_t CDC_DeInit_FS(void)
 {
   /* USER CODE BEGIN 4 */
+  // Unplugged, reset or unconfigured, nobody reads the console anymore
+  CLI_SetHostConnected(false);
   return (USBD_OK);
   /* USER CODE END 4 */
 }
@@ -260,11 +264,12 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
     break;
 
     case CDC_SET_CONTROL_LINE_STATE:
-
+      // No data stage, pbuf is the setup request and wValue bit 0 is DTR
+      CLI_SetHostConnected((((USBD_SetupReqTypedef *)pbuf)->wValue & 0x0001) != 0);
     break;
 
     case CDC_SEND_BREAK:
-
+      CLI_Break();
     break;
 
   default:
@@ -292,11 +297,11 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
-  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
-  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
-  //Echo
-  //CDC_Transmit_FS(Buf, (uint16_t)*Len);
-  CLI_Rx(Buf, (uint16_t)*Len);
+  // Copy the whole packet out first, the endpoint stays NAKed while the console ring is full
+  if (CLI_Rx((char*)Buf, (uint16_t)*Len))
+  {
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  }
   return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -317,6 +322,9 @@ USBD_StatusTypeDef CDC_Transmit_FS(uint8_t* Buf, uint16_t Len)
   USBD_StatusTypeDef result;
   /* USER CODE BEGIN 7 */
   USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+  if (hcdc == NULL){
+    return USBD_FAIL;
+  }
   if (hcdc->TxState != 0){
     return USBD_BUSY;
   }
@@ -326,8 +334,37 @@ USBD_StatusTypeDef CDC_Transmit_FS(uint8_t* Buf, uint16_t Len)
   return result;
 }
 
+/**
+  * @brief  CDC_TransmitCplt_FS
+  *         Called from the USB interrupt once the IN transfer started by
+  *         CDC_Transmit_FS has been fully acknowledged by the host.
+  *
+  * @param  Buf: Buffer of data that was sent
+  * @param  Len: Number of data sent (in bytes)
+  * @param  epnum: IN endpoint number
+  * @retval USBD_OK
+  */
+static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+  /* USER CODE BEGIN 13 */
+  CLI_TxCplt();
+  return (USBD_OK);
+  /* USER CODE END 13 */
+}
+
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
+/**
+  * @brief  CDC_ReceiveResume_FS
+  *         Arm the OUT endpoint again after CDC_Receive_FS left it NAKed
+  *         because the application had no room for another packet.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+USBD_StatusTypeDef CDC_ReceiveResume_FS(void)
+{
+  return USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+}
+
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
 /**
@@ -53,8 +53,10 @@
 #include "usbd_def.h"
 #include "usbd_core.h"
 #include "usbd_cdc.h"
+#include "usbd_composite.h"
 
 /* USER CODE BEGIN Includes */
+#include "timestamp.h"
 
 /* USER CODE END Includes */
 
@@ -72,6 +74,25 @@ void _Error_Handler(char * file, int line);
 
 /* USER CODE BEGIN 0 */
 
+/* PMA layout, the buffer table reserves one 8 bytes descriptor per endpoint number */
+#define USBD_PMA_BTABLE_SIZE    (8U * 8U)
+#define USBD_PMA_EP0_OUT        USBD_PMA_BTABLE_SIZE
+#define USBD_PMA_EP0_IN         (USBD_PMA_EP0_OUT + USB_MAX_EP0_SIZE)
+#define USBD_PMA_CDC_CMD        (USBD_PMA_EP0_IN + USB_MAX_EP0_SIZE)
+#define USBD_PMA_CDC_IN0        (USBD_PMA_CDC_CMD + CDC_CMD_PACKET_SIZE)
+#define USBD_PMA_CDC_IN1        (USBD_PMA_CDC_IN0 + CDC_DATA_FS_MAX_PACKET_SIZE)
+#define USBD_PMA_CDC_OUT        (USBD_PMA_CDC_IN1 + CDC_DATA_FS_MAX_PACKET_SIZE)
+#define USBD_PMA_VND_IN0        (USBD_PMA_CDC_OUT + CDC_DATA_FS_MAX_PACKET_SIZE)
+#define USBD_PMA_VND_IN1        (USBD_PMA_VND_IN0 + VND_DATA_FS_MAX_PACKET_SIZE)
+#define USBD_PMA_VND_OUT        (USBD_PMA_VND_IN1 + VND_DATA_FS_MAX_PACKET_SIZE)
+#define USBD_PMA_MSC_IN         (USBD_PMA_VND_OUT + VND_DATA_FS_MAX_PACKET_SIZE)
+#define USBD_PMA_MSC_OUT        (USBD_PMA_MSC_IN + MSC_DATA_FS_MAX_PACKET_SIZE)
+#define USBD_PMA_END            (USBD_PMA_MSC_OUT + MSC_DATA_FS_MAX_PACKET_SIZE)
+
+#if (USBD_PMA_END > 1024U)
+#error "USB PMA layout does not fit in the 1 KB packet memory"
+#endif
+
 /* USER CODE END 0 */
 
 /* USER CODE BEGIN PFP */
@@ -169,6 +190,9 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
   */
 void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
 {
+  /* USER CODE BEGIN SOF */
+  TS_SofTick(hpcd->Instance->FNR & USB_FNR_FN);
+  /* USER CODE END SOF */
   USBD_LL_SOF((USBD_HandleTypeDef*)hpcd->pData);
 }
 
@@ -308,11 +332,25 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
     _Error_Handler(__FILE__, __LINE__);
   }
 
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x00 , PCD_SNG_BUF, 0x18);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x80 , PCD_SNG_BUF, 0x58);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x81 , PCD_SNG_BUF, 0xC0);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x01 , PCD_SNG_BUF, 0x110);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x82 , PCD_SNG_BUF, 0x100);
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x00 , PCD_SNG_BUF, USBD_PMA_EP0_OUT);
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x80 , PCD_SNG_BUF, USBD_PMA_EP0_IN);
+#if USBD_CDC_IN_DBL_BUF
+  /* Each packet goes in the other PMA buffer, handed over once the previous one is acknowledged */
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , CDC_IN_EP , PCD_DBL_BUF, USBD_PMA_CDC_IN0 | (USBD_PMA_CDC_IN1 << 16U));
+#else
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , CDC_IN_EP , PCD_SNG_BUF, USBD_PMA_CDC_IN0);
+#endif
+  /* OUT stays single buffered, the endpoint must NAK while the console Rx ring is full */
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , CDC_OUT_EP , PCD_SNG_BUF, USBD_PMA_CDC_OUT);
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , CDC_CMD_EP , PCD_SNG_BUF, USBD_PMA_CDC_CMD);
+#if USBD_VND_IN_DBL_BUF
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , VND_IN_EP , PCD_DBL_BUF, USBD_PMA_VND_IN0 | (USBD_PMA_VND_IN1 << 16U));
+#else
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , VND_IN_EP , PCD_SNG_BUF, USBD_PMA_VND_IN0);
+#endif
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , VND_OUT_EP , PCD_SNG_BUF, USBD_PMA_VND_OUT);
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , MSC_IN_EP , PCD_SNG_BUF, USBD_PMA_MSC_IN);
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , MSC_OUT_EP , PCD_SNG_BUF, USBD_PMA_MSC_OUT);
   return USBD_OK;
 }
 
@@ -64,6 +64,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include <string.h>
 #include "ff_gen_drv.h"
+#include "disk.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -110,7 +111,8 @@ DSTATUS USER_initialize (
 )
 {
   /* USER CODE BEGIN INIT */
-    Stat = STA_NOINIT;
+    /* Mounting takes the volume, it fails while the host has it */
+    Stat = DISK_Acquire(DISK_OWNER_FW) ? 0 : STA_NOINIT;
     return Stat;
   /* USER CODE END INIT */
 }
@@ -125,7 +127,7 @@ DSTATUS USER_status (
 )
 {
   /* USER CODE BEGIN STATUS */
-    Stat = STA_NOINIT;
+    Stat = (DISK_GetOwner() == DISK_OWNER_FW) ? 0 : STA_NOINIT;
     return Stat;
   /* USER CODE END STATUS */
 }
@@ -146,7 +148,11 @@ DRESULT USER_read (
 )
 {
   /* USER CODE BEGIN READ */
-    return RES_OK;
+    if(DISK_GetOwner() != DISK_OWNER_FW)
+    {
+        return RES_NOTRDY;
+    }
+    return DISK_Read(sector, buff, count) ? RES_OK : RES_PARERR;
   /* USER CODE END READ */
 }
 
@@ -168,7 +174,11 @@ DRESULT USER_write (
 { 
   /* USER CODE BEGIN WRITE */
   /* USER CODE HERE */
-    return RES_OK;
+    if(DISK_GetOwner() != DISK_OWNER_FW)
+    {
+        return RES_NOTRDY;
+    }
+    return DISK_Write(sector, buff, count) ? RES_OK : RES_ERROR;
   /* USER CODE END WRITE */
 }
 #endif /* _USE_WRITE == 1 */
@@ -189,6 +199,39 @@ DRESULT USER_ioctl (
 {
   /* USER CODE BEGIN IOCTL */
     DRESULT res = RES_ERROR;
+
+    if(DISK_GetOwner() != DISK_OWNER_FW)
+    {
+        return RES_NOTRDY;
+    }
+
+    switch(cmd)
+    {
+        case CTRL_SYNC:
+            res = DISK_Sync() ? RES_OK : RES_ERROR;
+            break;
+
+        case GET_SECTOR_COUNT:
+            *(DWORD *)buff = DISK_SECTOR_COUNT;
+            res = RES_OK;
+            break;
+
+        case GET_SECTOR_SIZE:
+            *(WORD *)buff = DISK_SECTOR_SIZE;
+            res = RES_OK;
+            break;
+
+        case GET_BLOCK_SIZE:
+            /* Erase block, in sectors */
+            *(DWORD *)buff = DISK_SECTORS_PER_PAGE;
+            res = RES_OK;
+            break;
+
+        default:
+            res = RES_PARERR;
+            break;
+    }
+
     return res;
   /* USER CODE END IOCTL */
 }
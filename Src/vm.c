@@ -0,0 +1,856 @@
+/**********************************************************************************************************************
+ * @file    vm.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Stack based bytecode interpreter for bus sequences
+ *
+ *          A bus sequence is written in postfix, each word takes its operands from the stack and pushes its results:
+ *
+ *              0x10 0x5A 2 0xA0 i2cw drop  10 ms  0x10 1 0xA0 i2cwr drop .
+ *
+ *          VM_Compile turns the source into bytecode inside an arena given by the caller, so running a sequence
+ *          again costs no parsing and nothing is ever allocated. Branches are compiled to absolute jumps, the
+ *          interpreter is one switch over the opcodes with the stack effects checked from a table before each one.
+ *
+ *          Nothing in here knows about the board, the bus words go through the VM_Bus_t given to VM_Run, which lets
+ *          the same file run on the host against simulated devices.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "vm.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define VM_ABORT_PERIOD         64      // Steps between two abort checks
+#define VM_DELAY_SLICE_MS       10      // Longest delay between two abort checks
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef enum
+{
+    VM_OP_HALT,
+    VM_OP_PUSH8,
+    VM_OP_PUSH16,
+    VM_OP_PUSH32,
+    VM_OP_LOAD,
+    VM_OP_STORE,
+    VM_OP_JMP,
+    VM_OP_JZ,
+    VM_OP_ADD,
+    VM_OP_SUB,
+    VM_OP_MUL,
+    VM_OP_DIV,
+    VM_OP_MOD,
+    VM_OP_AND,
+    VM_OP_OR,
+    VM_OP_XOR,
+    VM_OP_SHL,
+    VM_OP_SHR,
+    VM_OP_EQ,
+    VM_OP_NE,
+    VM_OP_LT,
+    VM_OP_GT,
+    VM_OP_LE,
+    VM_OP_GE,
+    VM_OP_NOT,
+    VM_OP_INV,
+    VM_OP_DUP,
+    VM_OP_DROP,
+    VM_OP_SWAP,
+    VM_OP_OVER,
+    VM_OP_I2CW,
+    VM_OP_I2CR,
+    VM_OP_I2CWR,
+    VM_OP_SPI,
+    VM_OP_UARTW,
+    VM_OP_UARTR,
+    VM_OP_MS,
+    VM_OP_US,
+    VM_OP_PRINT,
+    VM_OP_PRINTD,
+    NUM_OF_VM_OP,
+}VM_Op_e;
+
+// Stack effect and immediate size of an opcode
+typedef struct
+{
+    uint8_t     Pop;
+    uint8_t     Push;
+    uint8_t     Imm;
+}VM_OpInfo_t;
+
+typedef struct
+{
+    const char* pName;
+    VM_Op_e     Op;
+}VM_Word_t;
+
+typedef enum
+{
+    VM_CTRL_IF,
+    VM_CTRL_ELSE,
+    VM_CTRL_BEGIN,
+}VM_Ctrl_e;
+
+// Open control structure, Pos is the jump operand to patch or the loop start
+typedef struct
+{
+    VM_Ctrl_e   Type;
+    uint16_t    Pos;
+}VM_Ctrl_t;
+
+typedef struct
+{
+    VM_t*       pVm;
+    uint16_t    Size;
+    VM_Ctrl_t   Ctrl[VM_MAX_NESTING];
+    uint8_t     Depth;
+}VM_Compiler_t;
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static bool         VM_Emit         (VM_Compiler_t* pComp, VM_Op_e Op, int32_t Imm);
+static void         VM_Patch        (VM_Compiler_t* pComp, uint16_t Pos);
+static VM_Status_e  VM_CompileWord  (VM_Compiler_t* pComp, const char* pTok, uint16_t Len);
+static VM_Status_e  VM_CompileCtrl  (VM_Compiler_t* pComp, const char* pTok, uint16_t Len, bool* pFound);
+static bool         VM_ParseNumber  (const char* pTok, uint16_t Len, int32_t* pValue);
+static bool         VM_Delay        (const VM_Bus_t* pBus, uint32_t Ms);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+static const VM_OpInfo_t VM_OpInfo[NUM_OF_VM_OP] =
+{
+    [VM_OP_HALT]    = { 0, 0, 0 },
+    [VM_OP_PUSH8]   = { 0, 1, 1 },
+    [VM_OP_PUSH16]  = { 0, 1, 2 },
+    [VM_OP_PUSH32]  = { 0, 1, 4 },
+    [VM_OP_LOAD]    = { 0, 1, 1 },
+    [VM_OP_STORE]   = { 1, 0, 1 },
+    [VM_OP_JMP]     = { 0, 0, 2 },
+    [VM_OP_JZ]      = { 1, 0, 2 },
+    [VM_OP_ADD]     = { 2, 1, 0 },
+    [VM_OP_SUB]     = { 2, 1, 0 },
+    [VM_OP_MUL]     = { 2, 1, 0 },
+    [VM_OP_DIV]     = { 2, 1, 0 },
+    [VM_OP_MOD]     = { 2, 1, 0 },
+    [VM_OP_AND]     = { 2, 1, 0 },
+    [VM_OP_OR]      = { 2, 1, 0 },
+    [VM_OP_XOR]     = { 2, 1, 0 },
+    [VM_OP_SHL]     = { 2, 1, 0 },
+    [VM_OP_SHR]     = { 2, 1, 0 },
+    [VM_OP_EQ]      = { 2, 1, 0 },
+    [VM_OP_NE]      = { 2, 1, 0 },
+    [VM_OP_LT]      = { 2, 1, 0 },
+    [VM_OP_GT]      = { 2, 1, 0 },
+    [VM_OP_LE]      = { 2, 1, 0 },
+    [VM_OP_GE]      = { 2, 1, 0 },
+    [VM_OP_NOT]     = { 1, 1, 0 },
+    [VM_OP_INV]     = { 1, 1, 0 },
+    [VM_OP_DUP]     = { 1, 2, 0 },
+    [VM_OP_DROP]    = { 1, 0, 0 },
+    [VM_OP_SWAP]    = { 2, 2, 0 },
+    [VM_OP_OVER]    = { 2, 3, 0 },
+    [VM_OP_I2CW]    = { 2, 1, 0 },      // Plus the bytes, checked once the count is known
+    [VM_OP_I2CR]    = { 2, 2, 0 },
+    [VM_OP_I2CWR]   = { 3, 2, 0 },
+    [VM_OP_SPI]     = { 1, 1, 0 },
+    [VM_OP_UARTW]   = { 1, 1, 0 },
+    [VM_OP_UARTR]   = { 1, 1, 0 },
+    [VM_OP_MS]      = { 1, 0, 0 },
+    [VM_OP_US]      = { 1, 0, 0 },
+    [VM_OP_PRINT]   = { 1, 0, 0 },
+    [VM_OP_PRINTD]  = { 1, 0, 0 },
+};
+
+static const VM_Word_t VM_Words[] =
+{
+    { "+",      VM_OP_ADD    },
+    { "-",      VM_OP_SUB    },
+    { "*",      VM_OP_MUL    },
+    { "/",      VM_OP_DIV    },
+    { "%",      VM_OP_MOD    },
+    { "&",      VM_OP_AND    },
+    { "|",      VM_OP_OR     },
+    { "^",      VM_OP_XOR    },
+    { "<<",     VM_OP_SHL    },
+    { ">>",     VM_OP_SHR    },
+    { "==",     VM_OP_EQ     },
+    { "!=",     VM_OP_NE     },
+    { "<",      VM_OP_LT     },
+    { ">",      VM_OP_GT     },
+    { "<=",     VM_OP_LE     },
+    { ">=",     VM_OP_GE     },
+    { "not",    VM_OP_NOT    },
+    { "~",      VM_OP_INV    },
+    { "dup",    VM_OP_DUP    },
+    { "drop",   VM_OP_DROP   },
+    { "swap",   VM_OP_SWAP   },
+    { "over",   VM_OP_OVER   },
+    { "i2cw",   VM_OP_I2CW   },     // ( b1 .. bn n addr -- err )
+    { "i2cr",   VM_OP_I2CR   },     // ( n addr -- value err )
+    { "i2cwr",  VM_OP_I2CWR  },     // ( reg n addr -- value err )
+    { "spi",    VM_OP_SPI    },     // ( byte -- byte )
+    { "uartw",  VM_OP_UARTW  },     // ( byte -- err )
+    { "uartr",  VM_OP_UARTR  },     // ( timeout_ms -- byte, -1 on timeout )
+    { "ms",     VM_OP_MS     },
+    { "us",     VM_OP_US     },
+    { ".",      VM_OP_PRINT  },
+    { ".d",     VM_OP_PRINTD },
+    { "halt",   VM_OP_HALT   },
+};
+
+#define NUM_OF_VM_WORDS         (sizeof(VM_Words) / sizeof(VM_Word_t))
+
+static const char* VM_StatusName[] =
+{
+    "ok",
+    "syntax error",
+    "unbalanced control structure",
+    "code too large",
+    "stack error",
+    "bad opcode",
+    "division by zero",
+    "bad transfer length",
+    "bus not available",
+    "step budget exhausted",
+    "aborted",
+};
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Append an opcode and its immediate to the code
+  *
+  * @param  pComp           Compiler
+  * @param  Op              Opcode
+  * @param  Imm             Immediate, stored little endian on the size given by VM_OpInfo
+  *
+  * @retval bool            false if the arena is full
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static bool VM_Emit(VM_Compiler_t* pComp, VM_Op_e Op, int32_t Imm)
+{
+    VM_t*   pVm  = pComp->pVm;
+    uint8_t Size = VM_OpInfo[Op].Imm;
+    uint8_t i;
+
+    if((pVm->CodeLen + 1 + Size) > pComp->Size)
+    {
+        return false;
+    }
+
+    pVm->pCode[pVm->CodeLen++] = Op;
+
+    for(i = 0; i < Size; i++)
+    {
+        pVm->pCode[pVm->CodeLen++] = (uint8_t)((uint32_t)Imm >> (i * 8));
+    }
+
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Point a forward jump at the end of the code
+  *
+  * @param  pComp           Compiler
+  * @param  Pos             Position of the jump operand
+  *
+  * @retval None
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static void VM_Patch(VM_Compiler_t* pComp, uint16_t Pos)
+{
+    VM_t* pVm = pComp->pVm;
+
+    pVm->pCode[Pos]     = (uint8_t)pVm->CodeLen;
+    pVm->pCode[Pos + 1] = (uint8_t)(pVm->CodeLen >> 8);
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Compile if, else, then, begin, until and again
+  *
+  * @param  pComp           Compiler
+  * @param  pTok            Word, not null terminated
+  * @param  Len             Length of the word
+  * @param  pFound          Set when the word is a control word
+  *
+  * @retval VM_Status_e
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static VM_Status_e VM_CompileCtrl(VM_Compiler_t* pComp, const char* pTok, uint16_t Len, bool* pFound)
+{
+    VM_t*       pVm  = pComp->pVm;
+    VM_Ctrl_t*  pTop = (pComp->Depth != 0) ? &pComp->Ctrl[pComp->Depth - 1] : NULL;
+
+    *pFound = true;
+
+    if((Len == 2) && (memcmp(pTok, "if", 2) == 0))
+    {
+        if(pComp->Depth >= VM_MAX_NESTING)                      return VM_ERR_NESTING;
+        if(VM_Emit(pComp, VM_OP_JZ, 0) == false)                return VM_ERR_ARENA;
+        pComp->Ctrl[pComp->Depth].Type = VM_CTRL_IF;
+        pComp->Ctrl[pComp->Depth].Pos  = pVm->CodeLen - 2;
+        pComp->Depth++;
+    }
+    else if((Len == 4) && (memcmp(pTok, "else", 4) == 0))
+    {
+        if((pTop == NULL) || (pTop->Type != VM_CTRL_IF))        return VM_ERR_NESTING;
+        if(VM_Emit(pComp, VM_OP_JMP, 0) == false)               return VM_ERR_ARENA;
+        VM_Patch(pComp, pTop->Pos);
+        pTop->Type = VM_CTRL_ELSE;
+        pTop->Pos  = pVm->CodeLen - 2;
+    }
+    else if((Len == 4) && (memcmp(pTok, "then", 4) == 0))
+    {
+        if((pTop == NULL) || (pTop->Type == VM_CTRL_BEGIN))     return VM_ERR_NESTING;
+        VM_Patch(pComp, pTop->Pos);
+        pComp->Depth--;
+    }
+    else if((Len == 5) && (memcmp(pTok, "begin", 5) == 0))
+    {
+        if(pComp->Depth >= VM_MAX_NESTING)                      return VM_ERR_NESTING;
+        pComp->Ctrl[pComp->Depth].Type = VM_CTRL_BEGIN;
+        pComp->Ctrl[pComp->Depth].Pos  = pVm->CodeLen;
+        pComp->Depth++;
+    }
+    else if(((Len == 5) && (memcmp(pTok, "until", 5) == 0)) ||
+            ((Len == 5) && (memcmp(pTok, "again", 5) == 0)))
+    {
+        if((pTop == NULL) || (pTop->Type != VM_CTRL_BEGIN))     return VM_ERR_NESTING;
+        if(VM_Emit(pComp, (pTok[0] == 'u') ? VM_OP_JZ : VM_OP_JMP, pTop->Pos) == false)
+        {
+            return VM_ERR_ARENA;
+        }
+        pComp->Depth--;
+    }
+    else
+    {
+        *pFound = false;
+    }
+
+    return VM_OK;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Parse a decimal or 0x prefixed hexadecimal number, optionally negative
+  *
+  * @param  pTok            Word, not null terminated
+  * @param  Len             Length of the word
+  * @param  pValue          Parsed value
+  *
+  * @retval bool            false if the word is not a number
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static bool VM_ParseNumber(const char* pTok, uint16_t Len, int32_t* pValue)
+{
+    uint32_t    Value    = 0;
+    bool        Negative = false;
+    uint8_t     Base     = 10;
+    uint8_t     Digit;
+    char        c;
+
+    if((Len > 1) && (*pTok == '-'))
+    {
+        Negative = true;
+        pTok++;
+        Len--;
+    }
+
+    if((Len > 2) && (pTok[0] == '0') && ((pTok[1] == 'x') || (pTok[1] == 'X')))
+    {
+        Base = 16;
+        pTok += 2;
+        Len  -= 2;
+    }
+
+    for(; Len != 0; Len--)
+    {
+        c = *pTok++;
+
+        if((c >= '0') && (c <= '9'))                        Digit = c - '0';
+        else if((Base == 16) && (c >= 'a') && (c <= 'f'))   Digit = c - 'a' + 10;
+        else if((Base == 16) && (c >= 'A') && (c <= 'F'))   Digit = c - 'A' + 10;
+        else                                                return false;
+
+        if(Digit >= Base)
+        {
+            return false;
+        }
+
+        Value = (Value * Base) + Digit;
+    }
+
+    *pValue = Negative ? (int32_t)(0U - Value) : (int32_t)Value;
+    return true;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Compile one word of the source
+  *
+  * @param  pComp           Compiler
+  * @param  pTok            Word, not null terminated
+  * @param  Len             Length of the word
+  *
+  * @retval VM_Status_e
+  *
+  * @note   Single letters a to z push a variable, >a to >z pop into it.
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static VM_Status_e VM_CompileWord(VM_Compiler_t* pComp, const char* pTok, uint16_t Len)
+{
+    VM_Status_e Status;
+    VM_Op_e     Op;
+    int32_t     Value;
+    bool        Found;
+    uint8_t     i;
+
+    Status = VM_CompileCtrl(pComp, pTok, Len, &Found);
+
+    if(Found == true)
+    {
+        return Status;
+    }
+
+    if(VM_ParseNumber(pTok, Len, &Value) == true)
+    {
+        if((Value >= INT8_MIN) && (Value <= INT8_MAX))          Op = VM_OP_PUSH8;
+        else if((Value >= INT16_MIN) && (Value <= INT16_MAX))   Op = VM_OP_PUSH16;
+        else                                                    Op = VM_OP_PUSH32;
+
+        return (VM_Emit(pComp, Op, Value) == true) ? VM_OK : VM_ERR_ARENA;
+    }
+
+    if((Len == 1) && (pTok[0] >= 'a') && (pTok[0] <= 'z'))
+    {
+        return (VM_Emit(pComp, VM_OP_LOAD, pTok[0] - 'a') == true) ? VM_OK : VM_ERR_ARENA;
+    }
+
+    if((Len == 2) && (pTok[0] == '>') && (pTok[1] >= 'a') && (pTok[1] <= 'z'))
+    {
+        return (VM_Emit(pComp, VM_OP_STORE, pTok[1] - 'a') == true) ? VM_OK : VM_ERR_ARENA;
+    }
+
+    for(i = 0; i < NUM_OF_VM_WORDS; i++)
+    {
+        if((strlen(VM_Words[i].pName) == Len) && (memcmp(VM_Words[i].pName, pTok, Len) == 0))
+        {
+            return (VM_Emit(pComp, VM_Words[i].Op, 0) == true) ? VM_OK : VM_ERR_ARENA;
+        }
+    }
+
+    return VM_ERR_SYNTAX;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Wait in slices so a long delay can still be aborted
+  *
+  * @param  pBus            Board access
+  * @param  Ms              Delay
+  *
+  * @retval bool            false if aborted
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static bool VM_Delay(const VM_Bus_t* pBus, uint32_t Ms)
+{
+    uint32_t Slice;
+
+    while(Ms != 0)
+    {
+        Slice = (Ms > VM_DELAY_SLICE_MS) ? VM_DELAY_SLICE_MS : Ms;
+        pBus->DelayMs(Slice);
+        Ms -= Slice;
+
+        if((pBus->Abort != NULL) && (pBus->Abort() == true))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Compile a source into bytecode
+  *
+  * @param  pVm             Machine, reset by the call
+  * @param  pSource         Source, words separated by spaces, tabs, ';' or line ends
+  * @param  SourceLen       Length of the source, it ends earlier at a null char
+  * @param  pArena          Storage for the code, must outlive the runs
+  * @param  ArenaSize       Size of the arena
+  *
+  * @retval VM_Status_e     On error pVm->ErrPos is the offset of the faulty word in the source
+  *
+  * @note   Text between '(' and ')' is a comment.
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+VM_Status_e VM_Compile(VM_t* pVm, const char* pSource, uint16_t SourceLen, uint8_t* pArena, uint16_t ArenaSize)
+{
+    VM_Compiler_t   Comp;
+    VM_Status_e     Status = VM_OK;
+    const char*     pTok   = pSource;
+    const char*     pEnd   = pSource + SourceLen;
+    uint16_t        Len;
+
+    memset(pVm, 0, sizeof(VM_t));
+    pVm->pCode = pArena;
+    Comp.pVm   = pVm;
+    Comp.Size  = ArenaSize;
+    Comp.Depth = 0;
+
+    while(Status == VM_OK)
+    {
+        while((pTok < pEnd) && ((*pTok == ' ') || (*pTok == '\t') || (*pTok == ';') || (*pTok == '\r') || (*pTok == '\n')))
+        {
+            pTok++;
+        }
+
+        if((pTok >= pEnd) || (*pTok == '\0'))
+        {
+            break;
+        }
+
+        pVm->ErrPos = (uint16_t)(pTok - pSource);
+
+        if(*pTok == '(')
+        {
+            while((pTok < pEnd) && (*pTok != ')') && (*pTok != '\0'))
+            {
+                pTok++;
+            }
+
+            if((pTok >= pEnd) || (*pTok == '\0'))
+            {
+                Status = VM_ERR_SYNTAX;
+            }
+
+            pTok++;
+            continue;
+        }
+
+        for(Len = 0; (&pTok[Len] < pEnd) && (pTok[Len] != '\0') && (pTok[Len] != ' ')  && (pTok[Len] != '\t') &&
+                     (pTok[Len] != ';')   && (pTok[Len] != '\r') && (pTok[Len] != '\n'); Len++)
+        {
+        }
+
+        Status = VM_CompileWord(&Comp, pTok, Len);
+        pTok += Len;
+    }
+
+    if((Status == VM_OK) && (Comp.Depth != 0))
+    {
+        Status = VM_ERR_NESTING;
+    }
+
+    if((Status == VM_OK) && (VM_Emit(&Comp, VM_OP_HALT, 0) == false))
+    {
+        Status = VM_ERR_ARENA;
+    }
+
+    if(Status == VM_OK)
+    {
+        pVm->ErrPos = 0;
+    }
+
+    return Status;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Run compiled code from the start
+  *
+  * @param  pVm             Machine compiled by VM_Compile, the variables are kept from the previous run
+  * @param  pBus            Board access
+  * @param  MaxSteps        Instructions allowed before giving up, 0 for no limit
+  *
+  * @retval VM_Status_e     On error pVm->ErrPos is the code offset of the faulty instruction
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+VM_Status_e VM_Run(VM_t* pVm, const VM_Bus_t* pBus, uint32_t MaxSteps)
+{
+    const VM_OpInfo_t*  pInfo;
+    VM_Status_e         Status = VM_OK;
+    int32_t*            S      = pVm->Stack;
+    uint8_t             Buff[VM_MAX_XFER];
+    uint16_t            Pc;
+    int32_t             Imm;
+    int32_t             A;
+    int32_t             B;
+    uint8_t             Sp;
+    uint8_t             Op;
+    uint8_t             i;
+
+    pVm->Pc    = 0;
+    pVm->Sp    = 0;
+    pVm->Steps = 0;
+    Sp         = 0;
+
+    for(;;)
+    {
+        Pc = pVm->Pc;
+
+        if(Pc >= pVm->CodeLen)
+        {
+            Status = VM_ERR_OPCODE;
+            break;
+        }
+
+        Op = pVm->pCode[Pc];
+
+        if((Op >= NUM_OF_VM_OP) || ((Pc + 1 + VM_OpInfo[Op].Imm) > pVm->CodeLen))
+        {
+            Status = VM_ERR_OPCODE;
+            break;
+        }
+
+        pInfo = &VM_OpInfo[Op];
+
+        if((Sp < pInfo->Pop) || ((Sp - pInfo->Pop + pInfo->Push) > VM_STACK_SIZE))
+        {
+            Status = VM_ERR_STACK;
+            break;
+        }
+
+        // Immediates are little endian, sign extended from their size
+        Imm = 0;
+        for(i = pInfo->Imm; i != 0; i--)
+        {
+            Imm = (int32_t)(((uint32_t)Imm << 8) | pVm->pCode[Pc + i]);
+        }
+        if(pInfo->Imm == 1)             Imm = (int8_t)Imm;
+        else if(pInfo->Imm == 2)        Imm = (int16_t)Imm;
+
+        pVm->Pc += 1 + pInfo->Imm;
+        pVm->Steps++;
+
+        if((MaxSteps != 0) && (pVm->Steps > MaxSteps))
+        {
+            Status = VM_ERR_STEPS;
+            break;
+        }
+
+        if(((pVm->Steps % VM_ABORT_PERIOD) == 0) && (pBus->Abort != NULL) && (pBus->Abort() == true))
+        {
+            Status = VM_ERR_ABORT;
+            break;
+        }
+
+        // Binary operators take A then B, B on top
+        B = (Sp > 0) ? S[Sp - 1] : 0;
+        A = (Sp > 1) ? S[Sp - 2] : 0;
+
+        switch(Op)
+        {
+            case VM_OP_HALT:    pVm->Sp = Sp;       return VM_OK;
+            case VM_OP_PUSH8:
+            case VM_OP_PUSH16:
+            case VM_OP_PUSH32:  S[Sp++] = Imm;                                      break;
+            case VM_OP_LOAD:    S[Sp++] = pVm->Vars[(uint8_t)Imm % VM_NUM_VARS];    break;
+            case VM_OP_STORE:   pVm->Vars[(uint8_t)Imm % VM_NUM_VARS] = S[--Sp];    break;
+            case VM_OP_JMP:     pVm->Pc = (uint16_t)Imm;                            break;
+            case VM_OP_JZ:      if(S[--Sp] == 0) pVm->Pc = (uint16_t)Imm;           break;
+
+            case VM_OP_ADD:     S[Sp - 2] = (int32_t)((uint32_t)A + (uint32_t)B);   Sp--;   break;
+            case VM_OP_SUB:     S[Sp - 2] = (int32_t)((uint32_t)A - (uint32_t)B);   Sp--;   break;
+            case VM_OP_MUL:     S[Sp - 2] = (int32_t)((uint32_t)A * (uint32_t)B);   Sp--;   break;
+            case VM_OP_AND:     S[Sp - 2] = A & B;                                  Sp--;   break;
+            case VM_OP_OR:      S[Sp - 2] = A | B;                                  Sp--;   break;
+            case VM_OP_XOR:     S[Sp - 2] = A ^ B;                                  Sp--;   break;
+            case VM_OP_SHL:     S[Sp - 2] = (int32_t)((uint32_t)A << (B & 31));     Sp--;   break;
+            case VM_OP_SHR:     S[Sp - 2] = (int32_t)((uint32_t)A >> (B & 31));     Sp--;   break;
+            case VM_OP_EQ:      S[Sp - 2] = (A == B);                               Sp--;   break;
+            case VM_OP_NE:      S[Sp - 2] = (A != B);                               Sp--;   break;
+            case VM_OP_LT:      S[Sp - 2] = (A <  B);                               Sp--;   break;
+            case VM_OP_GT:      S[Sp - 2] = (A >  B);                               Sp--;   break;
+            case VM_OP_LE:      S[Sp - 2] = (A <= B);                               Sp--;   break;
+            case VM_OP_GE:      S[Sp - 2] = (A >= B);                               Sp--;   break;
+            case VM_OP_NOT:     S[Sp - 1] = (B == 0);                                       break;
+            case VM_OP_INV:     S[Sp - 1] = ~B;                                             break;
+
+            case VM_OP_DIV:
+            case VM_OP_MOD:
+            {
+                if(B == 0)
+                {
+                    Status = VM_ERR_DIV0;
+                }
+                else if(B == -1)
+                {
+                    // INT32_MIN / -1 does not fit
+                    S[Sp - 2] = (Op == VM_OP_DIV) ? (int32_t)(0U - (uint32_t)A) : 0;
+                }
+                else
+                {
+                    S[Sp - 2] = (Op == VM_OP_DIV) ? (A / B) : (A % B);
+                }
+                Sp--;
+                break;
+            }
+
+            case VM_OP_DUP:     S[Sp++] = B;                                                break;
+            case VM_OP_DROP:    Sp--;                                                       break;
+            case VM_OP_SWAP:    S[Sp - 1] = A;  S[Sp - 2] = B;                              break;
+            case VM_OP_OVER:    S[Sp++] = A;                                                break;
+
+            case VM_OP_I2CW:
+            {
+                // A is the byte count, the bytes are under it in order
+                if(pBus->I2CWrite == NULL)                                  { Status = VM_ERR_NO_BUS;  break; }
+                if((A < 1) || (A > VM_MAX_XFER))                            { Status = VM_ERR_ARG;     break; }
+                if(Sp < (A + 2))                                            { Status = VM_ERR_STACK;   break; }
+
+                Sp -= 2 + A;
+                for(i = 0; i < A; i++)
+                {
+                    Buff[i] = (uint8_t)S[Sp + i];
+                }
+                S[Sp++] = pBus->I2CWrite((uint8_t)B, Buff, (uint8_t)A);
+                break;
+            }
+
+            case VM_OP_I2CR:
+            case VM_OP_I2CWR:
+            {
+                // Up to 4 bytes, first byte received is the most significant
+                if((pBus->I2CRead == NULL) || (pBus->I2CWrite == NULL))     { Status = VM_ERR_NO_BUS;  break; }
+                if((A < 1) || (A > 4))                                      { Status = VM_ERR_ARG;     break; }
+
+                Sp -= pInfo->Pop;
+                Imm = 0;
+
+                if(Op == VM_OP_I2CWR)
+                {
+                    Buff[0] = (uint8_t)S[Sp];
+                    Imm = pBus->I2CWrite((uint8_t)B, Buff, 1);
+                }
+
+                if(Imm == 0)
+                {
+                    Imm = pBus->I2CRead((uint8_t)B, Buff, (uint8_t)A);
+                }
+
+                S[Sp] = 0;
+                for(i = 0; (Imm == 0) && (i < A); i++)
+                {
+                    S[Sp] = (int32_t)(((uint32_t)S[Sp] << 8) | Buff[i]);
+                }
+                S[Sp + 1] = Imm;
+                Sp += 2;
+                break;
+            }
+
+            case VM_OP_SPI:
+            {
+                if(pBus->SPIXfer == NULL)                                   { Status = VM_ERR_NO_BUS;  break; }
+
+                Buff[0] = (uint8_t)B;
+                S[Sp - 1] = (pBus->SPIXfer(Buff, 1) == 0) ? Buff[0] : -1;
+                break;
+            }
+
+            case VM_OP_UARTW:
+            {
+                if(pBus->UARTWrite == NULL)                                 { Status = VM_ERR_NO_BUS;  break; }
+
+                Buff[0] = (uint8_t)B;
+                S[Sp - 1] = pBus->UARTWrite(Buff, 1);
+                break;
+            }
+
+            case VM_OP_UARTR:
+            {
+                if(pBus->UARTRead == NULL)                                  { Status = VM_ERR_NO_BUS;  break; }
+
+                S[Sp - 1] = (pBus->UARTRead(Buff, (uint32_t)B) == 0) ? Buff[0] : -1;
+                break;
+            }
+
+            case VM_OP_MS:
+            {
+                if(pBus->DelayMs == NULL)                                   { Status = VM_ERR_NO_BUS;  break; }
+
+                Sp--;
+                if((B > 0) && (VM_Delay(pBus, (uint32_t)B) == false))
+                {
+                    Status = VM_ERR_ABORT;
+                }
+                break;
+            }
+
+            case VM_OP_US:
+            {
+                if(pBus->DelayUs == NULL)                                   { Status = VM_ERR_NO_BUS;  break; }
+
+                Sp--;
+                if(B > 0)
+                {
+                    pBus->DelayUs((uint32_t)B);
+                }
+                break;
+            }
+
+            case VM_OP_PRINT:
+            case VM_OP_PRINTD:
+            {
+                Sp--;
+                if(pBus->Print != NULL)
+                {
+                    pBus->Print(B, (Op == VM_OP_PRINT));
+                }
+                break;
+            }
+
+            default:
+            {
+                Status = VM_ERR_OPCODE;
+                break;
+            }
+        }
+
+        if(Status != VM_OK)
+        {
+            break;
+        }
+    }
+
+    pVm->Sp     = Sp;
+    pVm->ErrPos = Pc;
+    return Status;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Text of a status
+  *
+  * @param  Status          Status
+  *
+  * @retval const char*     Text
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+const char* VM_StatusStr(VM_Status_e Status)
+{
+    return ((uint32_t)Status < (sizeof(VM_StatusName) / sizeof(char*))) ? VM_StatusName[Status] : "?";
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
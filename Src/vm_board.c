@@ -0,0 +1,185 @@
+/**********************************************************************************************************************
+ * @file    vm_board.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Board side of the bus sequence interpreter
+ *
+ *          Gives the interpreter blocking access to I2C1, SPI1 and USART1 and prints to the console. A sequence runs
+ *          in the console task, so the console is busy until it ends, a break from the terminal stops it.
+ *
+ *          I2C addresses are the 8 bits ones printed by the bus scan, as for the i2c menu.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include "vm.h"
+#include "cli.h"
+#include "nOS.h"
+#include "timestamp.h"
+#include "stm32f0xx_hal.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define VM_BOARD_ARENA_SIZE     512
+#define VM_BOARD_XFER_TIMEOUT   10      // ms, per byte transfer of SPI and I2C
+#define VM_BOARD_ERR_CONTEXT    12      // Source chars shown after a compile error
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+/* Forward Declarations ---------------------------------------------------------------------------------------------*/
+
+static int32_t  VM_BOARD_I2CWrite   (uint8_t Addr, const uint8_t* pData, uint8_t Len);
+static int32_t  VM_BOARD_I2CRead    (uint8_t Addr, uint8_t* pData, uint8_t Len);
+static int32_t  VM_BOARD_SPIXfer    (uint8_t* pData, uint8_t Len);
+static int32_t  VM_BOARD_UARTWrite  (const uint8_t* pData, uint8_t Len);
+static int32_t  VM_BOARD_UARTRead   (uint8_t* pData, uint32_t TimeoutMs);
+static void     VM_BOARD_DelayMs    (uint32_t Ms);
+static void     VM_BOARD_DelayUs    (uint32_t Us);
+static void     VM_BOARD_Print      (int32_t Value, bool Hex);
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+static const VM_Bus_t VM_BOARD_Bus =
+{
+    VM_BOARD_I2CWrite,
+    VM_BOARD_I2CRead,
+    VM_BOARD_SPIXfer,
+    VM_BOARD_UARTWrite,
+    VM_BOARD_UARTRead,
+    VM_BOARD_DelayMs,
+    VM_BOARD_DelayUs,
+    VM_BOARD_Print,
+    CLI_TakeBreak,
+};
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+extern I2C_HandleTypeDef    hi2c1;
+extern SPI_HandleTypeDef    hspi1;
+extern UART_HandleTypeDef   huart1;
+
+// Static, the console task stack can not hold them
+static uint8_t  VM_BOARD_Arena[VM_BOARD_ARENA_SIZE];
+static VM_t     VM_BOARD_Vm;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+static int32_t VM_BOARD_I2CWrite(uint8_t Addr, const uint8_t* pData, uint8_t Len)
+{
+    return HAL_I2C_Master_Transmit(&hi2c1, Addr, (uint8_t*)pData, Len, VM_BOARD_XFER_TIMEOUT * Len);
+}
+
+static int32_t VM_BOARD_I2CRead(uint8_t Addr, uint8_t* pData, uint8_t Len)
+{
+    return HAL_I2C_Master_Receive(&hi2c1, Addr, pData, Len, VM_BOARD_XFER_TIMEOUT * Len);
+}
+
+static int32_t VM_BOARD_SPIXfer(uint8_t* pData, uint8_t Len)
+{
+    uint8_t Rx[VM_MAX_XFER];
+    uint8_t i;
+
+    if(HAL_SPI_TransmitReceive(&hspi1, pData, Rx, Len, VM_BOARD_XFER_TIMEOUT * Len) != HAL_OK)
+    {
+        return 1;
+    }
+
+    for(i = 0; i < Len; i++)
+    {
+        pData[i] = Rx[i];
+    }
+
+    return 0;
+}
+
+static int32_t VM_BOARD_UARTWrite(const uint8_t* pData, uint8_t Len)
+{
+    return HAL_UART_Transmit(&huart1, (uint8_t*)pData, Len, VM_BOARD_XFER_TIMEOUT * Len);
+}
+
+static int32_t VM_BOARD_UARTRead(uint8_t* pData, uint32_t TimeoutMs)
+{
+    return HAL_UART_Receive(&huart1, pData, 1, TimeoutMs);
+}
+
+static void VM_BOARD_DelayMs(uint32_t Ms)
+{
+    nOS_Sleep(Ms);
+}
+
+// Busy wait, only meant for the short settling times a sleep can not give
+static void VM_BOARD_DelayUs(uint32_t Us)
+{
+    uint64_t End;
+
+    End = TS_GetUs() + Us;
+    while(TS_GetUs() < End)
+    {
+    }
+}
+
+static void VM_BOARD_Print(int32_t Value, bool Hex)
+{
+    CLI_Printf(Hex ? "0x%lX " : "%ld ", Value);
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Compile and run a bus sequence on the board, with the report printed on the console
+  *
+  * @param  pSource         Source, not necessarily null terminated
+  * @param  SourceLen       Length of the source
+  *
+  * @retval bool            true if the sequence compiled and ran to its end
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+bool VM_BOARD_Run(const char* pSource, uint16_t SourceLen)
+{
+    VM_Status_e Status;
+    uint64_t    Start;
+    int         Context;
+    uint8_t     i;
+
+    Status = VM_Compile(&VM_BOARD_Vm, pSource, SourceLen, VM_BOARD_Arena, sizeof(VM_BOARD_Arena));
+
+    if(Status != VM_OK)
+    {
+        Context = SourceLen - VM_BOARD_Vm.ErrPos;
+        Context = (Context > VM_BOARD_ERR_CONTEXT) ? VM_BOARD_ERR_CONTEXT : Context;
+        CLI_Printf("\r\n%s at \"%.*s\"", VM_StatusStr(Status), Context, &pSource[VM_BOARD_Vm.ErrPos]);
+        return false;
+    }
+
+    CLI_TakeBreak();
+    CLI_Printf("\r\n");
+
+    Start  = TS_GetUs();
+    Status = VM_Run(&VM_BOARD_Vm, &VM_BOARD_Bus, 0);
+
+    CLI_Printf("\r\n%s, %u bytes of code, %lu steps in %lu us",
+               VM_StatusStr(Status),
+               VM_BOARD_Vm.CodeLen,
+               VM_BOARD_Vm.Steps,
+               (uint32_t)(TS_GetUs() - Start));
+
+    if(Status != VM_OK)
+    {
+        CLI_Printf(" (code offset %u)", VM_BOARD_Vm.ErrPos);
+    }
+
+    if(VM_BOARD_Vm.Sp != 0)
+    {
+        CLI_Printf("\r\nstack:");
+        for(i = 0; i < VM_BOARD_Vm.Sp; i++)
+        {
+            CLI_Printf(" 0x%lX", VM_BOARD_Vm.Stack[i]);
+        }
+    }
+
+    return (Status == VM_OK);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,250 @@
+/**********************************************************************************************************************
+ * @file    frame_host.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Host check of the COBS framing and reference of the binary protocol CRC
+ *
+ *          Built and run on the PC with "make framehost". Packets of every length around the block boundaries, all
+ *          zeros and random content are encoded, then decoded fed in random sized chunks, with garbage and broken
+ *          frames in between that must be dropped without losing the next frame. The CRC here is the bitwise
+ *          version of what the CRC unit computes, for host tools to check against.
+ *
+ *          Given the bytes of a request as hex arguments, "[id] [op] [arguments]", it prints the framed request
+ *          with its CRC instead.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "frame.h"
+#include "proto.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define HOST_MAX_PACKET     600
+#define HOST_STREAM_SIZE    (FRAME_ENCODED_SIZE(HOST_MAX_PACKET) * 4)
+#define HOST_RANDOM_RUNS    2000
+#define HOST_CRC_CHECK      0x0376E6E7  // CRC-32/MPEG-2 of "123456789"
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+static uint8_t  HOST_Packet[HOST_MAX_PACKET];
+static uint8_t  HOST_Decoded[HOST_MAX_PACKET];
+static uint8_t  HOST_Stream[HOST_STREAM_SIZE];
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+static uint32_t HOST_Crc(const uint8_t* pData, size_t Len)
+{
+    uint32_t Crc = 0xFFFFFFFF;
+    int      Bit;
+
+    while(Len-- > 0)
+    {
+        Crc ^= (uint32_t)*pData++ << 24;
+        for(Bit = 0; Bit < 8; Bit++)
+        {
+            Crc = (Crc & 0x80000000) ? ((Crc << 1) ^ 0x04C11DB7) : (Crc << 1);
+        }
+    }
+
+    return Crc;
+}
+
+/**
+  *--------------------------------------------------------------------------------------------------------------------
+  * @brief  Feed a stream to a decoder in random sized chunks and collect the frames
+  *
+  * @param  pStream         Encoded bytes
+  * @param  Len             Number of bytes
+  * @param  pFrames         Length of each frame, FRAME_DROPPED for a dropped one
+  * @param  MaxFrames       Size of pFrames
+  * @param  pLast           Receives a copy of the last decoded packet
+  *
+  * @retval int             Number of frames
+  *
+  *--------------------------------------------------------------------------------------------------------------------
+  */
+static int HOST_DecodeStream(const uint8_t* pStream, size_t Len, int32_t* pFrames, int MaxFrames, uint8_t* pLast)
+{
+    FRAME_Decoder_t Dec;
+    uint16_t        Chunk;
+    uint16_t        Used;
+    int32_t         FrameLen;
+    int             Count = 0;
+
+    FRAME_DecoderInit(&Dec, HOST_Decoded, HOST_MAX_PACKET);
+
+    while(Len > 0)
+    {
+        Chunk = (uint16_t)(1 + (rand() % 70));
+        Chunk = (Chunk > Len) ? (uint16_t)Len : Chunk;
+        Used = FRAME_Decode(&Dec, pStream, Chunk, &FrameLen);
+        pStream += Used;
+        Len -= Used;
+
+        if((FrameLen != FRAME_NONE) && (Count < MaxFrames))
+        {
+            pFrames[Count++] = FrameLen;
+            if(FrameLen > 0)
+            {
+                memcpy(pLast, HOST_Decoded, (size_t)FrameLen);
+            }
+        }
+    }
+
+    return Count;
+}
+
+// Encode then decode one packet, with a garbage frame, an empty one and a cut one in front of it
+static int HOST_RoundTrip(const uint8_t* pPacket, uint16_t Len)
+{
+    static uint8_t  Last[HOST_MAX_PACKET];
+    int32_t         Frames[8];
+    size_t          Pos = 0;
+    uint16_t        Enc;
+    int             Count;
+    uint8_t         Code;
+
+    // Code byte promising more bytes than the frame has
+    HOST_Stream[Pos++] = 0x10;
+    HOST_Stream[Pos++] = 0x41;
+    HOST_Stream[Pos++] = FRAME_DELIMITER;
+    HOST_Stream[Pos++] = FRAME_DELIMITER;
+
+    Enc = FRAME_Encode(pPacket, Len, &HOST_Stream[Pos], (uint16_t)(sizeof(HOST_Stream) - Pos));
+    if((Enc == 0) || (Enc > FRAME_ENCODED_SIZE(Len)) || (memchr(&HOST_Stream[Pos], 0, Enc - 1) != NULL))
+    {
+        printf("%4u bytes : bad encoding, %u bytes\n", Len, Enc);
+        return 1;
+    }
+    Code = HOST_Stream[Pos];
+    Pos += Enc;
+
+    Count = HOST_DecodeStream(HOST_Stream, Pos, Frames, 8, Last);
+
+    if((Count != 2) || (Frames[0] != FRAME_DROPPED) || (Frames[1] != Len) ||
+       (memcmp(Last, pPacket, Len) != 0))
+    {
+        printf("%4u bytes : %d frames, first code 0x%02X, last %d\n", Len, Count, Code,
+               (Count > 0) ? (int)Frames[Count - 1] : 0);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int HOST_Checks(void)
+{
+    FRAME_Decoder_t Dec;
+    uint8_t         Small[4];
+    int32_t         FrameLen;
+    int             Errors = 0;
+    uint16_t        Len;
+    uint16_t        Enc;
+    int             i;
+
+    if(HOST_Crc((const uint8_t*)"123456789", 9) != HOST_CRC_CHECK)
+    {
+        printf("CRC check value 0x%08X\n", HOST_Crc((const uint8_t*)"123456789", 9));
+        Errors++;
+    }
+
+    // Every length over the first block boundaries, bytes never zero, then all zeros
+    for(Len = 1; Len < 520; Len++)
+    {
+        for(i = 0; i < Len; i++)
+        {
+            HOST_Packet[i] = (uint8_t)(1 + (i % 255));
+        }
+        Errors += HOST_RoundTrip(HOST_Packet, Len);
+
+        memset(HOST_Packet, 0, Len);
+        Errors += HOST_RoundTrip(HOST_Packet, Len);
+    }
+
+    for(i = 0; i < HOST_RANDOM_RUNS; i++)
+    {
+        Len = (uint16_t)(1 + (rand() % HOST_MAX_PACKET));
+        for(Enc = 0; Enc < Len; Enc++)
+        {
+            // Zeros often enough to get short blocks
+            HOST_Packet[Enc] = (rand() % 8) ? (uint8_t)rand() : 0;
+        }
+        Errors += HOST_RoundTrip(HOST_Packet, Len);
+    }
+
+    // A frame longer than the decoder buffer is dropped, the next one still decodes
+    memset(HOST_Packet, 0x55, 8);
+    Enc = FRAME_Encode(HOST_Packet, 8, HOST_Stream, sizeof(HOST_Stream));
+    Enc += FRAME_Encode(HOST_Packet, 3, &HOST_Stream[Enc], (uint16_t)(sizeof(HOST_Stream) - Enc));
+    FRAME_DecoderInit(&Dec, Small, sizeof(Small));
+    Len = FRAME_Decode(&Dec, HOST_Stream, Enc, &FrameLen);
+    if(FrameLen != FRAME_DROPPED)
+    {
+        printf("Overflow not dropped : %d\n", (int)FrameLen);
+        Errors++;
+    }
+    FRAME_Decode(&Dec, &HOST_Stream[Len], Enc - Len, &FrameLen);
+    if(FrameLen != 3)
+    {
+        printf("Frame after an overflow : %d\n", (int)FrameLen);
+        Errors++;
+    }
+
+    if(FRAME_Encode(HOST_Packet, 8, HOST_Stream, FRAME_ENCODED_SIZE(8) - 1) != 0)
+    {
+        printf("Encoded past the output\n");
+        Errors++;
+    }
+
+    return Errors;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    uint16_t    Len;
+    uint16_t    Enc;
+    uint32_t    Crc;
+    int         i;
+    int         Errors;
+
+    if(argc > 1)
+    {
+        for(i = 1, Len = 0; (i < argc) && (Len < (PROTO_MAX_PACKET - PROTO_CRC_SIZE)); i++)
+        {
+            HOST_Packet[Len++] = (uint8_t)strtoul(argv[i], NULL, 16);
+        }
+
+        Crc = HOST_Crc(HOST_Packet, Len);
+        for(i = 0; i < PROTO_CRC_SIZE; i++)
+        {
+            HOST_Packet[Len++] = (uint8_t)(Crc >> (i * 8));
+        }
+
+        Enc = FRAME_Encode(HOST_Packet, Len, HOST_Stream, sizeof(HOST_Stream));
+        for(i = 0; i < Enc; i++)
+        {
+            printf("%02X ", HOST_Stream[i]);
+        }
+        printf("\n");
+        return 0;
+    }
+
+    Errors = HOST_Checks();
+    if(Errors != 0)
+    {
+        printf("%d framing check(s) failed\n", Errors);
+        return 1;
+    }
+
+    printf("Framing checks passed\n");
+    return 0;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
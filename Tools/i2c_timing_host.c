@@ -0,0 +1,165 @@
+/**********************************************************************************************************************
+ * @file    i2c_timing_host.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Host check of the I2C timing computation
+ *
+ *          Built and run on the PC with "make i2ctiming". Every frequency from 10 kHz to 1 MHz, over a range of rise
+ *          and fall times and kernel clocks, must keep the bus minimums and come out no faster than asked, and close
+ *          to it when the edges leave room. The presets are built at compile time as in the firmware, printed with
+ *          the frequency they give and checked against the run time function.
+ *
+ *          Given "<Hz> [rise ns] [fall ns]" it prints the TIMINGR value for the 48 MHz kernel clock instead.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "i2c_timing.h"
+#include "defines.h"
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+I2C_TIMING_PRESET(HOST_SM,  I2C_KERNEL_HZ, I2C_TIMING_SM_HZ,  I2C_RISE_NS, I2C_FALL_NS);
+I2C_TIMING_PRESET(HOST_FM,  I2C_KERNEL_HZ, I2C_TIMING_FM_HZ,  I2C_RISE_NS, I2C_FALL_NS);
+I2C_TIMING_PRESET(HOST_FMP, I2C_KERNEL_HZ, I2C_TIMING_FMP_HZ, I2C_RISE_NS, I2C_FALL_NS);
+
+// Built as the firmware table is, a non constant expression would not compile here
+static const uint32_t HOST_Presets[][2] =
+{
+    { I2C_TIMING_SM_HZ,  I2C_TIMING_VALUE(HOST_SM)  },
+    { I2C_TIMING_FM_HZ,  I2C_TIMING_VALUE(HOST_FM)  },
+    { I2C_TIMING_FMP_HZ, I2C_TIMING_VALUE(HOST_FMP) },
+};
+
+static const uint32_t HOST_Kernels[]    = { 8000000, 48000000 };
+static const uint16_t HOST_Rises[]      = { 0, 100, 300, 1000 };
+static const uint16_t HOST_Falls[]      = { 5, 50, 120, 300 };
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+// Check one value, print why it fails
+static int HOST_Check(uint32_t Kernel, uint32_t Hz, uint16_t Rise, uint16_t Fall)
+{
+    uint32_t    Timing;
+    int64_t     Clk;
+    int64_t     Tp;
+    int64_t     Low;
+    int64_t     High;
+    int64_t     Room;
+    uint32_t    Got;
+
+    Timing = I2C_TimingCompute(Kernel, Hz, Rise, Fall);
+    Clk  = I2C_TIMING_CLK(Kernel);
+    Tp   = (int64_t)((Timing >> 28) + 1) * Clk;
+    Low  = (int64_t)((Timing & 0xFF) + 1) * Tp;
+    High = (int64_t)(((Timing >> 8) & 0xFF) + 1) * Tp;
+    Got  = I2C_TimingHz(Kernel, Timing, Rise, Fall);
+
+    if((Low < I2C_TIMING_LOW_MIN(Hz)) || (High < I2C_TIMING_HIGH_MIN(Hz)))
+    {
+        printf("%lu Hz %u/%u ns : low %lld high %lld ps under the minimums\n", (unsigned long)Hz, Rise, Fall,
+               (long long)Low, (long long)High);
+        return 1;
+    }
+
+    if((int64_t)(((Timing >> 20) & 0x0F) + 1) * Tp < (int64_t)Rise * 1000 + I2C_TIMING_SU_DAT(Hz))
+    {
+        printf("%lu Hz %u/%u ns : data setup too short\n", (unsigned long)Hz, Rise, Fall);
+        return 1;
+    }
+
+    if((int64_t)((Timing >> 16) & 0x0F) * Tp < (int64_t)Fall * 1000 - I2C_TIMING_AF - 3 * Clk)
+    {
+        printf("%lu Hz %u/%u ns : data hold too short\n", (unsigned long)Hz, Rise, Fall);
+        return 1;
+    }
+
+    // Half a count of rounding either way
+    if((int64_t)I2C_TIMING_PS / Got < (int64_t)I2C_TIMING_PS / Hz - Tp)
+    {
+        printf("%lu Hz %u/%u ns : %lu Hz, faster than asked\n", (unsigned long)Hz, Rise, Fall, (unsigned long)Got);
+        return 1;
+    }
+
+    // Slower by more than the rounding of the low and high counts only when the minimums and the edges do not fit
+    // in the period, or the counters are full
+    Room = I2C_TIMING_PS / Hz - I2C_TIMING_LOW_MIN(Hz) - I2C_TIMING_HIGH_MIN(Hz) - ((int64_t)Rise + Fall) * 1000 -
+           2 * I2C_TIMING_AF - 4 * Clk - 2 * Tp;
+    if((Room > 0) && (I2C_TIMING_COUNTED(Clk, Hz, Rise, Fall) < 512 * 16 * Clk) &&
+       ((int64_t)I2C_TIMING_PS / Got > (int64_t)I2C_TIMING_PS / Hz + 2 * Tp))
+    {
+        printf("%lu Hz %u/%u ns : only %lu Hz\n", (unsigned long)Hz, Rise, Fall, (unsigned long)Got);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    uint32_t    Timing;
+    uint32_t    Hz;
+    uint16_t    Rise = I2C_RISE_NS;
+    uint16_t    Fall = I2C_FALL_NS;
+    size_t      k;
+    size_t      r;
+    size_t      f;
+    int         Errors = 0;
+    int         Count = 0;
+    size_t      i;
+
+    if(argc > 1)
+    {
+        Hz = (uint32_t)strtoul(argv[1], NULL, 0);
+        Rise = (argc > 2) ? (uint16_t)strtoul(argv[2], NULL, 0) : Rise;
+        Fall = (argc > 3) ? (uint16_t)strtoul(argv[3], NULL, 0) : Fall;
+        Timing = I2C_TimingCompute(I2C_KERNEL_HZ, Hz, Rise, Fall);
+        printf("0x%08lX, %lu Hz\n", (unsigned long)Timing,
+               (unsigned long)I2C_TimingHz(I2C_KERNEL_HZ, Timing, Rise, Fall));
+        return 0;
+    }
+
+    for(k = 0; k < sizeof(HOST_Kernels) / sizeof(HOST_Kernels[0]); k++)
+    {
+        for(r = 0; r < sizeof(HOST_Rises) / sizeof(HOST_Rises[0]); r++)
+        {
+            for(f = 0; f < sizeof(HOST_Falls) / sizeof(HOST_Falls[0]); f++)
+            {
+                for(Hz = 10000; Hz <= I2C_TIMING_FMP_HZ; Hz += 1000)
+                {
+                    Errors += HOST_Check(HOST_Kernels[k], Hz, HOST_Rises[r], HOST_Falls[f]);
+                    Count++;
+                }
+            }
+        }
+    }
+
+    for(i = 0; i < sizeof(HOST_Presets) / sizeof(HOST_Presets[0]); i++)
+    {
+        printf("%7lu Hz : 0x%08lX, %lu Hz with %u/%u ns edges\n", (unsigned long)HOST_Presets[i][0],
+               (unsigned long)HOST_Presets[i][1],
+               (unsigned long)I2C_TimingHz(I2C_KERNEL_HZ, HOST_Presets[i][1], I2C_RISE_NS, I2C_FALL_NS),
+               I2C_RISE_NS, I2C_FALL_NS);
+        if(HOST_Presets[i][1] != I2C_TimingCompute(I2C_KERNEL_HZ, HOST_Presets[i][0], I2C_RISE_NS, I2C_FALL_NS))
+        {
+            printf("Preset differs from the run time value\n");
+            Errors++;
+        }
+    }
+
+    if(Errors != 0)
+    {
+        printf("%d of %d timing check(s) failed\n", Errors, Count);
+        return 1;
+    }
+
+    printf("%d timing checks passed\n", Count);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,202 @@
+/**********************************************************************************************************************
+ * @file    payload_bench.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Host check and benchmark of the bus payload parser
+ *
+ *          Built and run on the PC with "make bench". Each case is first parsed and compared with the expected
+ *          bytes, then timed. The plain byte lists are also timed with the strtok parser the console used before,
+ *          kept here as it was, which copies the text since strtok writes into it.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "payload.h"
+#include "strfct.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define BENCH_LOOPS         100000
+#define BENCH_OUT_SIZE      4096
+#define BENCH_TEXT_SIZE     1024
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    const char*         pName;
+    const char*         pText;
+    PAYLOAD_Status_e    Status;
+    size_t              Len;
+    const char*         pExpected;      // Hex of the first bytes, NULL to skip the check
+    int                 Legacy;         // Also timed with the strtok parser
+}BENCH_Case_t;
+
+/* Local Constants --------------------------------------------------------------------------------------------------*/
+
+static const BENCH_Case_t BENCH_Cases[] =
+{
+    { "legacy",     "10 FF 0x20 7 ab",              PAYLOAD_OK,         5,      "10FF2007AB",           1 },
+    { "prefixes",   "0x1F 0b101 0d31 0B",           PAYLOAD_OK,         4,      "1F051F0B",             0 },
+    { "words",      "0x1234:16 0x1234:16le 1:32",   PAYLOAD_OK,         8,      "1234341200000001",     0 },
+    { "range",      "00-03 3-1 0-1:16",             PAYLOAD_OK,         11,     "00010203030201" "00000001", 0 },
+    { "string",     "\"ab\\r\\n\" 'x\\x41'",        PAYLOAD_OK,         6,      "61620D0A7841",         0 },
+    { "repeat",     "0xFF*4 \"ab\"*2 0-1*2",        PAYLOAD_OK,         12,     "FFFFFFFF616261620001" "0001", 0 },
+    { "page",       "0x00 0x10 0xFF*256",           PAYLOAD_OK,         258,    "0010FFFF",             0 },
+    { "fill 4K",    "0xA5*4096",                    PAYLOAD_OK,         4096,   "A5A5",                 0 },
+    { "pattern 4K", "0-0xFF*16",                    PAYLOAD_OK,         4096,   "00010203",             0 },
+    { "too wide",   "0x100",                        PAYLOAD_ERR_RANGE,  0,      NULL,                   0 },
+    { "bad width",  "1:24",                         PAYLOAD_ERR_SYNTAX, 0,      NULL,                   0 },
+    { "bad token",  "12 zz",                        PAYLOAD_ERR_SYNTAX, 1,      NULL,                   0 },
+    { "open quote", "\"abc",                        PAYLOAD_ERR_SYNTAX, 3,      NULL,                   0 },
+    { "full",       "0*4097",                       PAYLOAD_ERR_FULL,   1,      NULL,                   0 },
+};
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+static uint8_t  BENCH_Out[BENCH_OUT_SIZE];
+static char     BENCH_Text[BENCH_TEXT_SIZE];
+static char     BENCH_Copy[BENCH_TEXT_SIZE];
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+static uint64_t BENCH_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// The console parser before PAYLOAD_Parse, without its debug print
+static size_t BENCH_Legacy(char *str, uint8_t *pOut)
+{
+    size_t len;
+    size_t idx = 0;
+    char *strPtr;
+
+    strPtr = strtok(str, " ,.");
+    while(strPtr != NULL)
+    {
+        len = strlen(strPtr);
+        if(len == 1)
+        {
+            pOut[idx++] = (uint8_t)atoi(strPtr);
+        }
+        else if(len == 2)
+        {
+            pOut[idx++] = STR_atoh8(strPtr[0], strPtr[1]);
+        }
+        else if((strPtr[0] == '0') && ((strPtr[1] == 'x') || (strPtr[1] == 'X')))
+        {
+            pOut[idx++] = STR_atoh8(strPtr[2], strPtr[3]);
+        }
+        else
+        {
+            return 0;
+        }
+        strPtr = strtok(NULL, " ,.");
+    }
+
+    return idx;
+}
+
+static int BENCH_Check(const BENCH_Case_t* pCase)
+{
+    PAYLOAD_Status_e    Status;
+    size_t              Len;
+    size_t              i;
+    char                Hex[3];
+
+    Status = PAYLOAD_Parse(pCase->pText, BENCH_Out, sizeof(BENCH_Out), &Len, NULL);
+
+    if((Status != pCase->Status) || (Len != pCase->Len))
+    {
+        printf("%-12s MISMATCH %s, %zu bytes\n", pCase->pName, PAYLOAD_StatusStr(Status), Len);
+        return 1;
+    }
+
+    for(i = 0; (pCase->pExpected != NULL) && (pCase->pExpected[i * 2] != '\0'); i++)
+    {
+        snprintf(Hex, sizeof(Hex), "%02X", BENCH_Out[i]);
+        if(memcmp(Hex, &pCase->pExpected[i * 2], 2) != 0)
+        {
+            printf("%-12s MISMATCH at byte %zu : %s\n", pCase->pName, i, Hex);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static double BENCH_Time(const char* pText, int Legacy)
+{
+    uint64_t    Start;
+    size_t      Len;
+    size_t      TextLen = strlen(pText) + 1;
+    uint32_t    i;
+
+    Start = BENCH_Now();
+    for(i = 0; i < BENCH_LOOPS; i++)
+    {
+        if(Legacy)
+        {
+            memcpy(BENCH_Copy, pText, TextLen);
+            BENCH_Legacy(BENCH_Copy, BENCH_Out);
+        }
+        else
+        {
+            PAYLOAD_Parse(pText, BENCH_Out, sizeof(BENCH_Out), &Len, NULL);
+        }
+    }
+
+    return (double)(BENCH_Now() - Start) / BENCH_LOOPS;
+}
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+int main(void)
+{
+    size_t  i;
+    size_t  Pos;
+    int     Errors = 0;
+
+    printf("%-12s %8s %10s %10s\n", "case", "bytes", "parse ns", "strtok ns");
+
+    for(i = 0; i < (sizeof(BENCH_Cases) / sizeof(BENCH_Case_t)); i++)
+    {
+        Errors += BENCH_Check(&BENCH_Cases[i]);
+
+        if(BENCH_Cases[i].Status == PAYLOAD_OK)
+        {
+            printf("%-12s %8zu %10.1f", BENCH_Cases[i].pName, BENCH_Cases[i].Len, BENCH_Time(BENCH_Cases[i].pText, 0));
+            if(BENCH_Cases[i].Legacy)
+            {
+                printf(" %10.1f", BENCH_Time(BENCH_Cases[i].pText, 1));
+            }
+            printf("\n");
+        }
+    }
+
+    // A 256 bytes page typed byte by byte, the old way
+    for(i = 0, Pos = 0; i < 256; i++)
+    {
+        Pos += (size_t)snprintf(&BENCH_Text[Pos], sizeof(BENCH_Text) - Pos, "%02X ", (unsigned)i);
+    }
+    printf("%-12s %8u %10.1f %10.1f\n", "256 tokens", 256, BENCH_Time(BENCH_Text, 0), BENCH_Time(BENCH_Text, 1));
+
+    if(Errors != 0)
+    {
+        printf("%d case(s) do not parse as expected\n", Errors);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,124 @@
+/**********************************************************************************************************************
+ * @file    strfct_bench.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Host benchmark of STR_vsnprintf against the C library vsnprintf
+ *
+ *          Built and run on the PC with "make bench". Each case is first checked against the C library output, then
+ *          both are timed on the same arguments. Linked with newlib-nano the C library numbers are the ones of the
+ *          target, on Linux they are the glibc ones.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "strfct.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define BENCH_LOOPS         200000
+#define BENCH_BUFF_SIZE     128
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef size_t (*BENCH_Fct_t)(char* pOut, size_t Size, const char* pFormat, va_list va);
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+static size_t BENCH_LibVsnprintf(char* pOut, size_t Size, const char* pFormat, va_list va)
+{
+    int Len;
+
+    Len = vsnprintf(pOut, Size, pFormat, va);
+    return (Len < 0) ? 0 : (((size_t)Len < Size) ? (size_t)Len : Size - 1);
+}
+
+static size_t BENCH_Call(BENCH_Fct_t Fct, char* pOut, const char* pFormat, ...)
+{
+    va_list vaArg;
+    size_t  Len;
+
+    va_start(vaArg, pFormat);
+    Len = Fct(pOut, BENCH_BUFF_SIZE, pFormat, vaArg);
+    va_end(vaArg);
+
+    return Len;
+}
+
+static uint64_t BENCH_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// One format and its arguments, the macro keeps the argument list identical for both implementations
+#define BENCH_CASE(Name, ...)                                                                                       \
+    do                                                                                                              \
+    {                                                                                                               \
+        char     Ref[BENCH_BUFF_SIZE];                                                                              \
+        char     Out[BENCH_BUFF_SIZE];                                                                              \
+        uint64_t Start;                                                                                             \
+        uint64_t LibNs;                                                                                             \
+        uint64_t StrNs;                                                                                             \
+        uint32_t i;                                                                                                 \
+                                                                                                                    \
+        BENCH_Call(BENCH_LibVsnprintf, Ref, __VA_ARGS__);                                                           \
+        BENCH_Call(STR_vsnprintf, Out, __VA_ARGS__);                                                                \
+        if(strcmp(Ref, Out) != 0)                                                                                   \
+        {                                                                                                           \
+            printf("%-12s MISMATCH libc \"%s\" strfct \"%s\"\n", Name, Ref, Out);                                   \
+            Errors++;                                                                                               \
+        }                                                                                                           \
+                                                                                                                    \
+        Start = BENCH_Now();                                                                                        \
+        for(i = 0; i < BENCH_LOOPS; i++)  BENCH_Call(BENCH_LibVsnprintf, Out, __VA_ARGS__);                         \
+        LibNs = BENCH_Now() - Start;                                                                                \
+                                                                                                                    \
+        Start = BENCH_Now();                                                                                        \
+        for(i = 0; i < BENCH_LOOPS; i++)  BENCH_Call(STR_vsnprintf, Out, __VA_ARGS__);                              \
+        StrNs = BENCH_Now() - Start;                                                                                \
+                                                                                                                    \
+        printf("%-12s %8.1f %8.1f %7.2f\n", Name, (double)LibNs / BENCH_LOOPS, (double)StrNs / BENCH_LOOPS,         \
+               (double)LibNs / (double)StrNs);                                                                      \
+    }                                                                                                               \
+    while(0)
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+int main(void)
+{
+    int Errors = 0;
+    int Value  = 0x1234;
+
+    printf("%-12s %8s %8s %7s\n", "case", "libc ns", "strfct ns", "speedup");
+
+    BENCH_CASE("literal",   "Hello from the console, no field at all\r\n");
+    BENCH_CASE("hex byte",  "%02X ", 0xA5);
+    BENCH_CASE("hex 32",    "0x%08lX", 0xDEADBEEFUL);
+    BENCH_CASE("hex 64",    "%llx", 0x0123456789ABCDEFULL);
+    BENCH_CASE("dec 32",    "%lu", 4294967295UL);
+    BENCH_CASE("dec 64",    "%lld", -9223372036854775807LL);
+    BENCH_CASE("signed",    "%d|%+d|% d|%-6d|%06d", -42, 42, 42, -42, -42);
+    BENCH_CASE("precision", "%.5u|%8.3x|%.0d|%#x|%#X", 42U, 0xAU, 0, 0xBEEFU, 0U);
+    BENCH_CASE("star",      "%*d|%-*u|%.*s", 6, -7, 5, 9U, 3, "abcdef");
+    BENCH_CASE("string",    "%s %10s %-10s|", "I2C", "addr", "data");
+    BENCH_CASE("char",      "%c%3c%-3c|", 'a', 'b', 'c');
+    BENCH_CASE("pointer",   "%p", (void*)&Value);
+    BENCH_CASE("size",      "%zu %%", sizeof(Value));
+    BENCH_CASE("stats",     "\r\nUSB Tx : %lu bytes, %lu packets, %lu dropped", 123456UL, 1929UL, 0UL);
+
+    if(Errors != 0)
+    {
+        printf("%d case(s) do not match the C library\n", Errors);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/
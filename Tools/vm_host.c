@@ -0,0 +1,226 @@
+/**********************************************************************************************************************
+ * @file    vm_host.c
+ * @author  Simon Benoit
+ * @date    17-10-2026
+ * @brief   Host check of the bus sequence interpreter against a simulated board
+ *
+ *          Built and run on the PC with "make vmhost". The board has a 256 byte register device at I2C address 0xA0,
+ *          a loopback SPI and UART, and delays that only add to a counter. Each case compiles and runs a source and
+ *          compares the printed values and the status with the expected ones. A source given on the command line
+ *          is run on the same board instead, with its printed values shown.
+ *********************************************************************************************************************/
+
+/* Includes ---------------------------------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "vm.h"
+
+/* Local Defines ----------------------------------------------------------------------------------------------------*/
+
+#define SIM_I2C_ADDR        0xA0
+#define SIM_ARENA_SIZE      512
+#define SIM_OUT_SIZE        256
+#define SIM_MAX_STEPS       100000
+
+/* Local Typedefs ---------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    const char*     pSource;
+    VM_Status_e     Status;
+    const char*     pOutput;
+}SIM_Case_t;
+
+/* Local Variables --------------------------------------------------------------------------------------------------*/
+
+static uint8_t      SIM_Regs[256];
+static uint8_t      SIM_RegPtr;
+static uint8_t      SIM_UartByte;
+static bool         SIM_UartFull;
+static uint32_t     SIM_ElapsedUs;
+static char         SIM_Out[SIM_OUT_SIZE];
+static size_t       SIM_OutLen;
+static bool         SIM_Echo;
+
+/* Local Functions --------------------------------------------------------------------------------------------------*/
+
+// First byte written sets the register pointer, the next ones are stored from it
+static int32_t SIM_I2CWrite(uint8_t Addr, const uint8_t* pData, uint8_t Len)
+{
+    if(Addr != SIM_I2C_ADDR)
+    {
+        return 1;
+    }
+
+    SIM_RegPtr = *pData++;
+    while(--Len != 0)
+    {
+        SIM_Regs[SIM_RegPtr++] = *pData++;
+    }
+
+    return 0;
+}
+
+static int32_t SIM_I2CRead(uint8_t Addr, uint8_t* pData, uint8_t Len)
+{
+    if(Addr != SIM_I2C_ADDR)
+    {
+        return 1;
+    }
+
+    while(Len-- != 0)
+    {
+        *pData++ = SIM_Regs[SIM_RegPtr++];
+    }
+
+    return 0;
+}
+
+static int32_t SIM_SPIXfer(uint8_t* pData, uint8_t Len)
+{
+    (void)pData;
+    (void)Len;
+    return 0;
+}
+
+static int32_t SIM_UARTWrite(const uint8_t* pData, uint8_t Len)
+{
+    SIM_UartByte = pData[Len - 1];
+    SIM_UartFull = true;
+    return 0;
+}
+
+static int32_t SIM_UARTRead(uint8_t* pData, uint32_t TimeoutMs)
+{
+    if(SIM_UartFull == false)
+    {
+        SIM_ElapsedUs += TimeoutMs * 1000;
+        return 1;
+    }
+
+    *pData       = SIM_UartByte;
+    SIM_UartFull = false;
+    return 0;
+}
+
+static void SIM_DelayMs(uint32_t Ms)
+{
+    SIM_ElapsedUs += Ms * 1000;
+}
+
+static void SIM_DelayUs(uint32_t Us)
+{
+    SIM_ElapsedUs += Us;
+}
+
+static void SIM_Print(int32_t Value, bool Hex)
+{
+    char    Text[16];
+    size_t  Len;
+
+    if(Hex == true)     snprintf(Text, sizeof(Text), "%lX ", (unsigned long)(uint32_t)Value);
+    else                snprintf(Text, sizeof(Text), "%ld ", (long)Value);
+
+    Len = strlen(Text);
+    if((SIM_OutLen + Len) < SIM_OUT_SIZE)
+    {
+        memcpy(&SIM_Out[SIM_OutLen], Text, Len + 1);
+        SIM_OutLen += Len;
+    }
+
+    if(SIM_Echo == true)
+    {
+        fputs(Text, stdout);
+    }
+}
+
+static const VM_Bus_t SIM_Bus =
+{
+    SIM_I2CWrite,
+    SIM_I2CRead,
+    SIM_SPIXfer,
+    SIM_UARTWrite,
+    SIM_UARTRead,
+    SIM_DelayMs,
+    SIM_DelayUs,
+    SIM_Print,
+    NULL,
+};
+
+static const SIM_Case_t SIM_Cases[] =
+{
+    { "1 2 + 3 * .d",                                           VM_OK,          "9 "            },
+    { "-7 2 / .d  -7 2 % .d  0x7FFFFFFF 1 + .",                 VM_OK,          "-3 -1 80000000 "},
+    { "1 2 swap .d .d  5 6 over .d .d .d",                      VM_OK,          "1 2 5 6 5 "    },
+    { "3 >a a a * >b b .d",                                     VM_OK,          "9 "            },
+    { "1 if 10 else 20 then .d  0 if 10 else 20 then .d",       VM_OK,          "10 20 "        },
+    { "0 >i begin i .d i 1 + dup >i 3 == until",                VM_OK,          "0 1 2 "        },
+    { "( write two bytes ) 0x10 0x5A 0xA5 3 0xA0 i2cw .d  0x10 2 0xA0 i2cwr .d .",
+                                                                VM_OK,          "0 0 5AA5 "     },
+    { "0 1 0xA2 i2cr .d drop",                                  VM_OK,          "1 "            },
+    { "0x55 uartw drop 10 uartr . 10 uartr .d",                 VM_OK,          "55 -1 "        },
+    { "0x3C spi .",                                             VM_OK,          "3C "           },
+    { "1 0 /",                                                  VM_ERR_DIV0,    ""              },
+    { "drop",                                                   VM_ERR_STACK,   ""              },
+    { "1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17",              VM_ERR_STACK,   ""              },
+    { "1 if 2",                                                 VM_ERR_NESTING, ""              },
+    { "then",                                                   VM_ERR_NESTING, ""              },
+    { "1 2 frob",                                               VM_ERR_SYNTAX,  ""              },
+    { "begin again",                                            VM_ERR_STEPS,   ""              },
+    { "0 0xA0 i2cw",                                            VM_ERR_ARG,     ""              },
+};
+
+/* Global Functions -------------------------------------------------------------------------------------------------*/
+
+int main(int argc, char* argv[])
+{
+    static uint8_t  Arena[SIM_ARENA_SIZE];
+    VM_t            Vm;
+    VM_Status_e     Status;
+    size_t          i;
+    int             Failed = 0;
+
+    if(argc > 1)
+    {
+        SIM_Echo = true;
+        Status = VM_Compile(&Vm, argv[1], (uint16_t)strlen(argv[1]), Arena, sizeof(Arena));
+
+        if(Status == VM_OK)
+        {
+            printf("%u bytes of code\n", Vm.CodeLen);
+            Status = VM_Run(&Vm, &SIM_Bus, SIM_MAX_STEPS);
+            printf("\n%lu steps, %lu us of delays\n", (unsigned long)Vm.Steps, (unsigned long)SIM_ElapsedUs);
+        }
+
+        printf("%s at %u\n", VM_StatusStr(Status), Vm.ErrPos);
+        return (Status == VM_OK) ? 0 : 1;
+    }
+
+    for(i = 0; i < (sizeof(SIM_Cases) / sizeof(SIM_Case_t)); i++)
+    {
+        SIM_OutLen = 0;
+        SIM_Out[0] = '\0';
+
+        Status = VM_Compile(&Vm, SIM_Cases[i].pSource, (uint16_t)strlen(SIM_Cases[i].pSource), Arena, sizeof(Arena));
+        if(Status == VM_OK)
+        {
+            Status = VM_Run(&Vm, &SIM_Bus, 1000);
+        }
+
+        if((Status != SIM_Cases[i].Status) || (strcmp(SIM_Out, SIM_Cases[i].pOutput) != 0))
+        {
+            printf("FAIL  %-60s %s \"%s\"\n", SIM_Cases[i].pSource, VM_StatusStr(Status), SIM_Out);
+            Failed = 1;
+        }
+        else
+        {
+            printf("ok    %-60s %s \"%s\"\n", SIM_Cases[i].pSource, VM_StatusStr(Status), SIM_Out);
+        }
+    }
+
+    return Failed;
+}
+
+/* ------------------------------------------------------------------------------------------------------------------*/